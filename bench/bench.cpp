@@ -0,0 +1,370 @@
+#include <pch.h>
+
+#include "args.h"
+#include "corpus.h"
+#include "loader.h"
+
+/*
+End to end benchmark of the loader, run against generated mod corpuses.
+
+Usage: ohl_bench [options] [any --ohl-* args, which are passed to the loader]
+  --iterations=N     How many times to run each scenario, default 5.
+  --hotfixes=N       Only run the scenario with this many hotfixes, rather than the full sweep.
+  --output=PATH      Also write the results csv to a file.
+  --baseline=PATH    Compare against a previous results csv, failing if anything regressed.
+  --threshold=N      How many percent slower a stage may get before it counts as a regression,
+                     default 10.
+
+The corpus is written to `ohl-mods` in the current directory, which is deleted afterwards.
+*/
+
+namespace ohl::bench {
+
+// Stages which took less than this long can't regress, their timings are mostly noise
+static const double MIN_REGRESSION_MS = 1.0;
+
+/**
+ * @brief Struct holding a named scenario to run.
+ */
+struct scenario {
+    std::string name;
+    corpus_options options;
+};
+
+/**
+ * @brief Struct holding the timings of a single stage, in milliseconds.
+ */
+struct stage_result {
+    std::string scenario;
+    std::string stage;
+    double median;
+    double min;
+    double max;
+};
+
+/**
+ * @brief Gets the scenarios to run.
+ *
+ * @param only_hotfixes If set, only runs a scenario with this many hotfixes.
+ * @return The scenarios.
+ */
+static std::vector<scenario> get_scenarios(std::optional<size_t> only_hotfixes) {
+    std::vector<size_t> sizes{1000, 10000, 100000, 1000000};
+    if (only_hotfixes) {
+        sizes = {*only_hotfixes};
+    }
+
+    std::vector<scenario> scenarios{};
+    for (auto size : sizes) {
+        auto name = std::to_string(size);
+
+        corpus_options flat{};
+        flat.hotfix_count = size;
+        flat.exec_depth = 0;
+        scenarios.push_back({"flat_" + name, flat});
+
+        corpus_options nested{};
+        nested.hotfix_count = size;
+        nested.exec_depth = 3;
+        nested.exec_width = 2;
+        nested.shared_trees = 2;
+        nested.type_11_fraction = 0.05;
+        nested.news_item_count = 100;
+        scenarios.push_back({"nested_" + name, nested});
+    }
+    return scenarios;
+}
+
+/**
+ * @brief Runs a reload, and waits for it to finish.
+ *
+ * @return The reload's stats.
+ */
+static loader::reload_stats run_reload(void) {
+    loader::reload();
+    loader::get_loaded_data(true);
+
+    auto stats = loader::get_last_reload_stats();
+    if (!stats) {
+        throw std::runtime_error("Reload didn't record any stats");
+    }
+    return *stats;
+}
+
+/**
+ * @brief Converts a list of stats into the timings of each stage.
+ *
+ * @param scenario The name of the scenario.
+ * @param runs The stats of each run.
+ * @return The timings of each stage.
+ */
+static std::vector<stage_result> summarize(const std::string& scenario,
+                                           const std::vector<loader::reload_stats>& runs) {
+    using stage_ptr = loader::reload_stats::duration loader::reload_stats::*;
+    static const std::vector<std::pair<std::string, stage_ptr>> STAGES{
+        {"enumerate", &loader::reload_stats::enumerate},
+        {"cache_load", &loader::reload_stats::cache_load},
+        {"parse", &loader::reload_stats::parse},
+        {"merge", &loader::reload_stats::merge},
+        {"type_11", &loader::reload_stats::type_11},
+        {"cache_encode", &loader::reload_stats::cache_encode},
+        {"compact", &loader::reload_stats::compact},
+        {"news", &loader::reload_stats::news},
+        {"publish", &loader::reload_stats::publish},
+        {"total", &loader::reload_stats::total},
+    };
+
+    std::vector<stage_result> results{};
+    for (const auto& [stage, member] : STAGES) {
+        std::vector<double> times{};
+        for (const auto& run : runs) {
+            times.push_back(
+                std::chrono::duration<double, std::milli>(run.*member).count());
+        }
+        std::sort(times.begin(), times.end());
+
+        results.push_back({scenario, stage, times[times.size() / 2], times.front(), times.back()});
+    }
+    return results;
+}
+
+/**
+ * @brief Runs a scenario.
+ *
+ * @param dir The mods folder.
+ * @param scenario The scenario to run.
+ * @param iterations How many times to run it.
+ * @return The timings of each stage, both without and with the hotfix cache.
+ */
+static std::vector<stage_result> run_scenario(const std::filesystem::path& dir,
+                                              const scenario& scenario,
+                                              size_t iterations) {
+    auto info = generate_corpus(dir, scenario.options);
+    std::cerr << scenario.name << ": " << info.file_count << " files, " << info.hotfix_count
+              << " hotfixes (" << info.type_11_count << " type 11s), " << info.news_item_count
+              << " news items, " << info.exec_count << " execs, " << (info.bytes / 1024)
+              << "KB\n";
+
+    std::vector<loader::reload_stats> cold{};
+    std::vector<loader::reload_stats> cached{};
+    for (size_t i = 0; i < iterations; i++) {
+        // Changing every file invalidates both the hotfix cache and the loaded files
+        touch_corpus(dir);
+        auto cold_stats = run_reload();
+        if (cold_stats.from_cache || cold_stats.reused_file_count != 0) {
+            throw std::runtime_error(scenario.name + ": cold reload reused previous results");
+        }
+        cold.push_back(cold_stats);
+
+        auto cached_stats = run_reload();
+        if (!cached_stats.from_cache) {
+            throw std::runtime_error(scenario.name + ": hotfix cache was not used");
+        }
+        cached.push_back(cached_stats);
+    }
+
+    std::cerr << scenario.name << ": loaded " << cold.front().hotfix_count << " hotfixes, "
+              << cold.front().news_item_count << " news items\n";
+
+    auto results = summarize(scenario.name + "_cold", cold);
+    auto cached_results = summarize(scenario.name + "_cached", cached);
+    results.insert(results.end(), cached_results.begin(), cached_results.end());
+    return results;
+}
+
+/**
+ * @brief Writes results as csv.
+ *
+ * @param stream The stream to write to.
+ * @param results The results to write.
+ */
+static void write_csv(std::ostream& stream, const std::vector<stage_result>& results) {
+    stream << "scenario,stage,median_ms,min_ms,max_ms\n";
+    stream << std::fixed << std::setprecision(3);
+    for (const auto& result : results) {
+        stream << result.scenario << ',' << result.stage << ',' << result.median << ','
+               << result.min << ',' << result.max << '\n';
+    }
+}
+
+/**
+ * @brief Reads results written by `write_csv`.
+ *
+ * @param path The file to read.
+ * @return The results.
+ */
+static std::vector<stage_result> read_csv(const std::filesystem::path& path) {
+    std::ifstream stream{path};
+    if (!stream) {
+        throw std::runtime_error("Failed to open baseline " + path.string());
+    }
+
+    std::vector<stage_result> results{};
+    std::string line;
+    std::getline(stream, line);
+    while (std::getline(stream, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        std::istringstream line_stream{line};
+        stage_result result{};
+        std::string median;
+        std::string min;
+        std::string max;
+        if (!std::getline(line_stream, result.scenario, ',')
+            || !std::getline(line_stream, result.stage, ',')
+            || !std::getline(line_stream, median, ',') || !std::getline(line_stream, min, ',')
+            || !std::getline(line_stream, max, ',')) {
+            throw std::runtime_error("Malformed baseline line: " + line);
+        }
+        result.median = std::stod(median);
+        result.min = std::stod(min);
+        result.max = std::stod(max);
+        results.push_back(result);
+    }
+    return results;
+}
+
+/**
+ * @brief Compares results against a baseline, printing the change in each stage.
+ *
+ * @param results The new results.
+ * @param baseline The baseline results.
+ * @param threshold How many percent slower a stage may get before it counts as a regression.
+ * @return True if any stage regressed.
+ */
+static bool compare(const std::vector<stage_result>& results,
+                    const std::vector<stage_result>& baseline,
+                    double threshold) {
+    std::map<std::pair<std::string, std::string>, double> baseline_medians{};
+    for (const auto& result : baseline) {
+        baseline_medians[{result.scenario, result.stage}] = result.median;
+    }
+
+    auto regressed = false;
+    std::cerr << std::fixed << std::setprecision(1);
+    for (const auto& result : results) {
+        auto it = baseline_medians.find({result.scenario, result.stage});
+        if (it == baseline_medians.end()) {
+            continue;
+        }
+        auto old_median = it->second;
+
+        auto change = old_median > 0 ? ((result.median - old_median) * 100 / old_median) : 0.0;
+        auto is_regression = change > threshold && (result.median - old_median) > MIN_REGRESSION_MS;
+        regressed |= is_regression;
+
+        std::cerr << (is_regression ? "REGRESSED " : "          ") << result.scenario << ' '
+                  << result.stage << ": " << old_median << "ms -> " << result.median << "ms ("
+                  << std::showpos << change << std::noshowpos << "%)\n";
+    }
+    return regressed;
+}
+
+/**
+ * @brief Gets the value of a `--name=value` arg.
+ *
+ * @param arg The arg.
+ * @param name The name to look for, including the `=`.
+ * @return The value, or std::nullopt if the arg has a different name.
+ */
+static std::optional<std::string> get_arg_value(const std::string& arg, const std::string& name) {
+    if (arg.rfind(name, 0) != 0) {
+        return std::nullopt;
+    }
+    return arg.substr(name.size());
+}
+
+/**
+ * @brief Runs the benchmark.
+ *
+ * @param argc The arg count.
+ * @param argv The args.
+ * @return The exit code.
+ */
+static int run(int argc, char** argv) {
+    size_t iterations = 5;
+    std::optional<size_t> only_hotfixes = std::nullopt;
+    std::optional<std::filesystem::path> output = std::nullopt;
+    std::optional<std::filesystem::path> baseline_path = std::nullopt;
+    double threshold = 10;
+
+    for (auto i = 1; i < argc; i++) {
+        std::string arg{argv[i]};
+        if (auto value = get_arg_value(arg, "--iterations=")) {
+            iterations = std::max<size_t>(std::stoull(*value), 1);
+        } else if (auto value = get_arg_value(arg, "--hotfixes=")) {
+            only_hotfixes = std::stoull(*value);
+        } else if (auto value = get_arg_value(arg, "--output=")) {
+            output = *value;
+        } else if (auto value = get_arg_value(arg, "--baseline=")) {
+            baseline_path = *value;
+        } else if (auto value = get_arg_value(arg, "--threshold=")) {
+            threshold = std::stod(*value);
+        } else if (arg.rfind("--ohl-", 0) != 0 && arg != "--dump-hotfixes") {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            return 2;
+        }
+    }
+
+    // Read the baseline first, so a bad path doesn't waste a full run
+    std::optional<std::vector<stage_result>> baseline = std::nullopt;
+    if (baseline_path) {
+        baseline = read_csv(*baseline_path);
+    }
+
+    // Picks up any --ohl-* args. Without loader init, the mods folder and cache stay relative to
+    //  the current directory.
+    ohl::args::init(NULL);
+
+    const std::filesystem::path dir = "ohl-mods";
+    const std::filesystem::path cache = "ohl-cache.bin";
+    if (std::filesystem::exists(dir) || std::filesystem::exists(cache)) {
+        std::cerr << "Refusing to overwrite existing " << dir << " or " << cache
+                  << ", run from an empty directory\n";
+        return 2;
+    }
+
+    std::vector<stage_result> results{};
+    try {
+        for (const auto& scenario : get_scenarios(only_hotfixes)) {
+            auto scenario_results = run_scenario(dir, scenario, iterations);
+            results.insert(results.end(), scenario_results.begin(), scenario_results.end());
+        }
+    } catch (...) {
+        std::filesystem::remove_all(dir);
+        std::filesystem::remove(cache);
+        throw;
+    }
+
+    // The last reload of every scenario loads from the cache, so there's no write left pending
+    std::filesystem::remove_all(dir);
+    std::filesystem::remove(cache);
+
+    write_csv(std::cout, results);
+    if (output) {
+        std::ofstream stream{*output, std::ios::trunc};
+        write_csv(stream, results);
+        if (!stream) {
+            throw std::runtime_error("Failed to write " + output->string());
+        }
+    }
+
+    if (baseline && compare(results, *baseline, threshold)) {
+        std::cerr << "Regressions found (threshold " << threshold << "%)\n";
+        return 1;
+    }
+    return 0;
+}
+
+}  // namespace ohl::bench
+
+int main(int argc, char** argv) {
+    try {
+        return ohl::bench::run(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << "Benchmark failed: " << ex.what() << "\n";
+        return 2;
+    }
+}
@@ -0,0 +1,207 @@
+#include <pch.h>
+
+#include "corpus.h"
+
+namespace ohl::bench {
+
+// How many distinct objects each hotfix in the corpus may target, as a fraction of the hotfix
+//  count - low enough that some get overwritten, so there's something to compact
+static const size_t OBJECTS_PER_HOTFIX_DIVISOR = 4;
+// How many maps type 11s are spread across
+static const size_t TYPE_11_MAP_COUNT = 50;
+// One in this many values get non-ascii characters, if enabled
+static const size_t UNICODE_VALUE_RATE = 16;
+
+/**
+ * @brief Splits a total evenly across several slots.
+ *
+ * @param total The total to split.
+ * @param slots How many slots to split it across.
+ * @param idx The slot to get the share of.
+ * @return How much of the total the slot gets.
+ */
+static size_t share_of(size_t total, size_t slots, size_t idx) {
+    return (total / slots) + (idx < (total % slots) ? 1 : 0);
+}
+
+/**
+ * @brief Class which writes the lines of a corpus.
+ */
+class corpus_writer {
+   private:
+    const corpus_options& options;
+    std::mt19937 rng;
+    size_t object_count;
+
+    /**
+     * @brief Generates a random number in the range [0, max).
+     *
+     * @param max The exclusive upper bound.
+     * @return The number.
+     */
+    size_t random(size_t max) { return std::uniform_int_distribution<size_t>{0, max - 1}(rng); }
+
+   public:
+    corpus_info info{};
+
+    corpus_writer(const corpus_options& options)
+        : options(options),
+          rng(options.seed),
+          object_count(std::max<size_t>(options.hotfix_count / OBJECTS_PER_HOTFIX_DIVISOR, 1)) {}
+
+    /**
+     * @brief Writes a single mod file.
+     *
+     * @param path The path to write the file to.
+     * @param hotfix_count How many hotfixes to put in the file.
+     * @param news_item_count How many news items to put in the file.
+     * @param execs The paths of the files to exec, relative to the mods folder.
+     */
+    void write_file(const std::filesystem::path& path,
+                    size_t hotfix_count,
+                    size_t news_item_count,
+                    const std::vector<std::string>& execs) {
+        std::string contents{};
+
+        auto write_hotfixes = [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                auto object = std::to_string(random(this->object_count));
+                auto attr = std::to_string(random(8));
+                auto value = std::to_string(random(1000));
+                if (this->options.unicode && random(UNICODE_VALUE_RATE) == 0) {
+                    value = "Caf\xC3\xA9 \xE2\x98\x83 " + value;
+                }
+
+                if (this->options.type_11_fraction > 0
+                    && std::uniform_real_distribution<double>{}(rng)
+                           < this->options.type_11_fraction) {
+                    auto map = "Map_" + std::to_string(random(TYPE_11_MAP_COUNT)) + "_P";
+                    contents += "SparkLevelPatchEntry,(1,11,0," + map + "),/Game/Maps/" + map
+                                + "/Object_" + object + ".Object_" + object + ",Attr_" + attr
+                                + ",0,," + value + "\n";
+                    this->info.type_11_count++;
+                } else if (random(4) == 0) {
+                    contents += "SparkLevelPatchEntry,(1,1,0,Map_" + std::to_string(random(8))
+                                + "_P),/Game/Maps/Object_" + object + ".Object_" + object
+                                + ",Attr_" + attr + ",0,," + value + "\n";
+                } else {
+                    contents += "SparkPatchEntry,(1,1,0,),/Game/Gear/Balance/Balance_" + object
+                                + ".Balance_" + object + ",Attr_" + attr + ",0,," + value + "\n";
+                }
+            }
+            this->info.hotfix_count += count;
+        };
+
+        // Put the execs in the middle, so the loader has to splice them between hotfixes
+        write_hotfixes(hotfix_count / 2);
+        for (const auto& exec : execs) {
+            contents += "exec " + exec + "\n";
+        }
+        this->info.exec_count += execs.size();
+        write_hotfixes(hotfix_count - (hotfix_count / 2));
+
+        for (size_t i = 0; i < news_item_count; i++) {
+            auto header = "Synthetic News " + std::to_string(this->info.news_item_count);
+            contents += "InjectNewsItem," + header
+                        + ",https://example.com/image.png,https://example.com,Body\n";
+            this->info.news_item_count++;
+        }
+
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        out << contents;
+        if (!out) {
+            throw std::runtime_error("Failed to write " + path.string());
+        }
+
+        this->info.file_count++;
+        this->info.bytes += contents.size();
+    }
+};
+
+corpus_info generate_corpus(const std::filesystem::path& dir, const corpus_options& options) {
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    auto file_count = std::max<size_t>(options.file_count, 1);
+    auto shared_trees = std::clamp<size_t>(options.shared_trees, 1, file_count);
+
+    // Every tree has the same shape, work out the name of each node, and which it execs, up front
+    struct tree_node {
+        std::string name;
+        std::vector<std::string> children;
+    };
+    std::vector<tree_node> tree_shape{};
+    std::function<void(const std::string&, size_t)> add_node = [&](const std::string& name,
+                                                                   size_t depth) {
+        tree_node node{name, {}};
+        if (depth < options.exec_depth) {
+            for (size_t i = 0; i < options.exec_width; i++) {
+                node.children.push_back(name + "_" + std::to_string(i));
+            }
+        }
+        tree_shape.push_back(node);
+        for (const auto& child : node.children) {
+            add_node(child, depth + 1);
+        }
+    };
+    if (options.exec_depth > 0) {
+        for (size_t i = 0; i < options.exec_width; i++) {
+            add_node(std::to_string(i), 1);
+        }
+    }
+    auto tree_path = [](size_t tree, const std::string& name) {
+        return "lib/tree_" + std::to_string(tree) + "/node_" + name + ".txt";
+    };
+
+    // One tree per top level file, but each file may include some of it's neighbours' too
+    auto total_files = file_count * (1 + tree_shape.size());
+    corpus_writer writer{options};
+    size_t file_idx = 0;
+    auto write = [&](const std::filesystem::path& path, const std::vector<std::string>& execs) {
+        writer.write_file(path, share_of(options.hotfix_count, total_files, file_idx),
+                          share_of(options.news_item_count, total_files, file_idx), execs);
+        file_idx++;
+    };
+
+    for (size_t tree = 0; tree < file_count; tree++) {
+        for (const auto& node : tree_shape) {
+            std::vector<std::string> execs{};
+            for (const auto& child : node.children) {
+                execs.push_back(tree_path(tree, child));
+            }
+            write(dir / tree_path(tree, node.name), execs);
+        }
+    }
+
+    for (size_t file = 0; file < file_count; file++) {
+        std::vector<std::string> execs{};
+        if (!tree_shape.empty()) {
+            for (size_t i = 0; i < shared_trees; i++) {
+                auto tree = (file + i) % file_count;
+                for (size_t root = 0; root < options.exec_width; root++) {
+                    execs.push_back(tree_path(tree, std::to_string(root)));
+                }
+            }
+        }
+        write(dir / ("mod_" + std::to_string(file) + ".bl3hotfix"), execs);
+    }
+
+    return writer.info;
+}
+
+void touch_corpus(const std::filesystem::path& dir) {
+    // Push the time forwards rather than using now, so repeated calls always change it, however
+    //  coarse the filesystem's timestamps are
+    static auto offset = std::chrono::seconds{0};
+    offset += std::chrono::seconds{2};
+
+    auto time = std::filesystem::file_time_type::clock::now() + offset;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator{dir}) {
+        if (entry.is_regular_file()) {
+            std::filesystem::last_write_time(entry.path(), time);
+        }
+    }
+}
+
+}  // namespace ohl::bench
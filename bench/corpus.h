@@ -0,0 +1,63 @@
+#pragma once
+
+#include <pch.h>
+
+namespace ohl::bench {
+
+/**
+ * @brief Struct holding the shape of a synthetic mod corpus.
+ */
+struct corpus_options {
+    // How many hotfixes to generate in total, across every file
+    size_t hotfix_count = 100000;
+    // How many mod files to put directly in the mods folder
+    size_t file_count = 20;
+    // How many levels deep each file's exec tree goes, 0 for none
+    size_t exec_depth = 2;
+    // How many files each file in an exec tree execs
+    size_t exec_width = 2;
+    // The fraction of hotfixes which are type 11s
+    double type_11_fraction = 0.01;
+    // How many news items to inject, spread across the files
+    size_t news_item_count = 10;
+    // How many of the exec trees each top level file includes, anything past the first includes
+    //  trees which another file already did, which the loader should skip
+    size_t shared_trees = 1;
+    // If to add non-ascii characters to some hotfix values
+    bool unicode = true;
+    // The seed to generate the corpus from, the same options always give the same corpus
+    uint32_t seed = 1;
+};
+
+/**
+ * @brief Struct holding what was generated.
+ */
+struct corpus_info {
+    size_t file_count;
+    size_t hotfix_count;
+    size_t type_11_count;
+    size_t news_item_count;
+    size_t exec_count;
+    size_t bytes;
+};
+
+/**
+ * @brief Generates a synthetic mod corpus, replacing anything already in the folder.
+ * @note Top level files are written to the folder itself, the files they exec to a `lib`
+ *       subfolder, which the loader won't pick up on it's own.
+ * @note Exec paths are written relative to the folder, so it must be used as the mods folder.
+ *
+ * @param dir The folder to write the corpus to.
+ * @param options The shape of the corpus.
+ * @return What was generated.
+ */
+corpus_info generate_corpus(const std::filesystem::path& dir, const corpus_options& options);
+
+/**
+ * @brief Marks every file in the corpus as modified, so that the next reload can't reuse anything.
+ *
+ * @param dir The folder the corpus was written to.
+ */
+void touch_corpus(const std::filesystem::path& dir);
+
+}  // namespace ohl::bench
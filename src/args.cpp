@@ -5,14 +5,66 @@
 namespace ohl::args {
 TEST_SUITE_BEGIN("args");
 
+static const size_t DEFAULT_PARSE_THRESHOLD_MB = 16;
+static const size_t DEFAULT_DOWNLOAD_THREADS = 16;
+static const size_t DEFAULT_DOWNLOADS_PER_HOST = 6;
+static const size_t DEFAULT_CONNECT_TIMEOUT_S = 5;
+static const size_t DEFAULT_DOWNLOAD_TIMEOUT_S = 20;
+static const size_t DEFAULT_DOWNLOAD_BUDGET_S = 15;
+
 typedef struct {
     bool debug;
     bool dump_hotfixes;
+    bool dump_indexed;
+    size_t parse_threads;
+    size_t parse_threshold;
+    bool watch_mods;
+    bool compact_hotfixes;
+    size_t download_threads;
+    size_t downloads_per_host;
+    std::chrono::milliseconds connect_timeout;
+    std::chrono::milliseconds download_timeout;
+    std::chrono::milliseconds download_budget;
     std::filesystem::path exe_path;
     std::filesystem::path dll_path;
 } args_t;
 
-static args_t args = {false, false, "", ""};
+static args_t args = {false,
+                      false,
+                      false,
+                      1,
+                      DEFAULT_PARSE_THRESHOLD_MB * 1024 * 1024,
+                      false,
+                      false,
+                      DEFAULT_DOWNLOAD_THREADS,
+                      DEFAULT_DOWNLOADS_PER_HOST,
+                      std::chrono::seconds(DEFAULT_CONNECT_TIMEOUT_S),
+                      std::chrono::seconds(DEFAULT_DOWNLOAD_TIMEOUT_S),
+                      std::chrono::seconds(DEFAULT_DOWNLOAD_BUDGET_S),
+                      "",
+                      ""};
+
+/**
+ * @brief Gets the numeric value of an arg in the form `--name=123`.
+ *
+ * @param cmd The command line args.
+ * @param name The name of the arg, including the leading dashes and trailing equals.
+ * @return The arg's value, or std::nullopt if it wasn't specified or isn't a valid number.
+ */
+static std::optional<size_t> parse_numeric_arg(const std::string& cmd, const std::string& name) {
+    auto pos = cmd.find(name);
+    if (pos == std::string::npos) {
+        return std::nullopt;
+    }
+
+    const char* start = cmd.c_str() + pos + name.size();
+    char* end = nullptr;
+    auto value = std::strtoull(start, &end, 10);
+    if (end == start) {
+        return std::nullopt;
+    }
+    return static_cast<size_t>(value);
+}
 
 /**
  * @brief Implementation of `parse`, allowing passing in a custom string.
@@ -22,6 +74,33 @@ static args_t args = {false, false, "", ""};
 static void parse(std::string cmd) {
     args.debug = cmd.find("--ohl-debug") != std::string::npos;
     args.dump_hotfixes = cmd.find("--dump-hotfixes") != std::string::npos;
+    args.dump_indexed = cmd.find("--ohl-dump-indexed") != std::string::npos;
+
+    args.parse_threads = parse_numeric_arg(cmd, "--ohl-parse-threads=")
+                             .value_or(std::max(std::thread::hardware_concurrency(), 1u));
+    if (args.parse_threads == 0) {
+        args.parse_threads = 1;
+    }
+
+    args.parse_threshold =
+        parse_numeric_arg(cmd, "--ohl-parse-threshold=").value_or(DEFAULT_PARSE_THRESHOLD_MB)
+        * 1024 * 1024;
+
+    args.watch_mods = cmd.find("--ohl-watch-mods") != std::string::npos;
+    args.compact_hotfixes = cmd.find("--ohl-compact-hotfixes") != std::string::npos;
+
+    args.download_threads = std::max<size_t>(
+        parse_numeric_arg(cmd, "--ohl-download-threads=").value_or(DEFAULT_DOWNLOAD_THREADS), 1);
+    args.downloads_per_host = std::max<size_t>(
+        parse_numeric_arg(cmd, "--ohl-downloads-per-host=").value_or(DEFAULT_DOWNLOADS_PER_HOST),
+        1);
+
+    args.connect_timeout = std::chrono::seconds(
+        parse_numeric_arg(cmd, "--ohl-connect-timeout=").value_or(DEFAULT_CONNECT_TIMEOUT_S));
+    args.download_timeout = std::chrono::seconds(
+        parse_numeric_arg(cmd, "--ohl-download-timeout=").value_or(DEFAULT_DOWNLOAD_TIMEOUT_S));
+    args.download_budget = std::chrono::seconds(
+        parse_numeric_arg(cmd, "--ohl-download-budget=").value_or(DEFAULT_DOWNLOAD_BUDGET_S));
 }
 
 TEST_CASE("args::parse_str") {
@@ -50,6 +129,15 @@ TEST_CASE("args::parse_str") {
         REQUIRE(args.dump_hotfixes == true);
     }
 
+    SUBCASE("dump format") {
+        parse("example.exe --dump-hotfixes");
+        REQUIRE(args.dump_indexed == false);
+
+        parse("example.exe --dump-hotfixes --ohl-dump-indexed");
+        REQUIRE(args.dump_hotfixes == true);
+        REQUIRE(args.dump_indexed == true);
+    }
+
     SUBCASE("debug + dump") {
         parse("example.exe");
         REQUIRE(args.debug == false);
@@ -59,6 +147,78 @@ TEST_CASE("args::parse_str") {
         REQUIRE(args.debug == true);
         REQUIRE(args.dump_hotfixes == true);
     }
+
+    SUBCASE("parse threads") {
+        parse("example.exe");
+        REQUIRE(args.parse_threads >= 1);
+
+        parse("example.exe --ohl-parse-threads=3");
+        REQUIRE(args.parse_threads == 3);
+
+        parse("example.exe --ohl-parse-threads=0");
+        REQUIRE(args.parse_threads == 1);
+
+        parse("example.exe --ohl-parse-threads=abc");
+        REQUIRE(args.parse_threads >= 1);
+    }
+
+    SUBCASE("parse threshold") {
+        parse("example.exe");
+        REQUIRE(args.parse_threshold == DEFAULT_PARSE_THRESHOLD_MB * 1024 * 1024);
+
+        parse("example.exe --ohl-parse-threshold=64");
+        REQUIRE(args.parse_threshold == 64 * 1024 * 1024);
+
+        parse("example.exe --ohl-debug --ohl-parse-threshold=0 --dump-hotfixes");
+        REQUIRE(args.debug == true);
+        REQUIRE(args.parse_threshold == 0);
+        REQUIRE(args.dump_hotfixes == true);
+    }
+
+    SUBCASE("watch mods") {
+        parse("example.exe");
+        REQUIRE(args.watch_mods == false);
+
+        parse("example.exe --ohl-watch-mods");
+        REQUIRE(args.watch_mods == true);
+    }
+
+    SUBCASE("compact hotfixes") {
+        parse("example.exe");
+        REQUIRE(args.compact_hotfixes == false);
+
+        parse("example.exe --ohl-compact-hotfixes");
+        REQUIRE(args.compact_hotfixes == true);
+    }
+
+    SUBCASE("downloads") {
+        parse("example.exe");
+        REQUIRE(args.download_threads == DEFAULT_DOWNLOAD_THREADS);
+        REQUIRE(args.downloads_per_host == DEFAULT_DOWNLOADS_PER_HOST);
+
+        parse("example.exe --ohl-download-threads=4 --ohl-downloads-per-host=2");
+        REQUIRE(args.download_threads == 4);
+        REQUIRE(args.downloads_per_host == 2);
+
+        parse("example.exe --ohl-download-threads=0 --ohl-downloads-per-host=0");
+        REQUIRE(args.download_threads == 1);
+        REQUIRE(args.downloads_per_host == 1);
+    }
+
+    SUBCASE("timeouts") {
+        parse("example.exe");
+        REQUIRE(args.connect_timeout == std::chrono::seconds(DEFAULT_CONNECT_TIMEOUT_S));
+        REQUIRE(args.download_timeout == std::chrono::seconds(DEFAULT_DOWNLOAD_TIMEOUT_S));
+        REQUIRE(args.download_budget == std::chrono::seconds(DEFAULT_DOWNLOAD_BUDGET_S));
+
+        parse("example.exe --ohl-connect-timeout=1 --ohl-download-timeout=2 "
+              "--ohl-download-budget=3");
+        REQUIRE(args.connect_timeout == std::chrono::seconds(1));
+        REQUIRE(args.download_timeout == std::chrono::seconds(2));
+        REQUIRE(args.download_budget == std::chrono::seconds(3));
+    }
+
+    parse("");
 }
 
 void init(HMODULE this_module) {
@@ -81,6 +241,46 @@ bool dump_hotfixes(void) {
     return args.dump_hotfixes;
 }
 
+bool dump_indexed(void) {
+    return args.dump_indexed;
+}
+
+size_t parse_threads(void) {
+    return args.parse_threads;
+}
+
+size_t parse_threshold(void) {
+    return args.parse_threshold;
+}
+
+bool watch_mods(void) {
+    return args.watch_mods;
+}
+
+bool compact_hotfixes(void) {
+    return args.compact_hotfixes;
+}
+
+size_t download_threads(void) {
+    return args.download_threads;
+}
+
+size_t downloads_per_host(void) {
+    return args.downloads_per_host;
+}
+
+std::chrono::milliseconds connect_timeout(void) {
+    return args.connect_timeout;
+}
+
+std::chrono::milliseconds download_timeout(void) {
+    return args.download_timeout;
+}
+
+std::chrono::milliseconds download_budget(void) {
+    return args.download_budget;
+}
+
 std::filesystem::path exe_path(void) {
     return args.exe_path;
 }
@@ -25,6 +25,82 @@ bool debug(void);
  */
 bool dump_hotfixes(void);
 
+/**
+ * @brief Checks if to dump hotfixes in the indexed utf8 format, rather than the default utf16 one.
+ * @note Only has an effect if dumping hotfixes.
+ *
+ * @return True if to use the indexed format, false otherwise.
+ */
+bool dump_indexed(void);
+
+/**
+ * @brief Gets how many threads to use when loading mod files, and when parsing a single large mod
+ *        file.
+ * @note Defaults to the hardware thread count, always at least 1.
+ *
+ * @return The thread count.
+ */
+size_t parse_threads(void);
+
+/**
+ * @brief Gets the minimum size of a mod file before it's parsed in parallel chunks.
+ *
+ * @return The threshold, in bytes.
+ */
+size_t parse_threshold(void);
+
+/**
+ * @brief Checks if to watch the mods folder for changes, and parse them in the background.
+ *
+ * @return True if to watch the mods folder, false otherwise.
+ */
+bool watch_mods(void);
+
+/**
+ * @brief Checks if to drop hotfixes which are fully overwritten by later ones.
+ *
+ * @return True if to compact hotfixes, false otherwise.
+ */
+bool compact_hotfixes(void);
+
+/**
+ * @brief Gets the maximum amount of url mods to download at once.
+ * @note Always at least 1.
+ *
+ * @return The download thread count.
+ */
+size_t download_threads(void);
+
+/**
+ * @brief Gets the maximum amount of url mods to download at once from a single host.
+ * @note Always at least 1.
+ *
+ * @return The per host download count.
+ */
+size_t downloads_per_host(void);
+
+/**
+ * @brief Gets how long to wait for a connection when downloading a url mod.
+ *
+ * @return The connect timeout.
+ */
+std::chrono::milliseconds connect_timeout(void);
+
+/**
+ * @brief Gets how long to let a single url mod download for in total.
+ *
+ * @return The download timeout.
+ */
+std::chrono::milliseconds download_timeout(void);
+
+/**
+ * @brief Gets how long a reload waits for all url mods to download, before falling back to cached
+ *        copies.
+ *
+ * @return The download budget.
+ */
+std::chrono::milliseconds download_budget(void);
+
 /**
  * @brief Gets the path to the current exe.
  *
@@ -0,0 +1,902 @@
+#include <pch.h>
+
+#include <doctest/doctest.h>
+
+#include "cache.h"
+#include "util.h"
+#include "version.h"
+
+namespace ohl::cache {
+TEST_SUITE_BEGIN("cache");
+
+using ohl::loader::hotfix;
+using ohl::loader::news_item;
+
+static constexpr std::string_view MAGIC = "OHLCACHE";
+static const uint32_t FORMAT_VERSION = 1;
+static constexpr std::string_view URL_MAGIC = "OHLURLCA";
+static const uint32_t URL_FORMAT_VERSION = 2;
+
+#pragma region Stamps
+
+int64_t get_mtime(const std::filesystem::path& path) {
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        return 0;
+    }
+    return mtime.time_since_epoch().count();
+}
+
+file_stamp stamp_contents(const std::filesystem::path& path,
+                          int64_t mtime,
+                          std::string_view contents) {
+    return {path.string(), true, contents.size(), mtime, ohl::util::hash_bytes(contents)};
+}
+
+file_stamp stamp_missing(const std::filesystem::path& path) {
+    return {path.string(), false, 0, 0, 0};
+}
+
+std::optional<file_stamp> stamp_file(const std::filesystem::path& path) {
+    if (!std::filesystem::exists(path)) {
+        return stamp_missing(path);
+    }
+
+    auto mtime = get_mtime(path);
+    ohl::util::mapped_file mapping{path};
+    if (!mapping.is_open()) {
+        return std::nullopt;
+    }
+    return stamp_contents(path, mtime, mapping.view());
+}
+
+TEST_CASE("cache::stamp_file") {
+    const auto path = std::filesystem::temp_directory_path() / "ohl_stamp_test.bl3hotfix";
+
+    std::filesystem::remove(path);
+    auto missing = stamp_file(path);
+    REQUIRE(missing.has_value());
+    CHECK(*missing == stamp_missing(path));
+
+    {
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        out << "SparkPatchEntry,(1,1,0,),/Some/Hotfix\n";
+    }
+    auto first = stamp_file(path);
+    REQUIRE(first.has_value());
+    CHECK(first->exists);
+    CHECK(first->size == 38);
+    CHECK(first->mtime == get_mtime(path));
+    CHECK(*first == *stamp_file(path));
+    CHECK(*first != *missing);
+
+    {
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        out << "SparkPatchEntry,(1,1,0,),/Some/Hotfiy\n";
+    }
+    auto second = stamp_file(path);
+    REQUIRE(second.has_value());
+    CHECK(second->size == first->size);
+    CHECK(second->hash != first->hash);
+
+    std::filesystem::remove(path);
+}
+
+#pragma endregion
+
+#pragma region Encoding
+
+/**
+ * @brief Helper class for building up binary data.
+ */
+class writer {
+   public:
+    std::string buffer;
+
+    template <typename T>
+    void put(T value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        this->buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void put_str(std::string_view str) {
+        this->put<uint32_t>(static_cast<uint32_t>(str.size()));
+        this->buffer.append(str);
+    }
+};
+
+/**
+ * @brief Helper class for reading binary data, which throws if it runs off the end.
+ */
+class reader {
+   private:
+    std::string_view data;
+
+   public:
+    reader(std::string_view data) : data(data) {}
+
+    template <typename T>
+    T get(void) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (this->data.size() < sizeof(T)) {
+            throw std::runtime_error("Cache file is truncated");
+        }
+        T value;
+        memcpy(&value, this->data.data(), sizeof(T));
+        this->data.remove_prefix(sizeof(T));
+        return value;
+    }
+
+    std::string_view get_str(void) {
+        auto size = this->get<uint32_t>();
+        return this->get_raw(size);
+    }
+
+    std::string_view get_raw(size_t size) {
+        if (this->data.size() < size) {
+            throw std::runtime_error("Cache file is truncated");
+        }
+        auto str = this->data.substr(0, size);
+        this->data.remove_prefix(size);
+        return str;
+    }
+
+    std::string_view remaining(void) const { return this->data; }
+};
+
+std::string encode(const cached_data& data) {
+    writer payload{};
+
+    payload.put<uint32_t>(static_cast<uint32_t>(data.folder_listing.size()));
+    for (const auto& file : data.folder_listing) {
+        payload.put_str(file);
+    }
+
+    payload.put<uint32_t>(static_cast<uint32_t>(data.inputs.size()));
+    for (const auto& input : data.inputs) {
+        payload.put_str(input.path);
+        payload.put<uint8_t>(input.exists);
+        payload.put<uint64_t>(input.size);
+        payload.put<int64_t>(input.mtime);
+        payload.put<uint64_t>(input.hash);
+    }
+
+    payload.put<uint32_t>(static_cast<uint32_t>(data.file_order.size()));
+    for (const auto& name : data.file_order) {
+        payload.put_str(name);
+    }
+
+    payload.put<uint32_t>(static_cast<uint32_t>(data.hotfixes.size()));
+    for (const auto& hotfix : data.hotfixes) {
+        payload.put_str(hotfix.get_key());
+        payload.put_str(hotfix.value);
+    }
+
+    payload.put<uint32_t>(static_cast<uint32_t>(data.news_items.size()));
+    for (const auto& news_item : data.news_items) {
+        payload.put_str(news_item.header);
+        payload.put_str(news_item.image_url);
+        payload.put_str(news_item.article_url);
+        payload.put_str(news_item.body);
+    }
+
+    writer header{};
+    header.buffer.append(MAGIC);
+    header.put<uint32_t>(FORMAT_VERSION);
+    header.put_str(VERSION_STRING);
+    header.put<uint64_t>(payload.buffer.size());
+    header.put<uint64_t>(ohl::util::hash_bytes(payload.buffer));
+
+    return header.buffer + payload.buffer;
+}
+
+cached_data decode(std::string_view encoded, std::pmr::memory_resource* resource) {
+    reader header{encoded};
+    if (header.get_raw(MAGIC.size()) != MAGIC) {
+        throw std::runtime_error("Not a cache file");
+    }
+    if (header.get<uint32_t>() != FORMAT_VERSION || header.get_str() != VERSION_STRING) {
+        throw std::runtime_error("Cache file is from a different version");
+    }
+    auto payload_size = header.get<uint64_t>();
+    auto payload_hash = header.get<uint64_t>();
+    if (header.remaining().size() != payload_size
+        || ohl::util::hash_bytes(header.remaining()) != payload_hash) {
+        throw std::runtime_error("Cache file is corrupt");
+    }
+
+    reader payload{header.remaining()};
+    cached_data data{resource};
+
+    auto listing_count = payload.get<uint32_t>();
+    for (uint32_t i = 0; i < listing_count; i++) {
+        data.folder_listing.emplace_back(payload.get_str());
+    }
+
+    auto input_count = payload.get<uint32_t>();
+    for (uint32_t i = 0; i < input_count; i++) {
+        file_stamp input{};
+        input.path = payload.get_str();
+        input.exists = payload.get<uint8_t>() != 0;
+        input.size = payload.get<uint64_t>();
+        input.mtime = payload.get<int64_t>();
+        input.hash = payload.get<uint64_t>();
+        data.inputs.push_back(std::move(input));
+    }
+
+    auto file_order_count = payload.get<uint32_t>();
+    for (uint32_t i = 0; i < file_order_count; i++) {
+        data.file_order.emplace_back(payload.get_str());
+    }
+
+    auto hotfix_count = payload.get<uint32_t>();
+    for (uint32_t i = 0; i < hotfix_count; i++) {
+        auto key = payload.get_str();
+        auto value = payload.get_str();
+        data.hotfixes.emplace_back(key, value);
+    }
+
+    auto news_count = payload.get<uint32_t>();
+    for (uint32_t i = 0; i < news_count; i++) {
+        auto header_str = payload.get_str();
+        auto image_url = payload.get_str();
+        auto article_url = payload.get_str();
+        auto body = payload.get_str();
+        data.news_items.emplace_back(header_str, image_url, article_url, body);
+    }
+
+    if (!payload.remaining().empty()) {
+        throw std::runtime_error("Cache file has trailing data");
+    }
+
+    return data;
+}
+
+TEST_CASE("cache::encode - cache::decode round trip") {
+    cached_data data{};
+    data.folder_listing = {"ohl-mods\\a.bl3hotfix", "ohl-mods\\b.txt"};
+    data.inputs = {
+        {"ohl-mods\\a.bl3hotfix", true, 1234, 5678, 0x0123456789ABCDEF},
+        {"ohl-mods\\b.txt", true, 0, -1, 0},
+        {"ohl-mods\\missing.bl3hotfix", false, 0, 0, 0},
+    };
+    data.file_order = {"a.bl3hotfix", "b.txt"};
+    data.hotfixes = {
+        {"SparkPatchEntry", "(1,1,0,),/Some/Hotfix"},
+        {"SparkSomeNewEntry", u8"(1,1,0,),/Game/Name,PartName,0,,Cú Chulainn"},
+        {"", ""},
+    };
+    data.news_items = {
+        {"Header", "image.png", "https://example.com", "Body,\nwith newlines"},
+        {},
+    };
+
+    auto encoded = encode(data);
+
+    ohl::util::arena test_arena{};
+    auto decoded = decode(encoded, &test_arena);
+    CHECK(decoded.folder_listing == data.folder_listing);
+    CHECK(decoded.inputs == data.inputs);
+    CHECK(decoded.file_order == data.file_order);
+    CHECK(ITERABLE_EQUAL(decoded.hotfixes, data.hotfixes));
+    CHECK(ITERABLE_EQUAL(decoded.news_items, data.news_items));
+    CHECK(decoded.hotfixes[0].value.get_allocator().resource() == &test_arena);
+
+    SUBCASE("corrupt") {
+        auto corrupt = encoded;
+        corrupt[corrupt.size() / 2] ^= 0x20;
+        CHECK_THROWS_AS(decode(corrupt, &test_arena), std::runtime_error);
+    }
+
+    SUBCASE("truncated") {
+        for (auto size : {(size_t)0, (size_t)4, MAGIC.size() + 2, encoded.size() - 1}) {
+            CHECK_THROWS_AS(decode(std::string_view(encoded).substr(0, size), &test_arena),
+                            std::runtime_error);
+        }
+    }
+
+    SUBCASE("trailing data") {
+        CHECK_THROWS_AS(decode(encoded + "extra", &test_arena), std::runtime_error);
+    }
+
+    SUBCASE("wrong magic") {
+        auto wrong = encoded;
+        wrong[0] = 'X';
+        CHECK_THROWS_AS(decode(wrong, &test_arena), std::runtime_error);
+    }
+}
+
+#pragma endregion
+
+#pragma region Files
+
+/**
+ * @brief Replaces a file with a fully written temporary one.
+ * @note Throws a runtime error on failure, after removing the temporary file.
+ *
+ * @param temp_path The temporary file.
+ * @param path The file to replace.
+ */
+static void replace_file(const std::filesystem::path& temp_path,
+                         const std::filesystem::path& path) {
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        throw std::runtime_error("Couldn't replace " + path.string());
+    }
+}
+
+void write(const std::filesystem::path& path, std::string_view encoded) {
+    auto temp_path = path;
+    temp_path += ".tmp";
+
+    {
+        std::ofstream out{temp_path, std::ios::binary | std::ios::trunc};
+        if (!out.is_open()) {
+            throw std::runtime_error("Couldn't open " + temp_path.string());
+        }
+        out.write(encoded.data(), encoded.size());
+        if (!out.good()) {
+            throw std::runtime_error("Couldn't write to " + temp_path.string());
+        }
+    }
+
+    replace_file(temp_path, path);
+}
+
+std::optional<cached_data> load(const std::filesystem::path& path,
+                                const std::vector<std::string>& folder_listing,
+                                std::pmr::memory_resource* resource) {
+    std::optional<cached_data> data{};
+    {
+        ohl::util::mapped_file mapping{path};
+        if (!mapping.is_open()) {
+            LOGD << "[OHL] No hotfix cache found";
+            return std::nullopt;
+        }
+
+        try {
+            data.emplace(decode(mapping.view(), resource));
+        } catch (const std::runtime_error& ex) {
+            LOGI << "[OHL] Ignoring invalid hotfix cache: " << ex.what();
+            return std::nullopt;
+        }
+    }
+
+    if (data->folder_listing != folder_listing) {
+        LOGD << "[OHL] Hotfix cache is out of date: mods folder changed";
+        return std::nullopt;
+    }
+
+    for (const auto& input : data->inputs) {
+        auto current = stamp_file(input.path);
+        if (!current || *current != input) {
+            LOGD << "[OHL] Hotfix cache is out of date: " << input.path << " changed";
+            return std::nullopt;
+        }
+    }
+
+    return data;
+}
+
+TEST_CASE("cache::load") {
+    const auto dir = std::filesystem::temp_directory_path() / "ohl_cache_test";
+    const auto cache_path = dir / "cache.bin";
+    const auto mod_a = dir / "a.bl3hotfix";
+    const auto mod_b = dir / "b.bl3hotfix";
+    const auto missing = dir / "missing.bl3hotfix";
+
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    auto write_file = [](const std::filesystem::path& path, const std::string& contents) {
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        out << contents;
+    };
+    write_file(mod_a, "SparkPatchEntry,(1,1,0,),/Some/Hotfix\n");
+    write_file(mod_b, "exec missing.bl3hotfix\n");
+
+    cached_data data{};
+    data.folder_listing = {mod_a.string(), mod_b.string()};
+    data.inputs = {*stamp_file(mod_a), *stamp_file(mod_b), *stamp_file(missing)};
+    data.file_order = {"a.bl3hotfix"};
+    data.hotfixes = {{"SparkPatchEntry", "(1,1,0,),/Some/Hotfix"}};
+
+    write(cache_path, encode(data));
+    CHECK(std::filesystem::exists(cache_path));
+    CHECK(!std::filesystem::exists(std::filesystem::path(cache_path) += ".tmp"));
+
+    SUBCASE("up to date") {
+        auto loaded = load(cache_path, data.folder_listing, std::pmr::get_default_resource());
+        REQUIRE(loaded.has_value());
+        CHECK(ITERABLE_EQUAL(loaded->hotfixes, data.hotfixes));
+        CHECK(loaded->file_order == data.file_order);
+    }
+
+    SUBCASE("no cache") {
+        std::filesystem::remove(cache_path);
+        CHECK(!load(cache_path, data.folder_listing, std::pmr::get_default_resource()));
+    }
+
+    SUBCASE("corrupt cache") {
+        write_file(cache_path, "OHLCACHE but not really");
+        CHECK(!load(cache_path, data.folder_listing, std::pmr::get_default_resource()));
+    }
+
+    SUBCASE("folder changed") {
+        const std::vector<std::string> new_listing = {mod_a.string()};
+        CHECK(!load(cache_path, new_listing, std::pmr::get_default_resource()));
+    }
+
+    SUBCASE("file changed") {
+        write_file(mod_a, "SparkPatchEntry,(1,1,0,),/Some/Other/Hotfix\n");
+        CHECK(!load(cache_path, data.folder_listing, std::pmr::get_default_resource()));
+    }
+
+    SUBCASE("missing file created") {
+        write_file(missing, "");
+        CHECK(!load(cache_path, data.folder_listing, std::pmr::get_default_resource()));
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+#pragma endregion
+
+#pragma region Url cache
+
+/**
+ * @brief Gets the path a url's cached response is stored at.
+ *
+ * @param dir The cache folder.
+ * @param url The url.
+ * @return The path to the cache file.
+ */
+static std::filesystem::path get_url_entry_path(const std::filesystem::path& dir,
+                                                const std::string& url) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+
+    auto hash = ohl::util::hash_bytes(url);
+    std::string name(16, '0');
+    for (auto it = name.rbegin(); it != name.rend(); it++) {
+        *it = HEX_DIGITS[hash & 0xF];
+        hash >>= 4;
+    }
+    return dir / (name + ".bin");
+}
+
+// Suffixes each writer's temp file. The same url may be fetched twice at once, if a download which
+//  was given up on is still running when the next reload starts, so they can't share one.
+static std::atomic<uint64_t> next_url_temp_id{0};
+
+/**
+ * @brief Class which writes a response to the url cache as it arrives.
+ * @note Url cache files store the body first, since the headers we care about are only known
+ *       once it's done, and the size and hash are filled in afterwards.
+ */
+class url_entry_writer {
+   private:
+    // Offset of the body size and hash, which get filled in last
+    static constexpr std::streamoff SIZE_OFFSET = URL_MAGIC.size() + sizeof(uint32_t);
+    static constexpr std::streamoff PAYLOAD_OFFSET = SIZE_OFFSET + 2 * sizeof(uint64_t);
+
+    std::filesystem::path path;
+    std::filesystem::path temp_path;
+    std::ofstream out;
+    uint64_t body_size;
+    bool committed;
+
+   public:
+    url_entry_writer(const std::filesystem::path& path)
+        : path(path),
+          temp_path(std::filesystem::path(path)
+                    += "." + std::to_string(next_url_temp_id++) + ".tmp"),
+          body_size(0),
+          committed(false) {
+        this->out.open(this->temp_path, std::ios::binary | std::ios::trunc);
+        if (!this->out.is_open()) {
+            throw std::runtime_error("Couldn't open " + this->temp_path.string());
+        }
+
+        writer header{};
+        header.buffer.append(URL_MAGIC);
+        header.put<uint32_t>(URL_FORMAT_VERSION);
+        header.put<uint64_t>(0);
+        header.put<uint64_t>(0);
+        this->out.write(header.buffer.data(), header.buffer.size());
+    }
+
+    ~url_entry_writer() {
+        if (!this->committed) {
+            this->out.close();
+            std::error_code ec;
+            std::filesystem::remove(this->temp_path, ec);
+        }
+    }
+
+    url_entry_writer(const url_entry_writer&) = delete;
+    url_entry_writer& operator=(const url_entry_writer&) = delete;
+
+    /**
+     * @brief Appends the next chunk of the body.
+     * @note Throws a runtime error if it couldn't be written.
+     *
+     * @param chunk The chunk to append.
+     */
+    void append(std::string_view chunk) {
+        this->out.write(chunk.data(), chunk.size());
+        if (!this->out.good()) {
+            throw std::runtime_error("Couldn't write to " + this->temp_path.string());
+        }
+        this->body_size += chunk.size();
+    }
+
+    /**
+     * @brief Finishes writing the response, and moves it into place.
+     * @note Throws a runtime error if it couldn't be written.
+     *
+     * @param url The url the response is for.
+     * @param etag The response's etag.
+     * @param last_modified The response's last modified time.
+     */
+    void commit(std::string_view url, std::string_view etag, std::string_view last_modified) {
+        writer trailer{};
+        trailer.put_str(url);
+        trailer.put_str(etag);
+        trailer.put_str(last_modified);
+        this->append(trailer.buffer);
+        this->body_size -= trailer.buffer.size();
+        this->out.close();
+
+        uint64_t payload_hash;
+        {
+            // Read the payload back out through a mapping, rather than keeping a copy around
+            ohl::util::mapped_file mapping{this->temp_path};
+            if (!mapping.is_open()) {
+                throw std::runtime_error("Couldn't read back " + this->temp_path.string());
+            }
+            payload_hash = ohl::util::hash_bytes(mapping.view().substr(PAYLOAD_OFFSET));
+        }
+
+        {
+            std::fstream file{this->temp_path, std::ios::binary | std::ios::in | std::ios::out};
+            writer header{};
+            header.put<uint64_t>(this->body_size);
+            header.put<uint64_t>(payload_hash);
+            file.seekp(SIZE_OFFSET);
+            file.write(header.buffer.data(), header.buffer.size());
+            if (!file.good()) {
+                throw std::runtime_error("Couldn't write to " + this->temp_path.string());
+            }
+        }
+
+        replace_file(this->temp_path, this->path);
+        this->committed = true;
+    }
+};
+
+/**
+ * @brief Decodes a cached response.
+ * @note Throws a runtime error if the data is corrupt.
+ *
+ * @param encoded The encoded bytes.
+ * @return The decoded response.
+ */
+static url_entry decode_url_entry(std::string_view encoded) {
+    reader header{encoded};
+    if (header.get_raw(URL_MAGIC.size()) != URL_MAGIC) {
+        throw std::runtime_error("Not a url cache file");
+    }
+    if (header.get<uint32_t>() != URL_FORMAT_VERSION) {
+        throw std::runtime_error("Cache file is from a different version");
+    }
+    auto body_size = header.get<uint64_t>();
+    auto payload_hash = header.get<uint64_t>();
+    if (ohl::util::hash_bytes(header.remaining()) != payload_hash) {
+        throw std::runtime_error("Cache file is corrupt");
+    }
+
+    reader payload{header.remaining()};
+    url_entry entry{};
+    entry.body = payload.get_raw(body_size);
+    entry.url = payload.get_str();
+    entry.etag = payload.get_str();
+    entry.last_modified = payload.get_str();
+
+    if (!payload.remaining().empty()) {
+        throw std::runtime_error("Cache file has trailing data");
+    }
+
+    return entry;
+}
+
+url_cache::url_cache(const std::filesystem::path& dir)
+    : dir(dir), hits(0), revalidations(0), full_fetches(0) {}
+
+std::optional<url_entry> url_cache::read(const std::string& url) const {
+    ohl::util::mapped_file mapping{get_url_entry_path(this->dir, url)};
+    if (!mapping.is_open()) {
+        return std::nullopt;
+    }
+
+    try {
+        auto entry = decode_url_entry(mapping.view());
+        // Could be a hash collision
+        if (entry.url != url) {
+            return std::nullopt;
+        }
+        return entry;
+    } catch (const std::runtime_error& ex) {
+        LOGI << "[OHL] Ignoring invalid cached copy of " << url << ": " << ex.what();
+        return std::nullopt;
+    }
+}
+
+void url_cache::store(const url_entry& entry) const {
+    std::error_code ec;
+    std::filesystem::create_directories(this->dir, ec);
+    if (ec) {
+        throw std::runtime_error("Couldn't create " + this->dir.string());
+    }
+
+    url_entry_writer writer{get_url_entry_path(this->dir, entry.url)};
+    writer.append(entry.body);
+    writer.commit(entry.url, entry.etag, entry.last_modified);
+}
+
+void url_cache::get(const std::string& url,
+                    const http_fetcher& fetch,
+                    const body_handler& on_body) {
+    auto cached = this->read(url);
+
+    std::string etag{};
+    std::string last_modified{};
+    if (cached) {
+        etag = cached->etag;
+        last_modified = cached->last_modified;
+        if (!etag.empty() || !last_modified.empty()) {
+            this->revalidations++;
+        }
+    }
+
+    // Only opened once there's a body to write
+    std::unique_ptr<url_entry_writer> writer{};
+    bool write_failed = false;
+    uint64_t received = 0;
+
+    auto resp = fetch(url, etag, last_modified, [&](std::string_view chunk) {
+        received += chunk.size();
+        on_body(chunk);
+
+        if (write_failed) {
+            return;
+        }
+        try {
+            if (!writer) {
+                std::filesystem::create_directories(this->dir);
+                writer = std::make_unique<url_entry_writer>(get_url_entry_path(this->dir, url));
+            }
+            writer->append(chunk);
+        } catch (const std::exception& ex) {
+            LOGE << "[OHL] Failed to cache " << url << ": " << ex.what();
+            writer = nullptr;
+            write_failed = true;
+        }
+    });
+
+    if (resp.status_code == 304 && cached) {
+        LOGD << "[OHL] " << url << " hasn't changed, using cached copy";
+        this->hits++;
+        on_body(cached->body);
+        return;
+    }
+
+    // If we can't reach the server, an old copy is better than nothing
+    if (resp.status_code == 0 || resp.status_code >= 500) {
+        auto reason = resp.status_code == 0 ? resp.error : std::to_string(resp.status_code);
+        if (received > 0) {
+            throw std::runtime_error(reason + ", partway through downloading");
+        }
+        if (cached) {
+            LOGW << "[OHL] Couldn't reach " << url << " (" << reason << "), using cached copy";
+            this->hits++;
+            on_body(cached->body);
+            return;
+        }
+        throw std::runtime_error(reason);
+    }
+
+    if (resp.status_code >= 300) {
+        throw std::runtime_error(std::to_string(resp.status_code));
+    }
+
+    this->full_fetches++;
+
+    if (write_failed) {
+        return;
+    }
+    try {
+        if (!writer) {
+            std::filesystem::create_directories(this->dir);
+            writer = std::make_unique<url_entry_writer>(get_url_entry_path(this->dir, url));
+        }
+        writer->commit(url, resp.etag, resp.last_modified);
+    } catch (const std::exception& ex) {
+        LOGE << "[OHL] Failed to cache " << url << ": " << ex.what();
+    }
+}
+
+std::string url_cache::get(const std::string& url, const http_fetcher& fetch) {
+    std::string body{};
+    this->get(url, fetch, [&](std::string_view chunk) { body.append(chunk); });
+    return body;
+}
+
+TEST_CASE("cache::url_cache") {
+    const auto dir = std::filesystem::temp_directory_path() / "ohl_url_cache_test";
+    std::filesystem::remove_all(dir);
+
+    const std::string url = "https://example.com/mod.bl3hotfix";
+
+    // Stand-in for the server, supporting both etags and last modified times
+    struct {
+        std::string body = "version 1";
+        std::string etag = "\"v1\"";
+        std::string last_modified = "Mon, 01 Jan 2024 00:00:00 GMT";
+        bool online = true;
+        bool drop_partway = false;
+        long error_code = 0;
+        size_t requests = 0;
+    } server;
+    auto fetch = [&](const std::string& request_url, const std::string& etag,
+                     const std::string& last_modified,
+                     const body_handler& on_body) -> http_response {
+        CHECK(request_url == url);
+        server.requests++;
+
+        if (!server.online) {
+            return {0, "", "", "Couldn't connect to server"};
+        }
+        if (server.error_code != 0) {
+            return {server.error_code, "", "", ""};
+        }
+        if ((!etag.empty() && etag == server.etag)
+            || (!last_modified.empty() && server.etag.empty()
+                && last_modified == server.last_modified)) {
+            return {304, server.etag, server.last_modified, ""};
+        }
+
+        // Send the body over in a few chunks
+        auto body = std::string_view{server.body};
+        on_body(body.substr(0, 3));
+        if (server.drop_partway) {
+            return {0, "", "", "Connection reset"};
+        }
+        on_body(body.substr(3));
+        return {200, server.etag, server.last_modified, ""};
+    };
+
+    url_cache cache{dir};
+    CHECK(!cache.read(url));
+
+    // First get always has to download everything
+    CHECK(cache.get(url, fetch) == "version 1");
+    CHECK(cache.full_fetches == 1);
+    CHECK(cache.revalidations == 0);
+    CHECK(cache.hits == 0);
+
+    auto stored = cache.read(url);
+    REQUIRE(stored.has_value());
+    CHECK(stored->body == "version 1");
+    CHECK(stored->etag == server.etag);
+
+    SUBCASE("unchanged") {
+        CHECK(cache.get(url, fetch) == "version 1");
+        CHECK(cache.full_fetches == 1);
+        CHECK(cache.revalidations == 1);
+        CHECK(cache.hits == 1);
+
+        // Should also work across instances
+        url_cache other{dir};
+        CHECK(other.get(url, fetch) == "version 1");
+        CHECK(other.full_fetches == 0);
+        CHECK(other.hits == 1);
+    }
+
+    SUBCASE("changed") {
+        server.body = "version 2";
+        server.etag = "\"v2\"";
+        CHECK(cache.get(url, fetch) == "version 2");
+        CHECK(cache.full_fetches == 2);
+        CHECK(cache.revalidations == 1);
+        CHECK(cache.hits == 0);
+        CHECK(cache.read(url)->body == "version 2");
+    }
+
+    SUBCASE("last modified only") {
+        std::filesystem::remove_all(dir);
+        server.etag = "";
+        CHECK(cache.get(url, fetch) == "version 1");
+        CHECK(cache.full_fetches == 2);
+
+        CHECK(cache.get(url, fetch) == "version 1");
+        CHECK(cache.full_fetches == 2);
+        CHECK(cache.revalidations == 1);
+        CHECK(cache.hits == 1);
+    }
+
+    SUBCASE("offline") {
+        server.online = false;
+        CHECK(cache.get(url, fetch) == "version 1");
+        CHECK(cache.hits == 1);
+
+        server.error_code = 503;
+        server.online = true;
+        CHECK(cache.get(url, fetch) == "version 1");
+        CHECK(cache.hits == 2);
+        CHECK(cache.full_fetches == 1);
+
+        // Without a cached copy there's nothing to fall back to
+        server.online = false;
+        std::filesystem::remove_all(dir);
+        CHECK_THROWS_AS(cache.get(url, fetch), std::runtime_error);
+    }
+
+    SUBCASE("dropped partway") {
+        server.body = "version 2";
+        server.etag = "\"v2\"";
+        server.drop_partway = true;
+        CHECK_THROWS_AS(cache.get(url, fetch), std::runtime_error);
+        CHECK(cache.hits == 0);
+
+        // Should have kept the old copy
+        CHECK(cache.read(url)->body == "version 1");
+        auto entries = std::distance(std::filesystem::directory_iterator{dir},
+                                     std::filesystem::directory_iterator{});
+        CHECK(entries == 1);
+    }
+
+    SUBCASE("concurrent writers") {
+        // Both writers should get their own temp file, rather than interleaving their bodies
+        auto path = get_url_entry_path(dir, url);
+        url_entry_writer first{path};
+        url_entry_writer second{path};
+        first.append("fir");
+        second.append("sec");
+        first.append("st");
+        second.append("ond");
+
+        second.commit(url, "\"second\"", "");
+        CHECK(cache.read(url)->body == "second");
+        first.commit(url, "\"first\"", "");
+        CHECK(cache.read(url)->body == "first");
+        CHECK(cache.read(url)->etag == "\"first\"");
+    }
+
+    SUBCASE("not found") {
+        server.error_code = 404;
+        CHECK_THROWS_AS(cache.get(url, fetch), std::runtime_error);
+        CHECK(cache.hits == 0);
+    }
+
+    SUBCASE("corrupt") {
+        auto path = get_url_entry_path(dir, url);
+        {
+            std::ofstream out{path, std::ios::binary | std::ios::trunc};
+            out << "OHLURLCA but not really";
+        }
+        CHECK(!cache.read(url));
+        CHECK(cache.get(url, fetch) == "version 1");
+        CHECK(cache.full_fetches == 2);
+        CHECK(cache.revalidations == 0);
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+#pragma endregion
+
+TEST_SUITE_END();
+}  // namespace ohl::cache
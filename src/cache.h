@@ -0,0 +1,229 @@
+#pragma once
+
+#include <pch.h>
+
+#include "loader.h"
+
+namespace ohl::cache {
+
+/**
+ * @brief Struct identifying a specific version of a local file.
+ */
+struct file_stamp {
+    std::string path;
+    bool exists;
+    uint64_t size;
+    int64_t mtime;
+    uint64_t hash;
+
+    bool operator==(const file_stamp& rhs) const {
+        return this->path == rhs.path && this->exists == rhs.exists && this->size == rhs.size
+               && this->mtime == rhs.mtime && this->hash == rhs.hash;
+    }
+    bool operator!=(const file_stamp& rhs) const { return !operator==(rhs); }
+};
+
+/**
+ * @brief Creates a stamp for a file from contents which have already been read.
+ * @note The modification time should be read before the contents, so that a write in between is
+ *       always seen as a change.
+ *
+ * @param path The path to the file.
+ * @param mtime The file's modification time.
+ * @param contents The file's contents.
+ * @return The file's stamp.
+ */
+file_stamp stamp_contents(const std::filesystem::path& path,
+                          int64_t mtime,
+                          std::string_view contents);
+
+/**
+ * @brief Creates a stamp for a file which does not exist.
+ *
+ * @param path The path to the file.
+ * @return The file's stamp.
+ */
+file_stamp stamp_missing(const std::filesystem::path& path);
+
+/**
+ * @brief Reads a file and creates a stamp of it's current state.
+ *
+ * @param path The path to the file.
+ * @return The file's stamp, or std::nullopt if it exists but couldn't be read.
+ */
+std::optional<file_stamp> stamp_file(const std::filesystem::path& path);
+
+/**
+ * @brief Gets a file's modification time, in the form stored in stamps.
+ *
+ * @param path The path to the file.
+ * @return The modification time, or 0 if it couldn't be read.
+ */
+int64_t get_mtime(const std::filesystem::path& path);
+
+/**
+ * @brief Struct holding all the inputs and outputs of a reload.
+ * @note Does not include the OHL news item, since it depends on the exe.
+ */
+struct cached_data {
+    // The files in the mods folder, in load order
+    std::vector<std::string> folder_listing;
+    // Every local file read while loading, including ones which don't exist
+    std::vector<file_stamp> inputs;
+    // Display names of the files to list in the OHL news item
+    std::vector<std::string> file_order;
+    std::pmr::deque<ohl::loader::hotfix> hotfixes;
+    std::pmr::deque<ohl::loader::news_item> news_items;
+
+    cached_data(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : hotfixes(resource), news_items(resource) {}
+};
+
+/**
+ * @brief Encodes data into the cache format.
+ *
+ * @param data The data to encode.
+ * @return The encoded bytes.
+ */
+std::string encode(const cached_data& data);
+
+/**
+ * @brief Decodes data from the cache format.
+ * @note Throws a runtime error if the data is corrupt.
+ *
+ * @param encoded The encoded bytes.
+ * @param resource The memory resource to allocate the hotfixes and news items from.
+ * @return The decoded data.
+ */
+cached_data decode(std::string_view encoded, std::pmr::memory_resource* resource);
+
+/**
+ * @brief Writes encoded data to a cache file.
+ * @note Writes to a temporary file first, so a crash never leaves a partial cache.
+ *
+ * @param path The path to the cache file.
+ * @param encoded The encoded bytes.
+ */
+void write(const std::filesystem::path& path, std::string_view encoded);
+
+/**
+ * @brief Tries to load a cache file, if it's still up to date.
+ * @note Re-stamps every input, so this reads every file the cache was built from.
+ *
+ * @param path The path to the cache file.
+ * @param folder_listing The files currently in the mods folder, in load order.
+ * @param resource The memory resource to allocate the hotfixes and news items from.
+ * @return The cached data, or std::nullopt if there's no valid cache, or if it's out of date.
+ */
+std::optional<cached_data> load(const std::filesystem::path& path,
+                                const std::vector<std::string>& folder_listing,
+                                std::pmr::memory_resource* resource);
+
+/**
+ * @brief Struct holding a cached http response.
+ */
+struct url_entry {
+    std::string url;
+    std::string etag;
+    std::string last_modified;
+    std::string body;
+};
+
+/**
+ * @brief Struct holding the parts of a http response the url cache cares about.
+ * @note Doesn't include the body, it's passed to a body handler as it arrives instead.
+ */
+struct http_response {
+    // 0 if the server couldn't be reached, or the connection dropped
+    long status_code;
+    std::string etag;
+    std::string last_modified;
+    std::string error;
+};
+
+/**
+ * @brief Function which gets passed a response body, one chunk at a time.
+ *
+ * @param chunk The next chunk of the body.
+ */
+using body_handler = std::function<void(std::string_view chunk)>;
+
+/**
+ * @brief Function which makes a http get request.
+ * @note The etag and last modified args are sent as `If-None-Match` and `If-Modified-Since`, if
+ *       they're not empty.
+ * @note Only the body of successful (2xx) responses is passed to the body handler.
+ *
+ * @param url The url to get.
+ * @param etag The etag of the cached response.
+ * @param last_modified The last modified time of the cached response.
+ * @param on_body The handler to pass the body to, as it arrives.
+ * @return The response.
+ */
+using http_fetcher = std::function<http_response(const std::string& url,
+                                                 const std::string& etag,
+                                                 const std::string& last_modified,
+                                                 const body_handler& on_body)>;
+
+/**
+ * @brief Persistent cache of http responses, which revalidates them with conditional requests.
+ * @note Each url is stored in it's own file, so concurrent gets of different urls are safe.
+ */
+class url_cache {
+   public:
+    std::filesystem::path dir;
+
+    // Gets served from the cache, either after revalidating or because the server was unavailable
+    std::atomic<size_t> hits;
+    // Conditional requests sent
+    std::atomic<size_t> revalidations;
+    // Full responses downloaded
+    std::atomic<size_t> full_fetches;
+
+    url_cache(const std::filesystem::path& dir);
+
+    /**
+     * @brief Reads the cached response for a url.
+     *
+     * @param url The url to look up.
+     * @return The cached response, or std::nullopt if there isn't a valid one.
+     */
+    std::optional<url_entry> read(const std::string& url) const;
+
+    /**
+     * @brief Stores a response in the cache.
+     * @note Throws a runtime error if it couldn't be written.
+     *
+     * @param entry The response to store.
+     */
+    void store(const url_entry& entry) const;
+
+    /**
+     * @brief Gets the contents of a url, revalidating any cached copy instead of downloading it
+     *        again.
+     * @note Downloaded contents are passed on, and written to the cache, as they arrive, so they
+     *       never need to be held in memory all at once.
+     * @note If the server can't be reached, falls back to the cached copy, no matter how old.
+     * @note Throws a runtime error if there's neither a response nor a cached copy, or if the
+     *       connection dropped partway through. Anything already passed to the handler should be
+     *       discarded.
+     *
+     * @param url The url to get.
+     * @param fetch The function used to make the actual request.
+     * @param on_body The handler to pass the url's contents to.
+     */
+    void get(const std::string& url, const http_fetcher& fetch, const body_handler& on_body);
+
+    /**
+     * @brief Gets the contents of a url, revalidating any cached copy instead of downloading it
+     *        again.
+     * @note Same as the handler overload, but collects the contents into a single string.
+     *
+     * @param url The url to get.
+     * @param fetch The function used to make the actual request.
+     * @return The url's contents.
+     */
+    std::string get(const std::string& url, const http_fetcher& fetch);
+};
+
+}  // namespace ohl::cache
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <pch.h>
+
+#include "cache.h"
+
+namespace ohl::download {
+
+/**
+ * @brief Gets the host part of a url, used to group connections.
+ *
+ * @param url The url.
+ * @return The host, including any port, in lower case.
+ */
+std::string get_host(std::string_view url);
+
+/**
+ * @brief Makes a http get request, reusing a kept alive connection to the same host if one's free.
+ * @note Instance of `ohl::cache::http_fetcher`.
+ *
+ * @param url The url to get.
+ * @param etag The etag of the cached response.
+ * @param last_modified The last modified time of the cached response.
+ * @param on_body The handler to pass the body to, as it arrives.
+ * @return The response.
+ */
+ohl::cache::http_response get(const std::string& url,
+                              const std::string& etag,
+                              const std::string& last_modified,
+                              const ohl::cache::body_handler& on_body);
+
+/**
+ * @brief Runs downloads on a bounded pool of worker threads, limiting how many run against each
+ *        host at once.
+ * @note Workers are only started as they're needed, and then kept around for later downloads.
+ */
+class scheduler {
+   private:
+    struct job {
+        std::string host;
+        std::packaged_task<void(void)> task;
+    };
+
+    size_t max_concurrent;
+    size_t max_per_host;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<job> queue;
+    std::unordered_map<std::string, size_t> active_per_host;
+    size_t idle_workers;
+    bool stopping;
+    std::vector<std::thread> workers;
+
+    /**
+     * @brief Main loop of the worker threads.
+     */
+    void run(void);
+
+   public:
+    static constexpr size_t DEFAULT_MAX_CONCURRENT = 16;
+    static constexpr size_t DEFAULT_MAX_PER_HOST = 6;
+
+    scheduler(size_t max_concurrent = DEFAULT_MAX_CONCURRENT,
+              size_t max_per_host = DEFAULT_MAX_PER_HOST);
+
+    /**
+     * @brief Finishes all queued downloads, then stops the workers.
+     */
+    ~scheduler();
+
+    scheduler(const scheduler&) = delete;
+    scheduler& operator=(const scheduler&) = delete;
+
+    /**
+     * @brief Queues a download.
+     *
+     * @param host The host the download is from, as returned by `get_host`.
+     * @param task The function doing the download.
+     * @return A future which completes when the task does, holding any exception it threw.
+     */
+    std::future<void> submit(std::string host, std::function<void(void)> task);
+};
+
+}  // namespace ohl::download
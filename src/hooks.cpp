@@ -1,6 +1,9 @@
 #include <pch.h>
 
+#include "args.h"
+#include "hooks.h"
 #include "processing.h"
+#include "sigscan.h"
 #include "unreal.h"
 
 using ohl::unreal::FJsonObject;
@@ -12,9 +15,6 @@ namespace ohl::hooks {
 
 #pragma region Types
 
-typedef void* (*fmemory_malloc)(size_t count, uint32_t align);
-typedef void* (*fmemory_realloc)(void* original, size_t count, uint32_t align);
-typedef void (*fmemory_free)(void* data);
 typedef int32_t (*get_services_verification)(void* this_api,
                                              FString* uuid,
                                              FString* consumer,
@@ -48,44 +48,29 @@ static game_functions funcs = {};
 
 #pragma region Sig Scanning
 
-/**
- * @brief Struct holding information about a sigscan.
- */
-struct sigscan_pattern {
-    const uint8_t* bytes;
-    const uint8_t* mask;
-    const size_t size;
-};
+static const std::string SIGSCAN_CACHE_FILE_NAME = "ohl-sigscan-cache.bin";
 
-/**
- * @brief Helper to convert strings into a sigscan pattern.
- *
- * @tparam n The length of the strings (should be picked up automatically).
- * @return A sigscan pattern.
- */
-template <size_t n>
-constexpr sigscan_pattern make_pattern(const char (&bytes)[n], const char (&mask)[n]) {
-    return sigscan_pattern{reinterpret_cast<const uint8_t*>(bytes),
-                           reinterpret_cast<const uint8_t*>(mask), n - 1};
-}
-
-static const sigscan_pattern malloc_pattern = make_pattern(
+static const sigscan::pattern malloc_pattern = sigscan::make_pattern(
+    "malloc",
     "\x48\x89\x5C\x24\x00\x57\x48\x83\xEC\x20\x48\x8B\xF9\x8B\xDA\x48\x8B\x0D\x00\x00\x00\x00\x48"
     "\x85\xC9",
     "\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF"
     "\xFF\xFF");
 
-static const sigscan_pattern realloc_pattern = make_pattern(
+static const sigscan::pattern realloc_pattern = sigscan::make_pattern(
+    "realloc",
     "\x48\x89\x5C\x24\x00\x48\x89\x74\x24\x00\x57\x48\x83\xEC\x20\x48\x8B\xF1\x41\x8B\xD8\x48\x8B"
     "\x0D\x00\x00\x00\x00\x48\x8B\xFA",
     "\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
     "\xFF\x00\x00\x00\x00\xFF\xFF\xFF");
 
-static const sigscan_pattern free_pattern = make_pattern(
+static const sigscan::pattern free_pattern = sigscan::make_pattern(
+    "free",
     "\x48\x85\xC9\x74\x00\x53\x48\x83\xEC\x20\x48\x8B\xD9\x48\x8B\x0D\x00\x00\x00\x00",
     "\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00");
 
-static const sigscan_pattern get_verification_pattern = make_pattern(
+static const sigscan::pattern get_verification_pattern = sigscan::make_pattern(
+    "get_verification",
     "\x40\x55\x53\x56\x57\x41\x54\x41\x55\x41\x56\x41\x57\x48\x8D\xAC\x24\x00\x00\x00\x00\x48\x81"
     "\xEC\xE8\x02\x00\x00\x48\x8B\x05\x00\x00\x00\x00\x48\x33\xC4\x48\x89\x85\x00\x00\x00\x00\x48"
     "\x8B\x85\x00\x00\x00\x00\x4D\x8B\xE0",
@@ -93,7 +78,8 @@ static const sigscan_pattern get_verification_pattern = make_pattern(
     "\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF"
     "\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF");
 
-static const sigscan_pattern discovery_pattern = make_pattern(
+static const sigscan::pattern discovery_pattern = sigscan::make_pattern(
+    "discovery",
     "\x40\x55\x53\x57\x48\x8D\x6C\x24\x00\x48\x81\xEC\x90\x00\x00\x00\x48\x83\x3A\x00\x48\x8B\xDA"
     "\x48\x8B\xF9\x75\x00\x32\xC0\x48\x81\xC4\x90\x00\x00\x00\x5F\x5B\x5D\xC3\x4C\x89\xBC\x24\x00"
     "\x00\x00\x00",
@@ -101,7 +87,8 @@ static const sigscan_pattern discovery_pattern = make_pattern(
     "\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00"
     "\x00\x00\x00");
 
-static const sigscan_pattern news_pattern = make_pattern(
+static const sigscan::pattern news_pattern = sigscan::make_pattern(
+    "news",
     "\x40\x55\x53\x57\x48\x8D\x6C\x24\x00\x48\x81\xEC\x90\x00\x00\x00\x48\x83\x3A\x00\x48\x8B\xDA"
     "\x48\x8B\xF9\x75\x00\x32\xC0\x48\x81\xC4\x90\x00\x00\x00\x5F\x5B\x5D\xC3\x48\x89\xB4\x24\x00"
     "\x00\x00\x00",
@@ -109,40 +96,11 @@ static const sigscan_pattern news_pattern = make_pattern(
     "\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00"
     "\x00\x00\x00");
 
-static const sigscan_pattern image_cache_pattern = make_pattern(
+static const sigscan::pattern image_cache_pattern = sigscan::make_pattern(
+    "image_cache",
     "\x40\x55\x41\x54\x41\x55\x41\x56\x48\x8D\x6C\x24\x00\x48\x81\xEC\xA8\x00\x00\x00",
     "\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF");
 
-/**
- * @brief Performs a sigscan.
- * @note Throws a runtime error on scan failure.
- *
- * @tparam T The type to cast the return to.
- * @param start The address to start the search at.
- * @param size The length of the region to search.
- * @param pattern The pattern to search for.
- * @return The found location, cast to the relevant type.
- */
-template <typename T>
-static T sigscan(void* start, size_t size, const sigscan_pattern& pattern) {
-    // The naive O(nm) search works well enough, even repeating it for each different pattern
-    for (auto i = 0; i < (size - pattern.size); i++) {
-        bool found = true;
-        for (auto j = 0; j < pattern.size; j++) {
-            auto val = reinterpret_cast<uint8_t*>(start)[i + j];
-            if ((val & pattern.mask[j]) != pattern.bytes[j]) {
-                found = false;
-                break;
-            }
-        }
-        if (found) {
-            return reinterpret_cast<T>(&reinterpret_cast<uint8_t*>(start)[i]);
-        }
-    }
-
-    throw std::runtime_error("Sigscan failed");
-}
-
 #pragma endregion
 
 #pragma region Wrappers
@@ -274,10 +232,17 @@ void free(void* data) {
     funcs.free(data);
 }
 
+void set_allocator(fmemory_malloc malloc, fmemory_realloc realloc, fmemory_free free) {
+    funcs.malloc = malloc;
+    funcs.realloc = realloc;
+    funcs.free = free;
+}
+
 #pragma endregion
 
 void init(void) {
     LOGD << "[OHL] Initalizing hooks";
+    auto start = std::chrono::steady_clock::now();
 
     auto exe_module = GetModuleHandle(NULL);
 
@@ -297,16 +262,20 @@ void init(void) {
 
     LOGD << "[OHL] Sigscanning";
 
-    funcs.malloc = sigscan<fmemory_malloc>(allocation_base, module_length, malloc_pattern);
-    funcs.realloc = sigscan<fmemory_realloc>(allocation_base, module_length, realloc_pattern);
-    funcs.free = sigscan<fmemory_free>(allocation_base, module_length, free_pattern);
-    funcs.get_verification = sigscan<get_services_verification>(allocation_base, module_length,
-                                                                get_verification_pattern);
-    funcs.discovery =
-        sigscan<discovery_from_json>(allocation_base, module_length, discovery_pattern);
-    funcs.news = sigscan<news_from_json>(allocation_base, module_length, news_pattern);
-    funcs.image_cache =
-        sigscan<add_image_to_cache>(allocation_base, module_length, image_cache_pattern);
+    auto cache_path = ohl::args::dll_path().replace_filename(SIGSCAN_CACHE_FILE_NAME);
+    auto [found, cache_hit] = sigscan::scan_cached(
+        cache_path, allocation_base, module_length,
+        {malloc_pattern, realloc_pattern, free_pattern, get_verification_pattern, discovery_pattern,
+         news_pattern, image_cache_pattern},
+        std::max(std::thread::hardware_concurrency(), 1U));
+
+    funcs.malloc = reinterpret_cast<fmemory_malloc>(found[0]);
+    funcs.realloc = reinterpret_cast<fmemory_realloc>(found[1]);
+    funcs.free = reinterpret_cast<fmemory_free>(found[2]);
+    funcs.get_verification = reinterpret_cast<get_services_verification>(found[3]);
+    funcs.discovery = reinterpret_cast<discovery_from_json>(found[4]);
+    funcs.news = reinterpret_cast<news_from_json>(found[5]);
+    funcs.image_cache = reinterpret_cast<add_image_to_cache>(found[6]);
 
     LOGD << "[OHL] Injecting detours";
 
@@ -355,7 +324,10 @@ void init(void) {
         throw std::runtime_error("MH_EnableHook failed " + std::to_string(ret));
     }
 
-    LOGI << "[OHL] Hooks injected successfully";
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    LOGI << "[OHL] Hooks injected successfully in " << time.count() << "ms (sigscan cache "
+         << (cache_hit ? "hit" : "miss") << ")";
 }
 
 }  // namespace ohl::hooks
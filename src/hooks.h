@@ -2,6 +2,10 @@
 
 namespace ohl::hooks {
 
+typedef void* (*fmemory_malloc)(size_t count, uint32_t align);
+typedef void* (*fmemory_realloc)(void* original, size_t count, uint32_t align);
+typedef void (*fmemory_free)(void* data);
+
 /**
  * @brief Initalizes the hooks module.
  */
@@ -58,4 +62,14 @@ T* realloc(void* original, size_t count) {
  */
 void free(void* data);
 
+/**
+ * @brief Overwrites the functions used to allocate game memory.
+ * @note Intended for tests, which run outside of the game, and so can't sigscan for the real ones.
+ *
+ * @param malloc The malloc function to use.
+ * @param realloc The realloc function to use.
+ * @param free The free function to use.
+ */
+void set_allocator(fmemory_malloc malloc, fmemory_realloc realloc, fmemory_free free);
+
 }  // namespace ohl::hooks
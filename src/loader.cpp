@@ -3,9 +3,13 @@
 #include <doctest/doctest.h>
 
 #include "args.h"
+#include "cache.h"
+#include "download.h"
 #include "loader.h"
+#include "tasks.h"
 #include "util.h"
 #include "version.h"
+#include "watcher.h"
 
 using mod_file_identifier = std::string;
 
@@ -23,6 +27,16 @@ static const std::string NEWS_COMMAND = "injectnewsitem";
 static const std::string EXEC_COMMAND = "exec";
 static const std::string URL_COMMAND = "url=";
 
+// Index 0 is reserved for the empty key
+static const std::array<std::string, 6> HOTFIX_KEY_ATOMS = {
+    "",
+    "SparkPatchEntry",
+    "SparkLevelPatchEntry",
+    "SparkEarlyLevelPatchEntry",
+    "SparkCharacterLoadedEntry",
+    "SparkStreamedPackageEntry",
+};
+
 static const std::string TYPE_11_DELAY_TYPE = "SparkEarlyLevelPatchEntry";
 static const std::string TYPE_11_DELAY_VALUE =
     "(1,1,0,{map}),/Game/Pickups/Ammo/"
@@ -38,29 +52,281 @@ static const std::vector<std::string> TYPE_11_DELAY_MESHES = {
     "/Game/Pickups/Ammo/Model/Meshes/SM_ammo_pistol.SM_ammo_pistol",
 };
 
-static const std::string OHL_NEWS_ITEM_IMAGE_URL = OHL_GITHUB_RAW_URL "news_icon.png";
+static constexpr std::string_view OHL_NEWS_ITEM_IMAGE_URL = OHL_GITHUB_RAW_URL "news_icon.png";
 
-static const std::string OHL_NEWS_ITEM_ARTICLE_URL = OHL_GITHUB_URL "releases";
+static constexpr std::string_view OHL_NEWS_ITEM_ARTICLE_URL = OHL_GITHUB_URL "releases";
 
 #pragma endregion
 
-// This default works relative to the cwd, we'll try replace it later.
+// These defaults work relative to the cwd, we'll try replace them later.
 static std::filesystem::path mod_dir = "ohl-mods";
+static std::filesystem::path cache_file = "ohl-cache.bin";
+static ohl::cache::url_cache url_cache{"ohl-url-cache"};
 
 static std::mutex known_mod_files_mutex;
 static std::unordered_map<mod_file_identifier, std::shared_ptr<mod_file>> known_mod_files{};
 
+// Held by whoever's loading files into `known_mod_files`, either a reload or a background pre-parse
+static std::mutex loading_mutex;
+
+// The files known during the previous load. Guarded by the known files mutex, since files look up
+//  their previous versions while others are still loading.
+static std::unordered_map<mod_file_identifier, std::shared_ptr<mod_file>> previous_mod_files{};
+static std::atomic<size_t> reused_file_count{0};
+static std::atomic<size_t> loaded_file_count{0};
+
 #pragma region Types
 
+hotfix::hotfix(const allocator_type& alloc) : key_atom(0), value(alloc) {}
+
+hotfix::hotfix(std::string_view key, std::string_view value, const allocator_type& alloc)
+    : key_atom(0), value(value, alloc) {
+    for (uint8_t i = 0; i < HOTFIX_KEY_ATOMS.size(); i++) {
+        if (HOTFIX_KEY_ATOMS[i] == key) {
+            this->key_atom = i;
+            return;
+        }
+    }
+    this->custom_key = std::make_unique<std::string>(key);
+}
+
+hotfix::hotfix(const hotfix& other, const allocator_type& alloc)
+    : key_atom(other.key_atom),
+      custom_key(other.custom_key ? std::make_unique<std::string>(*other.custom_key) : nullptr),
+      value(other.value, alloc) {}
+
+hotfix::hotfix(hotfix&& other, const allocator_type& alloc)
+    : key_atom(other.key_atom),
+      custom_key(std::move(other.custom_key)),
+      value(std::move(other.value), alloc) {}
+
+hotfix& hotfix::operator=(const hotfix& other) {
+    if (this != &other) {
+        this->key_atom = other.key_atom;
+        this->custom_key =
+            other.custom_key ? std::make_unique<std::string>(*other.custom_key) : nullptr;
+        this->value = other.value;
+    }
+    return *this;
+}
+
+const std::string& hotfix::get_key(void) const {
+    if (this->custom_key) {
+        return *this->custom_key;
+    }
+    return HOTFIX_KEY_ATOMS[this->key_atom];
+}
+
+bool hotfix::operator==(const hotfix& rhs) const {
+    if (!this->custom_key && !rhs.custom_key) {
+        return this->key_atom == rhs.key_atom && this->value == rhs.value;
+    }
+    return this->get_key() == rhs.get_key() && this->value == rhs.value;
+}
+
+TEST_CASE("loader::hotfix") {
+    for (const auto& key : HOTFIX_KEY_ATOMS) {
+        const hotfix known{key, "value"};
+        CHECK(known.get_key() == key);
+        CHECK(known.value == "value");
+    }
+
+    const hotfix custom{"SparkSomeNewEntry", "value"};
+    CHECK(custom.get_key() == "SparkSomeNewEntry");
+
+    // Unknown keys which happen to share a prefix with a known one shouldn't get interned
+    const hotfix prefix{"SparkPatchEntryButLonger", "value"};
+    CHECK(prefix.get_key() == "SparkPatchEntryButLonger");
+
+    const hotfix patch{"SparkPatchEntry", "value"};
+    CHECK(patch == hotfix{"SparkPatchEntry", "value"});
+    CHECK(patch != hotfix{"SparkPatchEntry", "other"});
+    CHECK(patch != hotfix{"SparkLevelPatchEntry", "value"});
+    CHECK(patch != custom);
+    CHECK(custom == hotfix{"SparkSomeNewEntry", "value"});
+
+    hotfix copy = custom;
+    CHECK(copy == custom);
+    copy = patch;
+    CHECK(copy == patch);
+    CHECK(copy.get_key() == "SparkPatchEntry");
+
+    hotfix moved = std::move(copy);
+    CHECK(moved == patch);
+
+    CHECK(hotfix{}.get_key().empty());
+    CHECK(sizeof(hotfix) < 2 * sizeof(std::string));
+
+    // Containers should pass their allocator down, copies out of them should not keep it
+    ohl::util::arena test_arena{};
+    std::pmr::deque<hotfix> arena_hotfixes{&test_arena};
+    arena_hotfixes.emplace_back("SparkPatchEntry", "a value long enough to need an allocation");
+    arena_hotfixes.push_back(custom);
+    arena_hotfixes.emplace_back();
+    for (const auto& arena_hotfix : arena_hotfixes) {
+        CHECK(arena_hotfix.value.get_allocator().resource() == &test_arena);
+    }
+    CHECK(arena_hotfixes[1] == custom);
+
+    const hotfix heap_copy = arena_hotfixes[0];
+    CHECK(heap_copy.value.get_allocator().resource() == std::pmr::get_default_resource());
+    CHECK(heap_copy == arena_hotfixes[0]);
+}
+
+image_url_index::image_url_index(const std::pmr::deque<news_item>& news_items)
+    : wide_storage(news_items.get_allocator().resource()),
+      urls(news_items.get_allocator().resource()),
+      wide_urls(news_items.get_allocator().resource()) {
+    for (const auto& item : news_items) {
+        if (!this->urls.insert(item.image_url).second) {
+            continue;
+        }
+        this->wide_urls.insert(this->wide_storage.emplace_back(ohl::util::widen(item.image_url)));
+    }
+}
+
+bool image_url_index::contains(std::string_view url) const {
+    return this->urls.find(url) != this->urls.end();
+}
+
+bool image_url_index::contains(std::wstring_view url) const {
+    return this->wide_urls.find(url) != this->wide_urls.end();
+}
+
+TEST_CASE("loader::image_url_index") {
+    const std::pmr::deque<news_item> news_items{
+        {"Header", "https://example.com/image.png"},
+        {"Header", "https://example.com/other.png", "https://example.com"},
+        {"Duplicate", "https://example.com/image.png"},
+    };
+    const image_url_index index{news_items};
+
+    CHECK(index.contains("https://example.com/image.png"));
+    CHECK(index.contains("https://example.com/other.png"));
+    CHECK(index.contains(L"https://example.com/image.png"));
+    CHECK(index.contains(L"https://example.com/other.png"));
+
+    CHECK(!index.contains("https://example.com"));
+    CHECK(!index.contains(L"https://example.com"));
+    CHECK(!index.contains("https://example.com/IMAGE.png"));
+    CHECK(!index.contains(L"https://example.com/image.png?query"));
+
+    // Views shouldn't need to be null terminated
+    const std::wstring longer = L"https://example.com/image.png.jpg";
+    CHECK(index.contains(std::wstring_view(longer).substr(0, longer.size() - 4)));
+
+    const std::pmr::deque<news_item> no_news_items{};
+    const image_url_index empty{no_news_items};
+    CHECK(!empty.contains(""));
+    CHECK(!empty.contains(L""));
+}
+
+hotfix_payload::hotfix_payload(const std::pmr::deque<hotfix>& hotfixes)
+    : buffer(hotfixes.get_allocator().resource()), table(hotfixes.get_allocator().resource()) {
+    // A utf8 string never has less bytes than it's utf16 version has wchars, so we can reserve an
+    //  upper bound and convert each string straight into place
+    size_t max_size = 0;
+    for (const auto& hotfix : hotfixes) {
+        max_size += hotfix.get_key().size() + hotfix.value.size();
+    }
+    this->buffer.reserve(max_size);
+    this->table.reserve(hotfixes.size());
+
+    for (const auto& hotfix : hotfixes) {
+        offsets entry_offsets{};
+        entry_offsets.key = this->buffer.size();
+        this->append(hotfix.get_key());
+        entry_offsets.value = this->buffer.size();
+        this->append(hotfix.value);
+        entry_offsets.end = this->buffer.size();
+
+        this->table.push_back(entry_offsets);
+    }
+}
+
+void hotfix_payload::append(std::string_view str) {
+    auto start = this->buffer.size();
+    this->buffer.resize(start + str.size());
+    this->buffer.resize(start + ohl::util::widen_into(str, this->buffer.data() + start));
+}
+
+size_t hotfix_payload::size(void) const {
+    return this->table.size();
+}
+
+hotfix_payload::entry hotfix_payload::operator[](size_t idx) const {
+    const auto& entry_offsets = this->table[idx];
+    const auto data = this->buffer.data();
+    return {{data + entry_offsets.key, entry_offsets.value - entry_offsets.key},
+            {data + entry_offsets.value, entry_offsets.end - entry_offsets.value}};
+}
+
+TEST_CASE("loader::hotfix_payload") {
+    const std::pmr::deque<hotfix> hotfixes{
+        {"SparkPatchEntry", "(1,1,0,),/Game/Gear/Weapons/_Shared/_Design/Balance/Balance.Balance"},
+        {"SparkEarlyLevelPatchEntry", u8"(1,11,0,Map_P),υπόθεση δοκιμής"},
+        {"SparkPatchEntry", ""},
+        {"SomeCustomPatchEntry", u8"テストケース"},
+    };
+    const hotfix_payload payload{hotfixes};
+
+    REQUIRE(payload.size() == hotfixes.size());
+    for (size_t i = 0; i < hotfixes.size(); i++) {
+        CHECK(payload[i].key == ohl::util::widen(hotfixes[i].get_key()));
+        CHECK(payload[i].value == ohl::util::widen(hotfixes[i].value));
+    }
+
+    // Everything should be in one contiguous block
+    CHECK(payload[1].key.data() == payload[0].value.data() + payload[0].value.size());
+    CHECK(payload[3].key.data() == payload[2].value.data() + payload[2].value.size());
+
+    const std::pmr::deque<hotfix> no_hotfixes{};
+    const hotfix_payload empty{no_hotfixes};
+    CHECK(empty.size() == 0);
+
+    // Should be built as part of every snapshot
+    const loaded_data data{std::pmr::deque<hotfix>{hotfixes}};
+    REQUIRE(data.rendered_hotfixes.size() == hotfixes.size());
+    CHECK(data.rendered_hotfixes[3].value == ohl::util::widen(hotfixes[3].value));
+}
+
 /**
  * @brief Class holding all the data that can be extracted from a region of a mod file.
  */
 class mod_data {
    public:
-    std::deque<hotfix> hotfixes{};
-    std::vector<hotfix> type_11_hotfixes{};
-    std::unordered_set<std::string> type_11_maps{};
-    std::deque<news_item> news_items{};
+    std::pmr::deque<hotfix> hotfixes;
+    std::pmr::vector<hotfix> type_11_hotfixes;
+    std::pmr::unordered_set<std::pmr::string> type_11_maps;
+    std::pmr::deque<news_item> news_items;
+
+    explicit mod_data(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : hotfixes(resource),
+          type_11_hotfixes(resource),
+          type_11_maps(resource),
+          news_items(resource) {}
+    mod_data(const mod_data& other, std::pmr::memory_resource* resource)
+        : hotfixes(other.hotfixes, resource),
+          type_11_hotfixes(other.type_11_hotfixes, resource),
+          type_11_maps(other.type_11_maps, resource),
+          news_items(other.news_items, resource) {}
+    mod_data(std::pmr::deque<hotfix> hotfixes,
+             std::pmr::vector<hotfix> type_11_hotfixes,
+             std::pmr::unordered_set<std::pmr::string> type_11_maps,
+             std::pmr::deque<news_item> news_items)
+        : hotfixes(std::move(hotfixes)),
+          type_11_hotfixes(std::move(type_11_hotfixes)),
+          type_11_maps(std::move(type_11_maps)),
+          news_items(std::move(news_items)) {}
+
+    /**
+     * @brief Gets the memory resource this object's data is allocated from.
+     *
+     * @return The memory resource.
+     */
+    std::pmr::memory_resource* get_resource(void) const {
+        return this->hotfixes.get_allocator().resource();
+    }
 
     /**
      * @brief Checks if this object holds no mod data.
@@ -85,6 +351,29 @@ class mod_data {
         other.news_items.insert(other.news_items.end(), this->news_items.begin(),
                                 this->news_items.end());
     }
+
+    /**
+     * @brief Moves the mod data from this object to the end of that of another.
+     * @note Leaves this object empty.
+     *
+     * @param other The other mod data object to move to.
+     */
+    void move_to(mod_data& other) {
+        other.hotfixes.insert(other.hotfixes.end(), std::make_move_iterator(this->hotfixes.begin()),
+                              std::make_move_iterator(this->hotfixes.end()));
+        other.type_11_hotfixes.insert(other.type_11_hotfixes.end(),
+                                      std::make_move_iterator(this->type_11_hotfixes.begin()),
+                                      std::make_move_iterator(this->type_11_hotfixes.end()));
+        other.type_11_maps.insert(this->type_11_maps.begin(), this->type_11_maps.end());
+        other.news_items.insert(other.news_items.end(),
+                                std::make_move_iterator(this->news_items.begin()),
+                                std::make_move_iterator(this->news_items.end()));
+
+        this->hotfixes.clear();
+        this->type_11_hotfixes.clear();
+        this->type_11_maps.clear();
+        this->news_items.clear();
+    }
 };
 
 TEST_CASE("loader::mod_data::append_to") {
@@ -142,6 +431,27 @@ TEST_CASE("loader::mod_data::append_to") {
     }
 }
 
+TEST_CASE("loader::mod_data::move_to") {
+    const mod_data data_a{{{"SparkPatchEntry", "(1,1,0,),/Some/Hotfix/Here"}},
+                          {{"SparkEarlyLevelPatchEntry", "(1,11,0,SomeMap_P)"}},
+                          {"SomeMap_P"},
+                          {{"header", "image", "article", "body"}}};
+    const mod_data data_b{{{"Key", "Value"}}, {}, {}, {}};
+
+    mod_data appended = data_b;
+    data_a.append_to(appended);
+
+    mod_data moved = data_b;
+    mod_data data_a_copy = data_a;
+    data_a_copy.move_to(moved);
+
+    CHECK(data_a_copy.is_empty());
+    CHECK(ITERABLE_EQUAL(moved.hotfixes, appended.hotfixes));
+    CHECK(ITERABLE_EQUAL(moved.type_11_hotfixes, appended.type_11_hotfixes));
+    CHECK(moved.type_11_maps == appended.type_11_maps);
+    CHECK(ITERABLE_EQUAL(moved.news_items, appended.news_items));
+}
+
 TEST_CASE("loader::mod_data::is_empty") {
     mod_data data{};
     REQUIRE(data.is_empty() == true);
@@ -179,48 +489,93 @@ class remote_mod_data {
  */
 class mod_file {
    protected:
+    // Null to use the default resource
+    std::shared_ptr<std::pmr::memory_resource> arena;
+
+    /**
+     * @brief Gets the memory resource this file's data should be allocated from.
+     *
+     * @return The memory resource.
+     */
+    std::pmr::memory_resource* get_resource(void) const {
+        return this->arena ? this->arena.get() : std::pmr::get_default_resource();
+    }
+
+    void load_line(std::string_view mod_line, mod_data& data, bool allow_exec);
     void load_from_stream(std::istream& stream, bool allow_exec);
+    void load_from_view(std::string_view contents, bool allow_exec);
+    void load_from_view_parallel(std::string_view contents, bool allow_exec, size_t chunk_count);
 
     /**
-     * @brief Adds a mod data object to this file's sections.
+     * @brief Moves a mod data object into this file's sections.
+     * @note Leaves the passed object empty, ready to be reused.
      *
      * @param data The mod data to add.
      */
-    void push_mod_data(const mod_data& data) {
+    void push_mod_data(mod_data& data) {
         if (!data.is_empty()) {
-            this->sections.push_back(data);
+            this->sections.emplace_back(std::move(data));
+            data = mod_data{this->get_resource()};
         }
     }
 
     /**
      * @brief Adds a remote to this file's sections, as well as to the global list of known files.
-     * @note If the file was not previously known, starts loading it.
-     * @note Edits the global list atomically.
+     * @note See `add_known_file`.
      *
      * @param file The file to register.
      */
-    void register_remote_file(const std::shared_ptr<mod_file> file) {
-        auto identifier = file->get_identifier();
-        this->sections.emplace_back(identifier);
+    virtual void register_remote_file(const std::shared_ptr<mod_file> file) {
+        this->sections.emplace_back(file->get_identifier());
+        add_known_file(file);
+    }
 
-        bool is_known = true;
+    /**
+     * @brief Adds a file to the global list of known files.
+     * @note If the file was not previously known, starts loading it, or reuses the data from the
+     *       previous reload if it hasn't changed.
+     * @note Edits the global list atomically.
+     *
+     * @param file The file to add.
+     */
+    static void add_known_file(const std::shared_ptr<mod_file>& file) {
+        auto identifier = file->get_identifier();
 
+        std::shared_ptr<mod_file> previous = nullptr;
         {
             std::lock_guard<std::mutex> lock(known_mod_files_mutex);
 
-            if (known_mod_files.find(identifier) == known_mod_files.end()) {
-                known_mod_files[identifier] = file;
-                is_known = false;
+            if (known_mod_files.find(identifier) != known_mod_files.end()) {
+                return;
+            }
+            known_mod_files[identifier] = file;
+
+            auto previous_it = previous_mod_files.find(identifier);
+            if (previous_it != previous_mod_files.end()) {
+                previous = previous_it->second;
             }
         }
 
-        if (!is_known) {
-            file->load();
+        if (previous != nullptr) {
+            file->load_or_reuse(previous);
+            return;
         }
+
+        loaded_file_count++;
+        file->load();
     }
 
    public:
-    std::vector<std::variant<mod_data, remote_mod_data>> sections;
+    std::pmr::deque<std::variant<mod_data, remote_mod_data>> sections;
+
+    /**
+     * @brief Construct a new mod file.
+     *
+     * @param arena The arena to allocate this file's data from. Kept alive at least as long as the
+     *              file. Null to use the default resource.
+     */
+    mod_file(std::shared_ptr<std::pmr::memory_resource> arena = nullptr)
+        : arena(std::move(arena)), sections(this->get_resource()) {}
 
     /**
      * @brief Appends all the mod data from this file to the end of a mod data object.
@@ -242,7 +597,12 @@ class mod_file {
             if (std::holds_alternative<mod_data>(section)) {
                 std::get<mod_data>(section).append_to(data);
             } else {
-                auto file = known_mod_files.at(std::get<remote_mod_data>(section).identifier);
+                std::shared_ptr<mod_file> file;
+                {
+                    // Other files might still be loading, and registering more files
+                    std::lock_guard<std::mutex> lock(known_mod_files_mutex);
+                    file = known_mod_files.at(std::get<remote_mod_data>(section).identifier);
+                }
 
                 auto identifier = file->get_identifier();
                 if (std::find(seen_files.begin(), seen_files.end(), identifier)
@@ -259,6 +619,35 @@ class mod_file {
         }
     }
 
+    /**
+     * @brief Joins this file, and every file nested inside it.
+     * @note Nested files are only registered while their parent loads, so this walks the files in
+     *       the same order as `append_to`, joining each one before looking inside it.
+     *
+     * @param joined_files The files which have already been joined, which are skipped.
+     */
+    void join_nested(std::unordered_set<mod_file_identifier>& joined_files) {
+        this->join();
+
+        for (const auto& section : this->sections) {
+            if (!std::holds_alternative<remote_mod_data>(section)) {
+                continue;
+            }
+
+            const auto& identifier = std::get<remote_mod_data>(section).identifier;
+            if (!joined_files.insert(identifier).second) {
+                continue;
+            }
+
+            std::shared_ptr<mod_file> file;
+            {
+                std::lock_guard<std::mutex> lock(known_mod_files_mutex);
+                file = known_mod_files.at(identifier);
+            }
+            file->join_nested(joined_files);
+        }
+    }
+
     /**
      * @brief Gets a unique identifier for this mod file.
      *
@@ -283,16 +672,105 @@ class mod_file {
      * @brief Joins any threads started by loading this mod file.
      */
     virtual void join(void) {}
+
+    /**
+     * @brief Loads this mod file, or fills it using the data from the same file in a previous
+     *        reload instead, if it hasn't changed.
+     * @note May be async, must call join to ensure this has finished.
+     * @note Adds to the loaded or reused file counts, depending on which it did.
+     *
+     * @param previous The same file, from the previous reload.
+     */
+    virtual void load_or_reuse(std::shared_ptr<const mod_file> /* previous */) {
+        loaded_file_count++;
+        this->load();
+    }
 };
 
+/**
+ * @brief Waits for every known file to finish loading.
+ * @note Files may register more files while loading, so keeps going until nothing new turns up.
+ */
+static void join_known_mod_files(void) {
+    std::unordered_set<mod_file*> joined{};
+    while (true) {
+        std::vector<std::shared_ptr<mod_file>> pending{};
+        {
+            std::lock_guard<std::mutex> lock(known_mod_files_mutex);
+            for (const auto& [identifier, file] : known_mod_files) {
+                if (joined.find(file.get()) == joined.end()) {
+                    pending.push_back(file);
+                }
+            }
+        }
+        if (pending.empty()) {
+            return;
+        }
+
+        for (const auto& file : pending) {
+            file->join();
+            joined.insert(file.get());
+        }
+    }
+}
+
+/**
+ * @brief Gets the scheduler local mod files are loaded on.
+ *
+ * @return The scheduler.
+ */
+static ohl::tasks::scheduler& get_load_scheduler(void) {
+    return ohl::util::leaked([] { return ohl::tasks::scheduler(ohl::args::parse_threads()); });
+}
+
+// Run at the start of loading each local file, on the pool thread. Used in tests to shuffle the
+//  order loads finish in.
+static std::function<void(void)> local_load_hook = nullptr;
+
 /**
  * @brief Class for mod file data based on a local file.
  */
 class mod_file_local : public mod_file {
+   private:
+    std::future<void> loading;
+
+    /**
+     * @brief Loads this file on the current thread.
+     * @note Reads the file once, reusing the previous data if it's unchanged, and otherwise
+     *       parsing it out of the same mapping.
+     *
+     * @param previous The same file from the previous reload, or null if there isn't one.
+     * @return True if the previous data was reused.
+     */
+    bool load_now(const mod_file_local* previous);
+
+    /**
+     * @brief Fills this file using the data from the same file in a previous reload, if it hasn't
+     *        changed.
+     * @note Compares against this file's stamp, which must be set first.
+     *
+     * @param previous The same file, from the previous reload.
+     * @return True if the data was reused, false if this file still needs to be loaded.
+     */
+    bool reuse_if_unchanged(const mod_file_local& previous);
+
    public:
     const std::filesystem::path path;
 
-    mod_file_local(const std::filesystem::path& path) : path(path) {}
+    // The state of the file when it was loaded, for the hotfix cache and for reusing it in the
+    //  next reload. Null if it couldn't be read.
+    std::optional<ohl::cache::file_stamp> stamp;
+
+    mod_file_local(const std::filesystem::path& path,
+                   std::shared_ptr<std::pmr::memory_resource> arena = nullptr)
+        : mod_file(std::move(arena)), path(path) {}
+
+    ~mod_file_local() {
+        // The pool's still using this file, make sure it's done first
+        if (this->loading.valid()) {
+            this->loading.wait();
+        }
+    }
 
     virtual mod_file_identifier get_identifier(void) const { return this->path.string(); }
 
@@ -330,15 +808,178 @@ class mod_file_local : public mod_file {
     }
 
     virtual void load(void) {
-        LOGD << "[OHL] Loading " << path;
+        // Any files this execs get queued on the same worker, where idle workers can steal them
+        this->loading = get_load_scheduler().submit([this]() {
+            if (local_load_hook) {
+                local_load_hook();
+            }
+            this->load_now(nullptr);
+        });
+    }
+
+    virtual void load_or_reuse(std::shared_ptr<const mod_file> previous) {
+        // Checking if it changed means reading the whole file, so do it on the pool too
+        auto previous_local = std::dynamic_pointer_cast<const mod_file_local>(previous);
+        this->loading = get_load_scheduler().submit([this, previous_local]() {
+            if (local_load_hook) {
+                local_load_hook();
+            }
+            if (this->load_now(previous_local.get())) {
+                reused_file_count++;
+            } else {
+                loaded_file_count++;
+            }
+        });
+    }
+
+    virtual void join(void) {
+        // May be joined more than once
+        if (this->loading.valid()) {
+            get_load_scheduler().wait(this->loading);
+            this->loading.get();
+        }
+    }
+
+    TEST_CASE_CLASS("loader::mod_file_local::load - mapped and stream identical") {
+        auto original_mod_dir = mod_dir;
+        mod_dir = std::filesystem::path("tests");
+
+        std::string filename;
+        for (const auto& name :
+             {"basic_mod.bl3hotfix", "unicode_statement.bl3hotfix",
+              "easy_entry_to_fort_sunshine.bl3hotfix", "single_exec.bl3hotfix",
+              "nested_exec.bl3hotfix", "multi_exec.bl3hotfix", "news.bl3hotfix"}) {
+            SUBCASE(name) {
+                filename = name;
+            }
+        }
+
+        known_mod_files.clear();
+        mod_file_local mapped_file{mod_dir / filename};
+        mapped_file.load();
+        mapped_file.join();
+
+        join_known_mod_files();
+        known_mod_files.clear();
+        mod_file_local stream_file{mod_dir / filename};
+        std::ifstream stream{mod_dir / filename};
+        REQUIRE(stream.is_open());
+        stream_file.load_from_stream(stream, true);
+
+        REQUIRE(mapped_file.sections.size() == stream_file.sections.size());
+        for (size_t i = 0; i < mapped_file.sections.size(); i++) {
+            const auto& mapped_section = mapped_file.sections[i];
+            const auto& stream_section = stream_file.sections[i];
+            REQUIRE(mapped_section.index() == stream_section.index());
+
+            if (std::holds_alternative<remote_mod_data>(mapped_section)) {
+                CHECK(std::get<remote_mod_data>(mapped_section).identifier
+                      == std::get<remote_mod_data>(stream_section).identifier);
+                continue;
+            }
+
+            const auto& mapped_data = std::get<mod_data>(mapped_section);
+            const auto& stream_data = std::get<mod_data>(stream_section);
+            CHECK(ITERABLE_EQUAL(mapped_data.hotfixes, stream_data.hotfixes));
+            CHECK(ITERABLE_EQUAL(mapped_data.type_11_hotfixes, stream_data.type_11_hotfixes));
+            CHECK(mapped_data.type_11_maps == stream_data.type_11_maps);
+            CHECK(ITERABLE_EQUAL(mapped_data.news_items, stream_data.news_items));
+        }
+
+        join_known_mod_files();
+        known_mod_files.clear();
+        mod_dir = original_mod_dir;
+    }
+
+    TEST_CASE_CLASS("loader::mod_file_local::load - mapped vs stream benchmark" * doctest::skip()) {
+        static const auto LINE_COUNT = 500000;
+        const auto path = std::filesystem::temp_directory_path() / "ohl_mapped_benchmark.bl3hotfix";
+
+        {
+            std::ofstream out{path, std::ios::binary | std::ios::trunc};
+            REQUIRE(out.is_open());
+            for (auto i = 0; i < LINE_COUNT; i++) {
+                out << "SparkPatchEntry,(1,1,0,),/Game/Gear/Weapons/_Shared/_Design/Balance/"
+                       "Balance_"
+                    << i << ".Balance_" << i << ",RarityData.BaseValueConstant,0,,1.0\n";
+            }
+        }
+
+        using clock = std::chrono::steady_clock;
+
+        auto mapped_start = clock::now();
+        mod_file_local mapped_file{path};
+        mapped_file.load();
+        mapped_file.join();
+        auto mapped_time = clock::now() - mapped_start;
 
+        auto stream_start = clock::now();
+        mod_file_local stream_file{path};
         std::ifstream stream{path};
-        if (!stream.is_open()) {
-            LOGE << "[OHL]: Error opening file '" << path;
-            return;
+        stream_file.load_from_stream(stream, true);
+        auto stream_time = clock::now() - stream_start;
+        stream.close();
+
+        REQUIRE(mapped_file.sections.size() == 1);
+        REQUIRE(stream_file.sections.size() == 1);
+        CHECK(ITERABLE_EQUAL(std::get<mod_data>(mapped_file.sections[0]).hotfixes,
+                             std::get<mod_data>(stream_file.sections[0]).hotfixes));
+
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        MESSAGE("Mapped: " << duration_cast<milliseconds>(mapped_time).count() << "ms, stream: "
+                           << duration_cast<milliseconds>(stream_time).count() << "ms");
+
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE_CLASS("loader::mod_file::load_from_view") {
+        const hotfix first{"SparkPatchEntry", "(1,1,0,),/First"};
+        const hotfix second{"SparkPatchEntry", "(1,1,0,),/Second"};
+
+        std::string contents;
+        std::vector<hotfix> expected;
+        bool same_as_stream = true;
+        SUBCASE("lf") {
+            contents = "SparkPatchEntry,(1,1,0,),/First\nSparkPatchEntry,(1,1,0,),/Second\n";
+            expected = {first, second};
+        }
+        SUBCASE("crlf") {
+            contents = "SparkPatchEntry,(1,1,0,),/First\r\nSparkPatchEntry,(1,1,0,),/Second\r\n";
+            expected = {first, second};
+            // Unlike a text mode file stream, a stringstream never translates line endings, so the
+            //  stream parse legitimately keeps the carriage returns
+            same_as_stream = false;
+        }
+        SUBCASE("no trailing newline") {
+            contents = "SparkPatchEntry,(1,1,0,),/First\n\n  \nSparkPatchEntry,(1,1,0,),/Second";
+            expected = {first, second};
+        }
+        SUBCASE("empty") {
+            contents = "";
+            expected = {};
         }
 
-        this->load_from_stream(stream, true);
+        mod_file_local file{"dummy"};
+        file.load_from_view(contents, false);
+
+        std::stringstream stream{contents};
+        mod_file_local stream_file{"dummy"};
+        stream_file.load_from_stream(stream, false);
+
+        if (expected.empty()) {
+            CHECK(file.sections.empty());
+            CHECK(stream_file.sections.empty());
+        } else {
+            REQUIRE(file.sections.size() == 1);
+            CHECK(ITERABLE_EQUAL(std::get<mod_data>(file.sections[0]).hotfixes, expected));
+
+            REQUIRE(stream_file.sections.size() == 1);
+            if (same_as_stream) {
+                CHECK(ITERABLE_EQUAL(std::get<mod_data>(file.sections[0]).hotfixes,
+                                     std::get<mod_data>(stream_file.sections[0]).hotfixes));
+            }
+        }
     }
 
     TEST_CASE_CLASS("loader::mod_file_local::load - load_from_stream identical") {
@@ -382,48 +1023,253 @@ class mod_file_local : public mod_file {
         CHECK(stream_data.hotfixes[0] == expected_hotfix);
     }
 
-    // Have to put this test here since it uses a protected method, and `mod_file` is abstract
-    TEST_CASE_CLASS("loader::mod_file::register_remote_file") {
-        known_mod_files.clear();
-        REQUIRE(known_mod_files.empty());
+    TEST_CASE_CLASS("loader::mod_file::load_from_view_parallel") {
+        auto original_mod_dir = mod_dir;
+        mod_dir = std::filesystem::path("tests");
+
+        std::string contents;
+        for (auto i = 0; i < 400; i++) {
+            if (i % 37 == 0) {
+                contents += "exec basic_mod.bl3hotfix\n";
+            } else if (i % 41 == 0) {
+                contents += "exec unicode_statement.bl3hotfix\r\n";
+            } else if (i % 53 == 0) {
+                contents += "InjectNewsItem,Header " + std::to_string(i) + "\n";
+            } else if (i % 29 == 0) {
+                contents += "SparkEarlyLevelPatchEntry,(1,11,0,Map" + std::to_string(i % 3)
+                            + "_P),/Game/Type11," + std::to_string(i) + "\n";
+            } else if (i % 7 == 0) {
+                contents += "  # comment\n\n";
+            } else {
+                contents += "SparkPatchEntry,(1,1,0,),/Game/Hotfix" + std::to_string(i) + "\r\n";
+            }
+        }
+        // No trailing newline on the last line
+        contents += "SparkPatchEntry,(1,1,0,),/Game/Last";
 
-        mod_file_local base{"base.bl3hotfix"};
-        REQUIRE(base.sections.empty());
+        known_mod_files.clear();
+        mod_file_local serial_file{"dummy"};
+        serial_file.load_from_view(contents, true);
+
+        for (size_t chunk_count = 1; chunk_count <= 9; chunk_count++) {
+            join_known_mod_files();
+            known_mod_files.clear();
+            mod_file_local parallel_file{"dummy"};
+            parallel_file.load_from_view_parallel(contents, true, chunk_count);
+
+            REQUIRE(parallel_file.sections.size() == serial_file.sections.size());
+            for (size_t i = 0; i < serial_file.sections.size(); i++) {
+                const auto& serial_section = serial_file.sections[i];
+                const auto& parallel_section = parallel_file.sections[i];
+                REQUIRE(serial_section.index() == parallel_section.index());
+
+                if (std::holds_alternative<remote_mod_data>(serial_section)) {
+                    CHECK(std::get<remote_mod_data>(serial_section).identifier
+                          == std::get<remote_mod_data>(parallel_section).identifier);
+                    continue;
+                }
 
-        std::shared_ptr<mod_file> remote = std::make_shared<mod_file_local>("remote.bl3hotfix");
+                const auto& serial_data = std::get<mod_data>(serial_section);
+                const auto& parallel_data = std::get<mod_data>(parallel_section);
+                CHECK(ITERABLE_EQUAL(serial_data.hotfixes, parallel_data.hotfixes));
+                CHECK(ITERABLE_EQUAL(serial_data.type_11_hotfixes, parallel_data.type_11_hotfixes));
+                CHECK(serial_data.type_11_maps == parallel_data.type_11_maps);
+                CHECK(ITERABLE_EQUAL(serial_data.news_items, parallel_data.news_items));
+            }
+        }
 
-        SUBCASE("Unknown file") {
-            base.register_remote_file(remote);
+        // More chunks than lines
+        mod_file_local tiny_file{"dummy"};
+        tiny_file.load_from_view_parallel("SparkPatchEntry,abc\n", true, 8);
+        REQUIRE(tiny_file.sections.size() == 1);
+        CHECK(std::get<mod_data>(tiny_file.sections[0]).hotfixes.size() == 1);
 
-            REQUIRE(base.sections.size() == 1);
-            auto section = base.sections[0];
+        join_known_mod_files();
+        known_mod_files.clear();
+        mod_dir = original_mod_dir;
+    }
 
-            REQUIRE(std::holds_alternative<remote_mod_data>(section));
-            auto remote_data = std::get<remote_mod_data>(section);
+    TEST_CASE_CLASS("loader::mod_file::load_from_view_parallel - nested in load tasks") {
+        static const size_t FILE_COUNT = 16;
+        static const size_t LINE_COUNT = 2000;
 
-            REQUIRE(remote_data.identifier == remote->get_identifier());
+        std::string contents;
+        for (size_t i = 0; i < LINE_COUNT; i++) {
+            contents += "SparkPatchEntry,(1,1,0,),/Game/Hotfix" + std::to_string(i) + "\n";
+        }
 
-            REQUIRE(known_mod_files.count(remote_data.identifier) == 1);
-            REQUIRE(known_mod_files.at(remote_data.identifier) == remote);
+        // More files, each split into more chunks, than there are workers. Every worker ends up
+        //  waiting on chunks while others are queued behind it, which must not deadlock.
+        auto& scheduler = get_load_scheduler();
+        auto chunk_count = ohl::args::parse_threads() * 4;
+        std::deque<mod_file_local> files{};
+        std::vector<std::future<void>> futures{};
+        for (size_t i = 0; i < FILE_COUNT; i++) {
+            auto& file = files.emplace_back("dummy");
+            futures.push_back(scheduler.submit(
+                [&]() { file.load_from_view_parallel(contents, false, chunk_count); }));
+        }
+        for (auto& future : futures) {
+            scheduler.wait(future);
+            future.get();
         }
 
-        SUBCASE("Known file") {
-            std::shared_ptr<mod_file> known_remote =
-                std::make_shared<mod_file_local>("remote.bl3hotfix");
-            REQUIRE(known_remote->get_identifier() == remote->get_identifier());
-            known_mod_files[known_remote->get_identifier()] = known_remote;
+        for (const auto& file : files) {
+            REQUIRE(file.sections.size() == 1);
+            CHECK(std::get<mod_data>(file.sections[0]).hotfixes.size() == LINE_COUNT);
+        }
+    }
 
-            base.register_remote_file(remote);
+    TEST_CASE_CLASS("loader::mod_file::load_from_view_parallel - scaling benchmark"
+                    * doctest::skip()) {
+        static const auto LINE_COUNT = 1000000;
 
-            REQUIRE(base.sections.size() == 1);
-            auto section = base.sections[0];
+        std::string contents;
+        for (auto i = 0; i < LINE_COUNT; i++) {
+            contents += "SparkPatchEntry,(1,1,0,),/Game/Gear/Weapons/_Shared/_Design/Balance/"
+                        "Balance_"
+                        + std::to_string(i) + ".Balance,RarityData.BaseValueConstant,0,,1.0\n";
+        }
 
-            REQUIRE(std::holds_alternative<remote_mod_data>(section));
-            auto remote_data = std::get<remote_mod_data>(section);
+        using clock = std::chrono::steady_clock;
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
 
-            REQUIRE(remote_data.identifier == remote->get_identifier());
+        milliseconds serial_time{};
+        auto max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+            mod_file_local file{"dummy"};
 
-            REQUIRE(known_mod_files.count(remote_data.identifier) == 1);
+            auto start = clock::now();
+            if (threads == 1) {
+                file.load_from_view(contents, false);
+            } else {
+                file.load_from_view_parallel(contents, false, threads);
+            }
+            auto time = duration_cast<milliseconds>(clock::now() - start);
+            if (threads == 1) {
+                serial_time = time;
+            }
+
+            REQUIRE(file.sections.size() == 1);
+            CHECK(std::get<mod_data>(file.sections[0]).hotfixes.size() == LINE_COUNT);
+
+            MESSAGE(threads << " threads: " << time.count() << "ms ("
+                            << (static_cast<double>(serial_time.count()) / time.count())
+                            << "x)");
+        }
+    }
+
+    TEST_CASE_CLASS("loader::mod_file_local - arena allocation benchmark" * doctest::skip()) {
+        static const auto LINE_COUNT = 500000;
+
+        std::string contents;
+        for (auto i = 0; i < LINE_COUNT; i++) {
+            if (i % 1000 == 0) {
+                contents += "InjectNewsItem,Header " + std::to_string(i)
+                            + ",https://example.com/image.png,https://example.com,Body\n";
+            } else if (i % 100 == 0) {
+                contents += "SparkLevelPatchEntry,(1,11,0,Map_" + std::to_string((i / 100) % 50)
+                            + "_P),/Game/Maps/Object.Object,Property,0,,1.0\n";
+            } else {
+                contents += "SparkPatchEntry,(1,1,0,),/Game/Gear/Weapons/_Shared/_Design/Balance/"
+                            "Balance_"
+                            + std::to_string(i) + ".Balance,RarityData.BaseValueConstant,0,,1.0\n";
+            }
+        }
+
+        // Counts every allocation which makes it to the heap
+        class counting_resource : public std::pmr::memory_resource {
+           public:
+            size_t count = 0;
+
+           protected:
+            void* do_allocate(size_t bytes, size_t alignment) override {
+                this->count++;
+                return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            }
+            void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+                std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+            }
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+                return this == &other;
+            }
+        };
+
+        using clock = std::chrono::steady_clock;
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+
+        for (auto use_arena : {false, true}) {
+            counting_resource counter{};
+            auto previous_default = std::pmr::set_default_resource(&counter);
+
+            auto start = clock::now();
+            auto file = std::make_unique<mod_file_local>(
+                "dummy", use_arena ? std::make_shared<ohl::util::arena>(&counter) : nullptr);
+            file->load_from_view(contents, false);
+            auto combined = std::make_unique<mod_data>(file->get_resource());
+            file->append_to(*combined);
+            auto load_time = duration_cast<milliseconds>(clock::now() - start);
+
+            auto hotfix_count = combined->hotfixes.size() + combined->type_11_hotfixes.size();
+
+            start = clock::now();
+            combined = nullptr;
+            file = nullptr;
+            auto release_time = duration_cast<milliseconds>(clock::now() - start);
+
+            std::pmr::set_default_resource(previous_default);
+
+            CHECK(hotfix_count == LINE_COUNT - (LINE_COUNT / 1000));
+            MESSAGE((use_arena ? "Arena: " : "Heap: ")
+                    << counter.count << " allocations, " << load_time.count() << "ms to load, "
+                    << release_time.count() << "ms to release");
+        }
+    }
+
+    // Have to put this test here since it uses a protected method, and `mod_file` is abstract
+    TEST_CASE_CLASS("loader::mod_file::register_remote_file") {
+        known_mod_files.clear();
+        REQUIRE(known_mod_files.empty());
+
+        mod_file_local base{"base.bl3hotfix"};
+        REQUIRE(base.sections.empty());
+
+        std::shared_ptr<mod_file> remote = std::make_shared<mod_file_local>("remote.bl3hotfix");
+
+        SUBCASE("Unknown file") {
+            base.register_remote_file(remote);
+
+            REQUIRE(base.sections.size() == 1);
+            auto section = base.sections[0];
+
+            REQUIRE(std::holds_alternative<remote_mod_data>(section));
+            auto remote_data = std::get<remote_mod_data>(section);
+
+            REQUIRE(remote_data.identifier == remote->get_identifier());
+
+            REQUIRE(known_mod_files.count(remote_data.identifier) == 1);
+            REQUIRE(known_mod_files.at(remote_data.identifier) == remote);
+        }
+
+        SUBCASE("Known file") {
+            std::shared_ptr<mod_file> known_remote =
+                std::make_shared<mod_file_local>("remote.bl3hotfix");
+            REQUIRE(known_remote->get_identifier() == remote->get_identifier());
+            known_mod_files[known_remote->get_identifier()] = known_remote;
+
+            base.register_remote_file(remote);
+
+            REQUIRE(base.sections.size() == 1);
+            auto section = base.sections[0];
+
+            REQUIRE(std::holds_alternative<remote_mod_data>(section));
+            auto remote_data = std::get<remote_mod_data>(section);
+
+            REQUIRE(remote_data.identifier == remote->get_identifier());
+
+            REQUIRE(known_mod_files.count(remote_data.identifier) == 1);
             REQUIRE(known_mod_files.at(remote_data.identifier) != remote);
             REQUIRE(known_mod_files.at(remote_data.identifier) == known_remote);
         }
@@ -435,6 +1281,7 @@ class mod_file_local : public mod_file {
 TEST_CASE("loader::mod_file::append_to") {
     mod_file_local file{std::filesystem::path("tests") / "basic_mod.bl3hotfix"};
     file.load();
+    file.join();
 
     REQUIRE(file.sections.size() == 1);
     REQUIRE(std::holds_alternative<mod_data>(file.sections[0]));
@@ -469,17 +1316,281 @@ TEST_CASE("loader::mod_file::append_to") {
     CHECK(ITERABLE_EQUAL(filled_data.news_items, file_data.news_items));
 }
 
+/**
+ * @brief Class holding a single chunk of a larger mod file, while it's being parsed in parallel.
+ * @note Only used as a temporary, the sections get moved back into the real file afterwards.
+ */
+class mod_file_chunk : public mod_file {
+   public:
+    using mod_file::mod_file;
+
+    virtual mod_file_identifier get_identifier(void) const {
+        throw std::runtime_error("Mod file chunks should not be treated as a mod file!");
+    }
+
+    virtual std::string get_display_name(void) const {
+        throw std::runtime_error("Mod file chunks should not be treated as a mod file!");
+    }
+
+    virtual void load(void) {}
+};
+
+/**
+ * @brief Class holding a mod file while it's parsed incrementally, as chunks of it arrive.
+ * @note Splits lines the same way `std::getline` does, so gives the exact same sections as
+ *       `load_from_stream`.
+ * @note Only used as a temporary, the sections get moved back into the real file afterwards.
+ */
+class mod_file_stream : public mod_file_chunk {
+   private:
+    mod_data data;
+    // The start of a line which ran over the end of the last chunk
+    std::string partial_line;
+    bool allow_exec;
+    // The files this one references, which only get registered once it's moved into a real file
+    std::vector<std::shared_ptr<mod_file>> remote_files;
+
+   protected:
+    virtual void register_remote_file(const std::shared_ptr<mod_file> file) {
+        this->sections.emplace_back(file->get_identifier());
+        this->remote_files.push_back(file);
+    }
+
+   public:
+    mod_file_stream(bool allow_exec, std::shared_ptr<std::pmr::memory_resource> arena = nullptr)
+        : mod_file_chunk(std::move(arena)), data(this->get_resource()), allow_exec(allow_exec) {}
+
+    void feed(std::string_view chunk);
+    void finish(void);
+
+    /**
+     * @brief Moves all the loaded sections into another file, and registers any files they
+     *        reference.
+     * @note Should only be called after finishing, and once the stream's contents are definitely
+     *       going to be used - registering files may start loading them.
+     *
+     * @param file The file to move the sections into.
+     */
+    void move_sections_to(mod_file& file) {
+        for (auto& section : this->sections) {
+            file.sections.push_back(std::move(section));
+        }
+        this->sections.clear();
+
+        for (const auto& remote : this->remote_files) {
+            add_known_file(remote);
+        }
+        this->remote_files.clear();
+    }
+
+    TEST_CASE_CLASS("loader::mod_file_stream - load_from_stream identical") {
+        std::string contents;
+        SUBCASE("crlf, no trailing newline") {
+            contents =
+                "SparkPatchEntry,(1,1,0,),/First\r\n\r\n  \r\nInjectNewsItem,Header,,,Body\r\n"
+                "SparkPatchEntry,(1,1,0,),/Second";
+        }
+        for (const auto& name : {"basic_mod.bl3hotfix", "easy_entry_to_fort_sunshine.bl3hotfix",
+                                 "news.bl3hotfix", "unicode_statement.bl3hotfix"}) {
+            SUBCASE(name) {
+                std::ifstream file{std::filesystem::path("tests") / name, std::ios::binary};
+                REQUIRE(file.is_open());
+                contents.assign(std::istreambuf_iterator<char>(file), {});
+            }
+        }
+
+        mod_file_stream stream_file{false};
+        std::stringstream stream{contents};
+        stream_file.load_from_stream(stream, false);
+
+        const size_t whole_file = contents.size() + 1;
+        for (size_t chunk_size : {(size_t)1, (size_t)2, (size_t)7, (size_t)4096, whole_file}) {
+            CAPTURE(chunk_size);
+
+            mod_file_stream streamed_file{false};
+            for (size_t pos = 0; pos < contents.size(); pos += chunk_size) {
+                streamed_file.feed(std::string_view(contents).substr(pos, chunk_size));
+            }
+            streamed_file.finish();
+
+            REQUIRE(streamed_file.sections.size() == stream_file.sections.size());
+            for (size_t i = 0; i < stream_file.sections.size(); i++) {
+                const auto& streamed_data = std::get<mod_data>(streamed_file.sections[i]);
+                const auto& stream_data = std::get<mod_data>(stream_file.sections[i]);
+                CHECK(ITERABLE_EQUAL(streamed_data.hotfixes, stream_data.hotfixes));
+                CHECK(
+                    ITERABLE_EQUAL(streamed_data.type_11_hotfixes, stream_data.type_11_hotfixes));
+                CHECK(streamed_data.type_11_maps == stream_data.type_11_maps);
+                CHECK(ITERABLE_EQUAL(streamed_data.news_items, stream_data.news_items));
+            }
+        }
+    }
+
+    TEST_CASE_CLASS("loader::mod_file_stream - streaming vs buffered benchmark" * doctest::skip()) {
+        static const size_t NUM_LINES = 50000;
+        static const size_t CHUNK_SIZE = 16 * 1024;
+        static const auto CHUNK_DELAY = std::chrono::milliseconds(2);
+
+        std::string body{};
+        for (size_t i = 0; i < NUM_LINES; i++) {
+            body += "SparkPatchEntry,(1,1,0,),/Game/Some/Object" + std::to_string(i)
+                    + ".Object,Property,0,,Value\r\n";
+        }
+
+        // Stands in for a slow connection, handing out the body a chunk at a time
+        auto throttled_download = [&](const ohl::cache::body_handler& on_body) {
+            for (size_t pos = 0; pos < body.size(); pos += CHUNK_SIZE) {
+                std::this_thread::sleep_for(CHUNK_DELAY);
+                on_body(std::string_view(body).substr(pos, CHUNK_SIZE));
+            }
+        };
+
+        using clock = std::chrono::high_resolution_clock;
+        auto report = [&](const char* name, clock::time_point start, clock::time_point received,
+                          size_t peak_buffered, const mod_file& file) {
+            auto now = clock::now();
+            auto total = std::chrono::duration_cast<std::chrono::milliseconds>(now - start);
+            auto after_last = std::chrono::duration_cast<std::chrono::microseconds>(now - received);
+            MESSAGE(name << ": " << total.count() << "ms total, " << after_last.count()
+                         << "us after the last chunk, " << peak_buffered
+                         << " bytes peak buffered, "
+                         << std::get<mod_data>(file.sections[0]).hotfixes.size() << " hotfixes");
+        };
+
+        {
+            auto start = clock::now();
+            std::string buffered{};
+            throttled_download([&](std::string_view chunk) { buffered.append(chunk); });
+            auto received = clock::now();
+
+            mod_file_stream file{false};
+            std::stringstream stream{std::move(buffered)};
+            file.load_from_stream(stream, false);
+            report("Buffered", start, received, body.size(), file);
+        }
+
+        {
+            auto start = clock::now();
+            mod_file_stream file{false};
+            size_t peak_buffered = 0;
+            throttled_download([&](std::string_view chunk) {
+                peak_buffered = std::max(peak_buffered, chunk.size() + file.partial_line.size());
+                file.feed(chunk);
+            });
+            auto received = clock::now();
+            file.finish();
+            report("Streamed", start, received, peak_buffered, file);
+        }
+    }
+};
+
+/**
+ * @brief Gets the scheduler url mods are downloaded on.
+ *
+ * @return The scheduler.
+ */
+static ohl::download::scheduler& get_download_scheduler(void) {
+    return ohl::util::leaked([] {
+        return ohl::download::scheduler(ohl::args::download_threads(),
+                                        ohl::args::downloads_per_host());
+    });
+}
+
+// Swapped out in tests, to avoid hitting the network
+static ohl::cache::http_fetcher url_fetcher = ohl::download::get;
+
+// When url mods should be done downloading by. Only set while loading the mods folder, so loading
+//  single files outside of a reload waits forever.
+static std::chrono::steady_clock::time_point download_deadline =
+    std::chrono::steady_clock::time_point::max();
+
+// Checked while waiting on url mods, they're given up on the same as if they ran out of time once
+//  it returns true. Only set while loading the mods folder, to let newer reloads cancel older ones.
+static std::function<bool(void)> load_cancelled{};
+// How often to check if the load was cancelled while waiting on url mods
+static const auto LOAD_CANCELLED_POLL_INTERVAL = std::chrono::milliseconds(20);
+
+// Set while pre-parsing in the background. Url mods only get registered then, not downloaded,
+//  since the next reload has to revalidate them anyway.
+static std::atomic<bool> preparsing{false};
+
 /**
  * @brief Class for mod file data based on a url.
  */
 class mod_file_url : public mod_file {
    private:
+    // Shared with the download task, so it can safely finish after we've given up on it
+    struct download_state {
+        std::mutex mutex;
+        bool finished = false;
+        bool abandoned = false;
+    };
+
     std::future<void> download;
+    std::shared_ptr<download_state> state;
+    // Set once joined, since joining consumes the download, or falls back to the cached copy
+    bool joined = false;
+
+    /**
+     * @brief Waits for the download to finish, giving up if the deadline passes or the load is
+     *        cancelled.
+     *
+     * @return True if the download finished.
+     */
+    bool wait_for_download(void) {
+        using clock = std::chrono::steady_clock;
+
+        while (true) {
+            if (load_cancelled && load_cancelled()) {
+                return this->download.wait_for(clock::duration::zero())
+                       == std::future_status::ready;
+            }
+
+            // Wake up every so often to check if we were cancelled
+            auto wake_time = download_deadline;
+            if (load_cancelled) {
+                wake_time = std::min(wake_time, clock::now() + LOAD_CANCELLED_POLL_INTERVAL);
+            }
+            if (wake_time == clock::time_point::max()) {
+                this->download.wait();
+                return true;
+            }
+
+            if (this->download.wait_until(wake_time) == std::future_status::ready) {
+                return true;
+            }
+            if (clock::now() >= download_deadline) {
+                return false;
+            }
+        }
+    }
+
+    /**
+     * @brief Parses the last good copy of a url in the url cache, if there is one.
+     *
+     * @param url The url to look up.
+     * @param arena The arena to allocate the parsed data from.
+     * @return The parsed file, or nullptr if there's no cached copy.
+     */
+    static std::unique_ptr<mod_file_stream> load_cached(
+        const std::string& url,
+        std::shared_ptr<std::pmr::memory_resource> arena) {
+        auto cached = url_cache.read(url);
+        if (!cached) {
+            return nullptr;
+        }
+
+        auto stream = std::make_unique<mod_file_stream>(false, std::move(arena));
+        stream->feed(cached->body);
+        stream->finish();
+        return stream;
+    }
 
    public:
     const std::string url;
 
-    mod_file_url(const std::string& url) : url(url) {}
+    mod_file_url(const std::string& url, std::shared_ptr<std::pmr::memory_resource> arena = nullptr)
+        : mod_file(std::move(arena)), url(url) {}
 
     virtual mod_file_identifier get_identifier(void) const { return this->url; }
 
@@ -512,29 +1623,120 @@ class mod_file_url : public mod_file {
               == "mod.bl3hotfix (url)");
     }
 
+    ~mod_file_url() {
+        // The download might outlive us, make sure it won't touch this file once it's gone
+        if (this->state) {
+            std::lock_guard<std::mutex> lock(this->state->mutex);
+            this->state->abandoned = true;
+        }
+    }
+
     virtual void load(void) {
+        if (preparsing) {
+            LOGD << "[OHL] Not downloading " << this->url << " while pre-parsing";
+            return;
+        }
+
         LOGD << "[OHL] Loading " << this->url;
 
-        this->download = cpr::GetCallback(
-            [&](const cpr::Response& resp) {
-                LOGD << "[OHL] Finished downloading " << this->url;
+        this->state = std::make_shared<download_state>();
+
+        auto host = ohl::download::get_host(this->url);
+        this->download = get_download_scheduler().submit(
+            std::move(host), [this, state = this->state, url = this->url, arena = this->arena]() {
+                // Parse as it downloads, into a file of our own, so that we never need to hold the
+                //  entire body, and so that we can throw it away if the download fails partway.
+                // Any files it references aren't registered until it's moved into this file, so a
+                //  download we've given up on never touches the loader's state.
+                auto stream = std::make_unique<mod_file_stream>(false, arena);
+                try {
+                    url_cache.get(url, url_fetcher,
+                                  [&](std::string_view chunk) { stream->feed(chunk); });
+                    stream->finish();
+                } catch (const std::runtime_error& ex) {
+                    stream = load_cached(url, arena);
+                    if (stream) {
+                        LOGE << "[OHL] Error downloading '" << url << "': " << ex.what()
+                             << ", using cached copy";
+                    } else {
+                        LOGE << "[OHL] Error downloading '" << url << "': " << ex.what();
+                        return;
+                    }
+                }
 
-                if (resp.status_code == 0) {
-                    LOGE << "[OHL] Error downloading '" << this->url << "': " << resp.error.message;
-                    return;
-                } else if (resp.status_code >= 400) {
-                    LOGE << "[OHL] Error downloading '" << this->url << "': " << resp.status_code;
+                // Once abandoned, this file might not even exist anymore, so don't touch it
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (state->abandoned) {
+                    LOGD << "[OHL] Finished downloading " << url << " after giving up on it";
                     return;
                 }
+                LOGD << "[OHL] Finished downloading " << url;
 
-                std::stringstream stream{resp.text};
+                stream->move_sections_to(*this);
+                state->finished = true;
+            });
+    }
 
-                this->load_from_stream(stream, false);
-            },
-            cpr::Url{this->url},
-            // An empty string tells libcurl to accept whatever encodings it can
-            cpr::AcceptEncoding{{""}});
-    };
+    TEST_CASE_CLASS("loader::mod_file_url::load - url cache") {
+        const std::string url = "https://example.com/mod.bl3hotfix";
+        const std::string body = "SparkPatchEntry,(1,1,0,),/Some/Hotfix\n";
+        const hotfix expected_hotfix{"SparkPatchEntry", "(1,1,0,),/Some/Hotfix"};
+
+        auto original_dir = url_cache.dir;
+        url_cache.dir = std::filesystem::temp_directory_path() / "ohl_url_load_test";
+        std::filesystem::remove_all(url_cache.dir);
+        url_cache.hits = 0;
+        url_cache.revalidations = 0;
+        url_cache.full_fetches = 0;
+
+        auto original_fetcher = url_fetcher;
+        bool online = true;
+        url_fetcher = [&](const std::string& request_url, const std::string& etag,
+                          const std::string&,
+                          const ohl::cache::body_handler& on_body) -> ohl::cache::http_response {
+            if (!online || request_url != url) {
+                return {0, "", "", "Couldn't connect to server"};
+            }
+            if (etag == "\"abc\"") {
+                return {304, etag, "", ""};
+            }
+            on_body(body);
+            return {200, "\"abc\"", "", ""};
+        };
+
+        auto load_hotfixes = [&](const std::string& load_url) {
+            mod_file_url file{load_url};
+            file.load();
+            file.join();
+
+            std::vector<hotfix> hotfixes{};
+            for (const auto& section : file.sections) {
+                const auto& data = std::get<mod_data>(section);
+                hotfixes.insert(hotfixes.end(), data.hotfixes.begin(), data.hotfixes.end());
+            }
+            return hotfixes;
+        };
+        const std::vector<hotfix> expected{expected_hotfix};
+
+        CHECK(load_hotfixes(url) == expected);
+        CHECK(url_cache.full_fetches == 1);
+
+        CHECK(load_hotfixes(url) == expected);
+        CHECK(url_cache.full_fetches == 1);
+        CHECK(url_cache.revalidations == 1);
+        CHECK(url_cache.hits == 1);
+
+        online = false;
+        CHECK(load_hotfixes(url) == expected);
+        CHECK(url_cache.hits == 2);
+
+        // Never been downloaded, so should fail to load, without throwing
+        CHECK(load_hotfixes("https://example.com/other.bl3hotfix").empty());
+
+        url_fetcher = original_fetcher;
+        std::filesystem::remove_all(url_cache.dir);
+        url_cache.dir = original_dir;
+    }
 
     TEST_CASE_CLASS("loader::mod_file_url::load - load_from_stream identica") {
         mod_file_url url_file{OHL_GITHUB_RAW_URL "tests/basic_mod.bl3hotfix"};
@@ -579,70 +1781,379 @@ class mod_file_url : public mod_file {
     }
 
     virtual void join(void) {
+        if (this->joined) {
+            return;
+        }
         if (!this->download.valid()) {
+            if (preparsing) {
+                return;
+            }
             throw std::runtime_error("Tried to join a url download before starting it!");
         }
+
+        if (!this->wait_for_download()) {
+            std::unique_lock<std::mutex> lock(this->state->mutex);
+            // Might have only just finished
+            if (!this->state->finished) {
+                this->state->abandoned = true;
+                lock.unlock();
+                this->joined = true;
+
+                auto stream = load_cached(this->url, this->arena);
+                if (stream) {
+                    LOGW << "[OHL] Gave up waiting for '" << this->url << "', using cached copy";
+                    stream->move_sections_to(*this);
+                } else {
+                    LOGE << "[OHL] Gave up waiting for '" << this->url
+                         << "', and there's no cached copy, skipping it";
+                }
+                return;
+            }
+        }
+
+        this->joined = true;
         this->download.get();
     }
-};
 
-/**
- * @brief Class for the `ohl-mods` mod "file".
- * @note Inheriting from the mod file base class for the merging logic.
- */
-class mods_folder : public mod_file {
-   public:
-    virtual mod_file_identifier get_identifier(void) const {
-        throw std::runtime_error("Mods folder should not be treated as a mod file!");
-    }
+    TEST_CASE_CLASS("loader::mod_file_url::join - download budget") {
+        static const auto BUDGET = std::chrono::milliseconds(100);
+        const std::string cached_url = "https://example.com/cached.bl3hotfix";
+        const std::string uncached_url = "https://example.com/uncached.bl3hotfix";
+        const hotfix expected_hotfix{"SparkPatchEntry", "(1,1,0,),/Some/Hotfix"};
+
+        auto original_dir = url_cache.dir;
+        url_cache.dir = std::filesystem::temp_directory_path() / "ohl_url_budget_test";
+        std::filesystem::remove_all(url_cache.dir);
+
+        // Stand-in server which stalls until released
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool stalling = false;
+        auto original_fetcher = url_fetcher;
+        url_fetcher = [&](const std::string&, const std::string&, const std::string&,
+                          const ohl::cache::body_handler& on_body) -> ohl::cache::http_response {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]() { return !stalling; });
+            on_body("SparkPatchEntry,(1,1,0,),/Some/Hotfix\n");
+            return {200, "", "", ""};
+        };
 
-    virtual std::string get_display_name(void) const {
-        throw std::runtime_error("Mods folder should not be treated as a mod file!");
-    }
+        // Get a good copy into the cache first
+        {
+            mod_file_url file{cached_url};
+            file.load();
+            file.join();
+        }
 
-    virtual void load(void) {
-        LOGI << "[OHL] Loading mods folder";
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stalling = true;
+        }
 
-        for (const auto& path : ohl::util::get_sorted_files_in_dir(mod_dir)) {
-            this->register_remote_file(std::make_shared<mod_file_local>(path));
+        mod_file_url cached_file{cached_url};
+        mod_file_url uncached_file{uncached_url};
+
+        auto start = std::chrono::steady_clock::now();
+        download_deadline = start + BUDGET;
+        cached_file.load();
+        uncached_file.load();
+        cached_file.join();
+        uncached_file.join();
+        // Joining again shouldn't load the cached copy twice
+        cached_file.join();
+        download_deadline = std::chrono::steady_clock::time_point::max();
+        auto time = std::chrono::steady_clock::now() - start;
+
+        CHECK(time < BUDGET * 10);
+
+        REQUIRE(cached_file.sections.size() == 1);
+        auto cached_data = std::get<mod_data>(cached_file.sections[0]);
+        REQUIRE(cached_data.hotfixes.size() == 1);
+        CHECK(cached_data.hotfixes[0] == expected_hotfix);
+
+        CHECK(uncached_file.sections.empty());
+
+        // Let the stalled downloads finish, they shouldn't touch the files anymore
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stalling = false;
         }
-    }
+        cv.notify_all();
+        cached_file.download.wait();
+        uncached_file.download.wait();
 
-    TEST_CASE_CLASS("loader::mods_folder::load") {
-        auto original_mod_dir = mod_dir;
-        mod_dir = std::filesystem::path("tests") / "sorted_files";
+        CHECK(cached_file.sections.size() == 1);
+        CHECK(uncached_file.sections.empty());
 
-        const std::vector<mod_file_identifier> expected_identifiers = {
-            "tests\\sorted_files\\1.txt",  "tests\\sorted_files\\5.txt",
-            "tests\\sorted_files\\10.txt", "tests\\sorted_files\\a.txt",
-            "tests\\sorted_files\\b.txt",  "tests\\sorted_files\\c.txt",
+        url_fetcher = original_fetcher;
+        std::filesystem::remove_all(url_cache.dir);
+        url_cache.dir = original_dir;
+    }
+
+    TEST_CASE_CLASS("loader::mod_file_url::join - cancelled") {
+        static const auto MAX_JOIN_TIME = std::chrono::seconds(5);
+        const std::string url = "https://example.com/cancelled.bl3hotfix";
+
+        auto original_dir = url_cache.dir;
+        url_cache.dir = std::filesystem::temp_directory_path() / "ohl_url_cancel_test";
+        std::filesystem::remove_all(url_cache.dir);
+
+        // Stand-in server which stalls until released
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool stalling = false;
+        auto original_fetcher = url_fetcher;
+        url_fetcher = [&](const std::string&, const std::string&, const std::string&,
+                          const ohl::cache::body_handler& on_body) -> ohl::cache::http_response {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]() { return !stalling; });
+            on_body("SparkPatchEntry,(1,1,0,),/Some/Hotfix\n");
+            return {200, "", "", ""};
         };
 
-        SUBCASE("") {
-            mods_folder folder;
-            folder.load();
-            folder.join();
+        {
+            mod_file_url file{url};
+            file.load();
+            file.join();
+        }
 
-            std::vector<mod_file_identifier> found_identifiers{};
-            std::transform(folder.sections.begin(), folder.sections.end(),
-                           std::back_inserter(found_identifiers), [](const auto& section) {
-                               REQUIRE(std::holds_alternative<remote_mod_data>(section));
-                               return std::get<remote_mod_data>(section).identifier;
-                           });
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stalling = true;
+        }
 
-            CHECK(ITERABLE_EQUAL(found_identifiers, expected_identifiers));
+        // Even without a deadline, cancelling should stop the wait
+        std::atomic<bool> cancelled{false};
+        load_cancelled = [&]() { return cancelled.load(); };
+
+        mod_file_url file{url};
+        auto start = std::chrono::steady_clock::now();
+        file.load();
+        auto joining = std::async(std::launch::async, [&]() { file.join(); });
+        CHECK(joining.wait_for(LOAD_CANCELLED_POLL_INTERVAL * 5) == std::future_status::timeout);
+
+        cancelled = true;
+        CHECK(joining.wait_for(MAX_JOIN_TIME) == std::future_status::ready);
+        joining.get();
+        load_cancelled = nullptr;
+        CHECK(std::chrono::steady_clock::now() - start < MAX_JOIN_TIME);
+
+        // Falls back to the cached copy
+        CHECK(file.sections.size() == 1);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stalling = false;
         }
+        cv.notify_all();
+        file.download.wait();
 
-        mod_dir = original_mod_dir;
+        url_fetcher = original_fetcher;
+        std::filesystem::remove_all(url_cache.dir);
+        url_cache.dir = original_dir;
     }
-};
 
-#pragma endregion
+    TEST_CASE_CLASS("loader::mod_file_url::join - abandoned downloads") {
+        static const auto BUDGET = std::chrono::milliseconds(50);
+        const std::string url = "https://example.com/abandoned.bl3hotfix";
 
-#pragma region Parsing
+        auto original_dir = url_cache.dir;
+        url_cache.dir = std::filesystem::temp_directory_path() / "ohl_url_abandoned_test";
+        std::filesystem::remove_all(url_cache.dir);
+        known_mod_files.clear();
 
-/**
- * @brief Parses a hotfix command, and appends it to the given mod data.
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool stalling = true;
+        auto original_fetcher = url_fetcher;
+        url_fetcher = [&](const std::string&, const std::string&, const std::string&,
+                          const ohl::cache::body_handler& on_body) -> ohl::cache::http_response {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]() { return !stalling; });
+            on_body("URL=https://example.com/nested.bl3hotfix\nexec nested.bl3hotfix\n");
+            return {200, "", "", ""};
+        };
+
+        auto file = std::make_unique<mod_file_url>(url);
+        download_deadline = std::chrono::steady_clock::now() + BUDGET;
+        file->load();
+        file->join();
+        download_deadline = std::chrono::steady_clock::time_point::max();
+        CHECK(file->sections.empty());
+
+        // Free the file before the download finishes, it must not touch it, nor register the
+        //  files it references
+        auto download = std::move(file->download);
+        file.reset();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stalling = false;
+        }
+        cv.notify_all();
+        download.wait();
+
+        {
+            std::lock_guard<std::mutex> lock(known_mod_files_mutex);
+            CHECK(known_mod_files.empty());
+        }
+
+        url_fetcher = original_fetcher;
+        std::filesystem::remove_all(url_cache.dir);
+        url_cache.dir = original_dir;
+    }
+};
+
+bool mod_file_local::load_now(const mod_file_local* previous) {
+    LOGD << "[OHL] Loading " << path;
+
+    // Parse straight out of a mapping where possible, this avoids copying every line.
+    // We deliberately don't keep the mapping around afterwards, since while it's open the file
+    //  can't be saved over, and people tend to edit their mods with the game open.
+    {
+        auto mtime = ohl::cache::get_mtime(path);
+        ohl::util::mapped_file mapping{path};
+        if (mapping.is_open()) {
+            auto contents = mapping.view();
+            this->stamp = ohl::cache::stamp_contents(path, mtime, contents);
+            if (previous != nullptr && this->reuse_if_unchanged(*previous)) {
+                return true;
+            }
+
+            auto threads = ohl::args::parse_threads();
+            if (threads > 1 && contents.size() >= ohl::args::parse_threshold()) {
+                LOGD << "[OHL] Parsing " << path << " in " << threads << " chunks";
+                this->load_from_view_parallel(contents, true, threads);
+            } else {
+                this->load_from_view(contents, true);
+            }
+            return false;
+        }
+    }
+
+    LOGD << "[OHL] Couldn't map " << path << ", falling back to a stream";
+
+    std::ifstream stream{path};
+    if (!stream.is_open()) {
+        if (!std::filesystem::exists(path)) {
+            this->stamp = ohl::cache::stamp_missing(path);
+            if (previous != nullptr && this->reuse_if_unchanged(*previous)) {
+                return true;
+            }
+        }
+        LOGE << "[OHL]: Error opening file '" << path;
+        return false;
+    }
+
+    this->load_from_stream(stream, true);
+    return false;
+}
+
+bool mod_file_local::reuse_if_unchanged(const mod_file_local& previous) {
+    if (!this->stamp || !previous.stamp || *this->stamp != *previous.stamp) {
+        return false;
+    }
+
+    // Make sure we still know how to recreate every file it references, before touching anything
+    std::vector<std::shared_ptr<mod_file>> remotes{};
+    {
+        // Other files are loading at the same time
+        std::lock_guard<std::mutex> lock(known_mod_files_mutex);
+        for (const auto& section : previous.sections) {
+            if (!std::holds_alternative<remote_mod_data>(section)) {
+                continue;
+            }
+            auto remote = previous_mod_files.find(std::get<remote_mod_data>(section).identifier);
+            if (remote == previous_mod_files.end()) {
+                return false;
+            }
+            remotes.push_back(remote->second);
+        }
+    }
+
+    LOGD << "[OHL] Reusing unchanged " << this->path;
+
+    // Copy over into our arena, so the previous reload's can be freed
+    auto remote = remotes.begin();
+    for (const auto& section : previous.sections) {
+        if (std::holds_alternative<mod_data>(section)) {
+            this->sections.emplace_back(std::in_place_type<mod_data>, std::get<mod_data>(section),
+                                        this->get_resource());
+            continue;
+        }
+
+        // Files we reference might have changed, so need to be registered again from scratch
+        if (auto remote_url = dynamic_cast<const mod_file_url*>(remote->get())) {
+            this->register_remote_file(
+                std::make_shared<mod_file_url>(remote_url->url, this->arena));
+        } else if (auto remote_local = dynamic_cast<const mod_file_local*>(remote->get())) {
+            this->register_remote_file(
+                std::make_shared<mod_file_local>(remote_local->path, this->arena));
+        }
+        remote++;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Class for the `ohl-mods` mod "file".
+ * @note Inheriting from the mod file base class for the merging logic.
+ */
+class mods_folder : public mod_file {
+   public:
+    using mod_file::mod_file;
+
+    virtual mod_file_identifier get_identifier(void) const {
+        throw std::runtime_error("Mods folder should not be treated as a mod file!");
+    }
+
+    virtual std::string get_display_name(void) const {
+        throw std::runtime_error("Mods folder should not be treated as a mod file!");
+    }
+
+    virtual void load(void) {
+        LOGI << "[OHL] Loading mods folder";
+
+        for (const auto& path : ohl::util::get_sorted_files_in_dir(mod_dir)) {
+            this->register_remote_file(std::make_shared<mod_file_local>(path, this->arena));
+        }
+    }
+
+    TEST_CASE_CLASS("loader::mods_folder::load") {
+        auto original_mod_dir = mod_dir;
+        mod_dir = std::filesystem::path("tests") / "sorted_files";
+
+        const std::vector<mod_file_identifier> expected_identifiers = {
+            "tests\\sorted_files\\1.txt",  "tests\\sorted_files\\5.txt",
+            "tests\\sorted_files\\10.txt", "tests\\sorted_files\\a.txt",
+            "tests\\sorted_files\\b.txt",  "tests\\sorted_files\\c.txt",
+        };
+
+        SUBCASE("") {
+            mods_folder folder;
+            folder.load();
+            folder.join();
+
+            std::vector<mod_file_identifier> found_identifiers{};
+            std::transform(folder.sections.begin(), folder.sections.end(),
+                           std::back_inserter(found_identifiers), [](const auto& section) {
+                               REQUIRE(std::holds_alternative<remote_mod_data>(section));
+                               return std::get<remote_mod_data>(section).identifier;
+                           });
+
+            CHECK(ITERABLE_EQUAL(found_identifiers, expected_identifiers));
+        }
+
+        mod_dir = original_mod_dir;
+    }
+};
+
+#pragma endregion
+
+#pragma region Parsing
+
+/**
+ * @brief Parses a hotfix command, and appends it to the given mod data.
  *
  * @param line The line to parse, without leading whitespace.
  * @param data The mod data object to append hotfixes to.
@@ -661,8 +2172,8 @@ static void parse_and_append_hotfix_cmd(const std::string_view& line, mod_data&
     // map_start_pos --------------------+      |
     // map_end_pos -----------------------------+
 
-    std::string key(line, 0, key_end_pos);
-    std::string value(line, key_end_pos + 1, std::string::npos);
+    auto key = line.substr(0, key_end_pos);
+    auto value = line.substr(key_end_pos + 1);
 
     // Check if it's a type 11, and extract the map
     auto type_start_pos = line.find_first_of(',', key_end_pos + 1) + 1;
@@ -934,65 +2445,432 @@ TEST_CASE("loader::parse_url_cmd") {
 }
 
 /**
- * @brief Loads this mod file from a stream.
+ * @brief Enum of the commands a mod line may start with.
+ */
+enum class mod_command { none, hotfix, news, exec, url };
+
+/**
+ * @brief Checks if a character counts as whitespace for the purposes of command detection.
+ * @note Matches `WHITESPACE`.
  *
- * @param stream The stream to read from.
- * @param allow_exec True if to allow running exec commands.
+ * @param c The character to check.
+ * @return True if the character is whitespace.
  */
-void mod_file::load_from_stream(std::istream& stream, bool allow_exec) {
-    mod_data data{};
+static constexpr bool is_whitespace(char c) {
+    return c == ' ' || c == '\f' || c == '\n' || c == '\r' || c == '\t' || c == '\b';
+}
+
+/**
+ * @brief Checks if a line starts with the given command, case insensitively.
+ * @note Only folds ascii, which is all commands contain.
+ *
+ * @param line The line to check, without leading whitespace.
+ * @param cmd The lowercase command to check for.
+ * @return True if the line starts with the command, false otherwise.
+ */
+static bool starts_with_command(std::string_view line, std::string_view cmd) {
+    if (line.size() < cmd.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < cmd.size(); i++) {
+        auto c = line[i];
+        if ('A' <= c && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        if (c != cmd[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Works out which command a line holds, without copying it.
+ *
+ * @param line The line to check. Will be modified to strip leading whitespace.
+ * @return The command the line starts with, or `mod_command::none`.
+ */
+static mod_command get_command(std::string_view& line) {
+    size_t whitespace_end_pos = 0;
+    while (whitespace_end_pos < line.size() && is_whitespace(line[whitespace_end_pos])) {
+        whitespace_end_pos++;
+    }
+    line.remove_prefix(whitespace_end_pos);
+    if (line.empty()) {
+        return mod_command::none;
+    }
 
-    for (std::string mod_line_str; std::getline(stream, mod_line_str);) {
-        std::string_view mod_line{mod_line_str};
+    // All commands start with a different letter, so we only ever need to do one full compare
+    switch (line[0]) {
+        case 'S':
+        case 's':
+            return starts_with_command(line, HOTFIX_COMMAND) ? mod_command::hotfix
+                                                             : mod_command::none;
+        case 'I':
+        case 'i':
+            return starts_with_command(line, NEWS_COMMAND) ? mod_command::news : mod_command::none;
+        case 'E':
+        case 'e':
+            return starts_with_command(line, EXEC_COMMAND) ? mod_command::exec : mod_command::none;
+        case 'U':
+        case 'u':
+            return starts_with_command(line, URL_COMMAND) ? mod_command::url : mod_command::none;
+        default:
+            return mod_command::none;
+    }
+}
 
-        auto whitespace_end_pos = mod_line.find_first_not_of(WHITESPACE);
-        if (whitespace_end_pos == std::string::npos) {
-            continue;
+TEST_CASE("loader::get_command") {
+    const std::vector<std::tuple<std::string, mod_command, std::string>> cases{
+        {"SparkPatchEntry,(1,1,0,),/Some/Hotfix", mod_command::hotfix,
+         "SparkPatchEntry,(1,1,0,),/Some/Hotfix"},
+        {" \t SPARKLevelPatchEntry,abc", mod_command::hotfix, "SPARKLevelPatchEntry,abc"},
+        {"sparky", mod_command::hotfix, "sparky"},
+        {"spar", mod_command::none, "spar"},
+        {"InjectNewsItem,Header", mod_command::news, "InjectNewsItem,Header"},
+        {"\finjectnewsitem", mod_command::news, "injectnewsitem"},
+        {"Inject", mod_command::none, "Inject"},
+        {"exec abc.bl3hotfix", mod_command::exec, "exec abc.bl3hotfix"},
+        {"\b\rEXECUTE", mod_command::exec, "EXECUTE"},
+        {"URL=https://example.com", mod_command::url, "URL=https://example.com"},
+        {"url https://example.com", mod_command::none, "url https://example.com"},
+        {"@title Some Mod", mod_command::none, "@title Some Mod"},
+        {"# exec commented.bl3hotfix", mod_command::none, "# exec commented.bl3hotfix"},
+        {"\xC3\xBAspark", mod_command::none, "\xC3\xBAspark"},
+        {"", mod_command::none, ""},
+        {"  \t  ", mod_command::none, ""},
+    };
+
+    for (const auto& [line, expected_cmd, expected_line] : cases) {
+        std::string_view view{line};
+        CHECK(get_command(view) == expected_cmd);
+        CHECK(view == expected_line);
+    }
+}
+
+/**
+ * @brief Finds the next newline in a buffer.
+ * @note Uses SSE2 to check 16 bytes at a time where available.
+ *
+ * @param str The buffer to search.
+ * @return The position of the first newline, or `std::string::npos` if there are none.
+ */
+static size_t find_newline(std::string_view str) {
+    size_t pos = 0;
+
+#ifdef OHL_SSE2
+    const auto newlines = _mm_set1_epi8('\n');
+    for (; pos + sizeof(__m128i) <= str.size(); pos += sizeof(__m128i)) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str.data() + pos));
+        uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newlines));
+        if (mask != 0) {
+#ifdef _MSC_VER
+            unsigned long idx;
+            _BitScanForward(&idx, mask);
+            return pos + idx;
+#else
+            return pos + __builtin_ctz(mask);
+#endif
         }
-        mod_line = mod_line.substr(whitespace_end_pos);
-
-        auto lower_mod_line = mod_line_str;
-        std::transform(lower_mod_line.begin(), lower_mod_line.end(), lower_mod_line.begin(),
-                       [](char c) { return std::tolower(c); });
-
-        /**
-         * @brief Checks if the current line starts with the specified command.
-         * @note Should compare against lowercase strings.
-         *
-         * @param cmd The command string to check.
-         * @return True if the line starts with the command, false otherwise.
-         */
-        auto is_command = [&](auto cmd) {
-            return lower_mod_line.compare(whitespace_end_pos, cmd.size(), cmd) == 0;
-        };
+    }
+#endif
+
+    for (; pos < str.size(); pos++) {
+        if (str[pos] == '\n') {
+            return pos;
+        }
+    }
+    return std::string::npos;
+}
+
+TEST_CASE("loader::find_newline") {
+    CHECK(find_newline("") == std::string::npos);
+    CHECK(find_newline("no newline here") == std::string::npos);
+    CHECK(find_newline("\n") == 0);
+    CHECK(find_newline("\r\n") == 1);
+
+    // Make sure we get the right answer on either side of each block boundary
+    for (size_t size = 1; size < 70; size++) {
+        for (size_t newline_pos = 0; newline_pos < size; newline_pos++) {
+            std::string str(size, 'a');
+            str[newline_pos] = '\n';
+            if (newline_pos + 1 < size) {
+                str[size - 1] = '\n';
+            }
+            REQUIRE(find_newline(str) == newline_pos);
+        }
+        REQUIRE(find_newline(std::string(size, 'a')) == std::string::npos);
+    }
+}
+
+TEST_CASE("loader::get_command - dispatch benchmark" * doctest::skip()) {
+    static const auto LINE_COUNT = 1000000;
+
+    std::string contents;
+    for (auto i = 0; i < LINE_COUNT; i++) {
+        switch (i % 8) {
+            case 0:
+                contents += "  exec some_other_mod.bl3hotfix\n";
+                break;
+            case 1:
+                contents += "InjectNewsItem,Header,https://example.com/image.png\n";
+                break;
+            case 2:
+                contents += "# A comment about the hotfixes below\n";
+                break;
+            default:
+                contents += "SparkPatchEntry,(1,1,0,),/Game/Gear/Weapons/_Shared/_Design/Balance/"
+                            "Balance_Thing.Balance_Thing,RarityData.BaseValueConstant,0,,1.0\n";
+                break;
+        }
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    // What load_from_stream used to do: copy and lowercase the whole line before comparing
+    size_t lowered_count = 0;
+    auto lowered_start = clock::now();
+    {
+        std::stringstream stream{contents};
+        for (std::string mod_line; std::getline(stream, mod_line);) {
+            auto whitespace_end_pos = mod_line.find_first_not_of(WHITESPACE);
+            if (whitespace_end_pos == std::string::npos) {
+                continue;
+            }
+            auto lower_mod_line = mod_line;
+            std::transform(lower_mod_line.begin(), lower_mod_line.end(), lower_mod_line.begin(),
+                           [](char c) { return std::tolower(c); });
+            for (const auto& cmd : {HOTFIX_COMMAND, NEWS_COMMAND, EXEC_COMMAND, URL_COMMAND}) {
+                if (lower_mod_line.compare(whitespace_end_pos, cmd.size(), cmd) == 0) {
+                    lowered_count++;
+                    break;
+                }
+            }
+        }
+    }
+    auto lowered_time = clock::now() - lowered_start;
+
+    size_t in_place_count = 0;
+    auto in_place_start = clock::now();
+    {
+        std::string_view remaining{contents};
+        while (!remaining.empty()) {
+            auto line_end_pos = find_newline(remaining);
+            auto mod_line = remaining.substr(0, line_end_pos);
+            if (get_command(mod_line) != mod_command::none) {
+                in_place_count++;
+            }
+            if (line_end_pos == std::string::npos) {
+                break;
+            }
+            remaining.remove_prefix(line_end_pos + 1);
+        }
+    }
+    auto in_place_time = clock::now() - in_place_start;
+
+    CHECK(lowered_count == in_place_count);
+
+    auto throughput = [&](auto time) {
+        auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(time).count();
+        return (contents.size() / (1024.0 * 1024.0)) / seconds;
+    };
+    MESSAGE("Lowercased copy: " << throughput(lowered_time)
+                                << " MB/s, in place: " << throughput(in_place_time) << " MB/s");
+}
 
-        if (is_command(HOTFIX_COMMAND)) {
+/**
+ * @brief Parses a single line of a mod file.
+ *
+ * @param mod_line The line to parse.
+ * @param data The mod data currently being built. May be pushed and replaced.
+ * @param allow_exec True if to allow running exec commands.
+ */
+void mod_file::load_line(std::string_view mod_line, mod_data& data, bool allow_exec) {
+    switch (get_command(mod_line)) {
+        case mod_command::hotfix:
             parse_and_append_hotfix_cmd(mod_line, data);
-        } else if (is_command(NEWS_COMMAND)) {
+            break;
+
+        case mod_command::news:
             parse_and_append_news_item_cmd(mod_line, data);
-        } else if (allow_exec && is_command(EXEC_COMMAND)) {
-            auto path = parse_exec_cmd(mod_line);
+            break;
+
+        case mod_command::exec: {
+            if (!allow_exec) {
+                break;
+            }
 
+            auto path = parse_exec_cmd(mod_line);
             if (path) {
                 // Push our current data, and create a new one for use after loading the file.
                 this->push_mod_data(data);
-                this->register_remote_file(std::make_shared<mod_file_local>(*path));
-                data = mod_data{};
+                this->register_remote_file(std::make_shared<mod_file_local>(*path, this->arena));
             }
-        } else if (is_command(URL_COMMAND)) {
-            auto url = parse_url_cmd(mod_line);
+            break;
+        }
 
+        case mod_command::url: {
+            auto url = parse_url_cmd(mod_line);
             if (url) {
                 this->push_mod_data(data);
-                this->register_remote_file(std::make_shared<mod_file_url>(*url));
-                data = mod_data{};
+                this->register_remote_file(std::make_shared<mod_file_url>(*url, this->arena));
             }
+            break;
+        }
+
+        case mod_command::none:
+            break;
+    }
+}
+
+/**
+ * @brief Loads this mod file from a stream.
+ *
+ * @param stream The stream to read from.
+ * @param allow_exec True if to allow running exec commands.
+ */
+void mod_file::load_from_stream(std::istream& stream, bool allow_exec) {
+    mod_data data{this->get_resource()};
+
+    for (std::string mod_line; std::getline(stream, mod_line);) {
+        this->load_line(mod_line, data, allow_exec);
+    }
+
+    this->push_mod_data(data);
+}
+
+/**
+ * @brief Loads this mod file from a view of it's full contents.
+ * @note Splits lines the same way a text mode stream does, so `\r\n` counts as a single newline.
+ *
+ * @param contents The full contents of the file.
+ * @param allow_exec True if to allow running exec commands.
+ */
+void mod_file::load_from_view(std::string_view contents, bool allow_exec) {
+    mod_data data{this->get_resource()};
+
+    while (!contents.empty()) {
+        auto line_end_pos = find_newline(contents);
+        auto mod_line = contents.substr(0, line_end_pos);
+
+        if (line_end_pos != std::string::npos && !mod_line.empty() && mod_line.back() == '\r') {
+            mod_line.remove_suffix(1);
+        }
+
+        this->load_line(mod_line, data, allow_exec);
+
+        if (line_end_pos == std::string::npos) {
+            break;
         }
+        contents.remove_prefix(line_end_pos + 1);
     }
 
     this->push_mod_data(data);
 }
 
+/**
+ * @brief Parses the next chunk of the file.
+ * @note Only whole lines are parsed, any partial line at the end is kept until the next chunk.
+ *
+ * @param chunk The chunk to parse.
+ */
+void mod_file_stream::feed(std::string_view chunk) {
+    while (true) {
+        auto line_end_pos = find_newline(chunk);
+        if (line_end_pos == std::string::npos) {
+            this->partial_line.append(chunk);
+            return;
+        }
+
+        // Avoid copying whenever the line's entirely in this chunk
+        if (this->partial_line.empty()) {
+            this->load_line(chunk.substr(0, line_end_pos), this->data, this->allow_exec);
+        } else {
+            this->partial_line.append(chunk.substr(0, line_end_pos));
+            this->load_line(this->partial_line, this->data, this->allow_exec);
+            this->partial_line.clear();
+        }
+
+        chunk.remove_prefix(line_end_pos + 1);
+    }
+}
+
+/**
+ * @brief Finishes parsing the file, including any final line without a trailing newline.
+ */
+void mod_file_stream::finish(void) {
+    if (!this->partial_line.empty()) {
+        this->load_line(this->partial_line, this->data, this->allow_exec);
+        this->partial_line.clear();
+    }
+    this->push_mod_data(this->data);
+}
+
+/**
+ * @brief Loads this mod file from a view of it's full contents, by splitting it into chunks and
+ *        parsing them in parallel.
+ * @note Gives the exact same sections as `load_from_view`.
+ *
+ * @param contents The full contents of the file.
+ * @param allow_exec True if to allow running exec commands.
+ * @param chunk_count How many chunks to split the file into. Each chunk is a separate task on the
+ *                    load scheduler.
+ */
+void mod_file::load_from_view_parallel(std::string_view contents,
+                                       bool allow_exec,
+                                       size_t chunk_count) {
+    // Split on newlines, as close to evenly sized chunks as we can
+    std::vector<std::string_view> chunk_views{};
+    size_t chunk_start = 0;
+    for (size_t i = 1; i <= chunk_count && chunk_start < contents.size(); i++) {
+        auto chunk_end = contents.size();
+        if (i < chunk_count) {
+            auto target = std::max(chunk_start, (contents.size() * i) / chunk_count);
+            auto newline_pos = find_newline(contents.substr(target));
+            if (newline_pos != std::string::npos) {
+                chunk_end = target + newline_pos + 1;
+            }
+        }
+
+        chunk_views.push_back(contents.substr(chunk_start, chunk_end - chunk_start));
+        chunk_start = chunk_end;
+    }
+
+    std::deque<mod_file_chunk> chunks{};
+    for (size_t i = 0; i < chunk_views.size(); i++) {
+        chunks.emplace_back(this->arena);
+    }
+    {
+        // Usually already on one of the load workers, queue the chunks there rather than starting
+        //  more threads, idle workers will steal them, and waiting runs them if nobody does
+        auto& scheduler = get_load_scheduler();
+        std::vector<std::future<void>> futures{};
+        for (size_t i = 0; i < chunks.size(); i++) {
+            futures.push_back(scheduler.submit(
+                [&, i]() { chunks[i].load_from_view(chunk_views[i], allow_exec); }));
+        }
+        // Wait for every chunk before rethrowing anything, they all reference our locals
+        for (const auto& future : futures) {
+            scheduler.wait(future);
+        }
+        for (auto& future : futures) {
+            future.get();
+        }
+    }
+
+    for (auto& chunk : chunks) {
+        for (auto& section : chunk.sections) {
+            // If data ran over a chunk boundary, a serial load would have kept it in one section
+            if (std::holds_alternative<mod_data>(section) && !this->sections.empty()
+                && std::holds_alternative<mod_data>(this->sections.back())) {
+                std::get<mod_data>(section).move_to(std::get<mod_data>(this->sections.back()));
+            } else {
+                this->sections.push_back(std::move(section));
+            }
+        }
+    }
+}
+
 TEST_CASE("loader::mod_file_local::load") {
     const hotfix basic_mod_hotfix{
         "SparkLevelPatchEntry",
@@ -1073,99 +2951,995 @@ TEST_CASE("loader::mod_file_local::load") {
     mod_file_local file{mod_dir / filename};
     file.load();
 
-    mod_data data;
-    file.append_to(data);
+    mod_data data;
+    file.append_to(data);
+
+    CHECK(ITERABLE_EQUAL(data.hotfixes, expected_data.hotfixes));
+    CHECK(ITERABLE_EQUAL(data.type_11_hotfixes, expected_data.type_11_hotfixes));
+    CHECK(ITERABLE_EQUAL(data.type_11_maps, expected_data.type_11_maps));
+    CHECK(ITERABLE_EQUAL(data.news_items, expected_data.news_items));
+
+    mod_dir = original_mod_dir;
+}
+
+#pragma endregion
+
+#pragma region Compaction
+
+// Only these keys get compacted, since they apply in a well defined order. Everything else is only
+//  used to work out what can't be compacted.
+static const std::array<std::string_view, 2> COMPACTABLE_KEYS = {
+    "SparkPatchEntry",
+    "SparkLevelPatchEntry",
+};
+
+// Hotfix types which are a plain write to an object's attribute, or a data table row's attribute
+static constexpr std::string_view PATCH_TYPE = "1";
+static constexpr std::string_view TABLE_TYPE = "2";
+
+/**
+ * @brief Struct holding the parts of a hotfix which compaction cares about.
+ * @note Views into the hotfix's key and value.
+ */
+struct hotfix_target {
+    // The object the hotfix touches
+    std::string_view object;
+    // Everything up to the end of the attribute, i.e. `(1,1,0,Package),/Some/Object,Attribute`.
+    //  Empty if the hotfix isn't a plain write which we know how to compare with others.
+    std::string_view target;
+    // If the hotfix only applies when the attribute currently holds a specific value
+    bool conditional;
+};
+
+/**
+ * @brief Parses the target of a hotfix.
+ *
+ * @param hotfix The hotfix to parse.
+ * @return The hotfix's target, or std::nullopt if we can't even tell which object it touches.
+ */
+static std::optional<hotfix_target> parse_hotfix_target(const hotfix& hotfix) {
+    std::string_view value = hotfix.value;
+
+    // (1,1,0,Package),/Some/Object,Attribute,0,,NewValue
+    // (1,2,0,Package),/Some/Table,Row,Attribute,0,,NewValue
+    if (value.empty() || value[0] != '(') {
+        return std::nullopt;
+    }
+    auto prefix_end = value.find(')');
+    if (prefix_end == std::string_view::npos || prefix_end + 1 >= value.size()
+        || value[prefix_end + 1] != ',') {
+        return std::nullopt;
+    }
+
+    auto type_start = value.find(',') + 1;
+    auto type_end = value.find(',', type_start);
+    if (type_end >= prefix_end) {
+        return std::nullopt;
+    }
+    auto type = value.substr(type_start, type_end - type_start);
+
+    auto pos = prefix_end + 2;
+    auto next_field = [&]() -> std::optional<std::string_view> {
+        auto end = value.find(',', pos);
+        if (end == std::string_view::npos) {
+            return std::nullopt;
+        }
+        auto field = value.substr(pos, end - pos);
+        pos = end + 1;
+        return field;
+    };
+
+    auto object = next_field();
+    if (!object) {
+        return std::nullopt;
+    }
+    hotfix_target parsed{*object, {}, true};
+
+    if (std::find(COMPACTABLE_KEYS.begin(), COMPACTABLE_KEYS.end(), hotfix.get_key())
+            == COMPACTABLE_KEYS.end()
+        || (type != PATCH_TYPE && type != TABLE_TYPE)) {
+        return parsed;
+    }
+
+    // Skip the row name
+    if (type == TABLE_TYPE && !next_field()) {
+        return parsed;
+    }
+    if (!next_field()) {
+        return parsed;
+    }
+    auto target_end = pos - 1;
+
+    // Length of the value the attribute must currently hold, 0 if unconditional
+    auto from_length = next_field();
+    if (!from_length) {
+        return parsed;
+    }
+
+    parsed.target = value.substr(0, target_end);
+    parsed.conditional = *from_length != "0";
+    return parsed;
+}
+
+/**
+ * @brief Reads up to 8 chars of a string, lowercasing any ascii letters.
+ *
+ * @param str The string to read from.
+ * @param pos The offset to start reading at.
+ * @return The lowercased chars, zero padded if there were less than 8 left.
+ */
+static uint64_t read_folded_word(std::string_view str, size_t pos) {
+    static constexpr uint64_t ONES = 0x0101010101010101;
+    static constexpr uint64_t HIGH_BITS = ONES * 0x80;
+
+    uint64_t word = 0;
+    if (str.size() - pos >= sizeof(word)) {
+        memcpy(&word, str.data() + pos, sizeof(word));
+    } else {
+        memcpy(&word, str.data() + pos, str.size() - pos);
+    }
+
+    // Sets the high bit of every byte in the range 'A' to 'Z', without carrying between bytes
+    auto low_bits = word & ~HIGH_BITS;
+    auto at_least_a = low_bits + (ONES * (0x80 - 'A'));
+    auto above_z = low_bits + (ONES * (0x7F - 'Z'));
+    auto upper = (at_least_a ^ above_z) & ~word & HIGH_BITS;
+
+    return word | (upper >> 2);
+}
+
+/**
+ * @brief Hashes a name, ignoring case.
+ * @note Unreal compares package, object, row, and attribute names case insensitively, so compaction
+ *       must too, or a differently cased barrier wouldn't stop earlier writes being dropped.
+ *
+ * @param name The name to hash.
+ * @return The hash.
+ */
+static size_t hash_folded(std::string_view name) {
+    uint64_t hash = name.size();
+    for (size_t pos = 0; pos < name.size(); pos += sizeof(uint64_t)) {
+        hash = (((hash << 5) | (hash >> 59)) ^ read_folded_word(name, pos)) * 0x9E3779B97F4A7C15;
+    }
+    return static_cast<size_t>(hash ^ (hash >> 29));
+}
+
+/**
+ * @brief Compares two names, ignoring case.
+ *
+ * @param lhs The first name.
+ * @param rhs The second name.
+ * @return True if the names are equal.
+ */
+static bool equal_folded(std::string_view lhs, std::string_view rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    // Names are almost always cased consistently
+    if (lhs == rhs) {
+        return true;
+    }
+    for (size_t pos = 0; pos < lhs.size(); pos += sizeof(uint64_t)) {
+        if (read_folded_word(lhs, pos) != read_folded_word(rhs, pos)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("loader::equal_folded") {
+    CHECK(equal_folded("/Game/Some_Long_Object.Name", "/game/SOME_LONG_OBJECT.name"));
+    CHECK(hash_folded("/Game/Some_Long_Object.Name") == hash_folded("/game/SOME_LONG_OBJECT.name"));
+    CHECK(equal_folded("", ""));
+
+    // Only ascii letters get folded, not their neighbours, or anything with the high bit set
+    CHECK_FALSE(equal_folded("@[`{", "`{@["));
+    CHECK_FALSE(equal_folded("\xC1\xDA", "\xE1\xFA"));
+    CHECK_FALSE(equal_folded("/Game/Obj", "/Game/Obj2"));
+    CHECK_FALSE(equal_folded("/Game/Some_Long_Object.Name", "/Game/Some_Long_Object.Nane"));
+}
+
+/**
+ * @brief Drops hotfixes which are fully overwritten by a later one, without reordering the rest.
+ * @note A hotfix is only dropped if a later unconditional one writes the exact same target, with
+ *       the same key, type, package, object, and attribute, and nothing in between might read it.
+ *       Names are compared case insensitively, the same as unreal does.
+ *       Conditional hotfixes and anything other than a plain type 1 or 2 write, including type 11s
+ *       and their delays, stop any hotfix on the same object being dropped across them.
+ *
+ * @param hotfixes The hotfixes to compact.
+ * @return How many hotfixes were dropped.
+ */
+static size_t compact_hotfixes(std::pmr::deque<hotfix>& hotfixes) {
+    struct folded_hash {
+        size_t operator()(std::string_view name) const { return hash_folded(name); }
+    };
+    struct folded_equal {
+        bool operator()(std::string_view lhs, std::string_view rhs) const {
+            return equal_folded(lhs, rhs);
+        }
+    };
+
+    // The key must match exactly, only the names in the target are case insensitive
+    using target_key = std::pair<std::string_view, std::string_view>;
+    struct target_key_hash {
+        size_t operator()(const target_key& key) const {
+            auto hash = std::hash<std::string_view>{}(key.first);
+            return hash ^ (hash_folded(key.second) + 0x9E3779B97F4A7C15 + (hash << 6)
+                           + (hash >> 2));
+        }
+    };
+    struct target_key_equal {
+        bool operator()(const target_key& lhs, const target_key& rhs) const {
+            return lhs.first == rhs.first && equal_folded(lhs.second, rhs.second);
+        }
+    };
+
+    // Rather than clearing everything a barrier affects, each barrier bumps an epoch, and a write
+    //  only covers earlier ones while the epochs it saw are still current
+    struct coverage {
+        size_t object_epoch;
+        size_t global_epoch;
+    };
+    std::unordered_map<std::string_view, size_t, folded_hash, folded_equal> object_epochs{};
+    std::unordered_map<target_key, coverage, target_key_hash, target_key_equal> covered{};
+    size_t global_epoch = 0;
+    object_epochs.reserve(hotfixes.size());
+    covered.reserve(hotfixes.size());
+
+    std::vector<bool> keep(hotfixes.size(), true);
+    size_t dropped = 0;
+
+    // Walk backwards, so we've always seen every later hotfix already
+    for (size_t i = hotfixes.size(); i-- > 0;) {
+        const auto& hotfix = hotfixes[i];
+        auto parsed = parse_hotfix_target(hotfix);
+        if (!parsed) {
+            // Could touch anything
+            global_epoch++;
+            continue;
+        }
+
+        auto& object_epoch = object_epochs[parsed->object];
+        if (parsed->target.empty()) {
+            object_epoch++;
+            continue;
+        }
+
+        target_key key{hotfix.get_key(), parsed->target};
+        auto existing = covered.find(key);
+        if (existing != covered.end() && existing->second.object_epoch == object_epoch
+            && existing->second.global_epoch == global_epoch) {
+            // Since it never runs, it doesn't act as a barrier either
+            keep[i] = false;
+            dropped++;
+            continue;
+        }
+
+        if (parsed->conditional) {
+            // Reads the attribute, which might overlap with any other attribute on the object
+            object_epoch++;
+        } else if (existing != covered.end()) {
+            existing->second = {object_epoch, global_epoch};
+        } else {
+            covered.emplace(key, coverage{object_epoch, global_epoch});
+        }
+    }
+
+    if (dropped == 0) {
+        return 0;
+    }
+
+    size_t kept_count = 0;
+    for (size_t i = 0; i < hotfixes.size(); i++) {
+        if (keep[i]) {
+            if (kept_count != i) {
+                hotfixes[kept_count] = std::move(hotfixes[i]);
+            }
+            kept_count++;
+        }
+    }
+    hotfixes.erase(hotfixes.begin() + kept_count, hotfixes.end());
+
+    return dropped;
+}
+
+TEST_CASE("loader::compact_hotfixes") {
+    auto compact = [](std::pmr::deque<hotfix> hotfixes,
+                      const std::pmr::deque<hotfix>& expected) {
+        auto original_size = hotfixes.size();
+        auto dropped = compact_hotfixes(hotfixes);
+        CHECK(ITERABLE_EQUAL(hotfixes, expected));
+        CHECK(dropped == original_size - expected.size());
+    };
+
+    const hotfix first{"SparkPatchEntry", "(1,1,0,),/Game/Obj.Obj,Attr,0,,1"};
+    const hotfix second{"SparkPatchEntry", "(1,1,0,),/Game/Obj.Obj,Attr,0,,2"};
+    const hotfix other_attr{"SparkPatchEntry", "(1,1,0,),/Game/Obj.Obj,Other,0,,3"};
+    const hotfix other_obj{"SparkPatchEntry", "(1,1,0,),/Game/Other.Other,Attr,0,,4"};
+
+    SUBCASE("overwritten") {
+        compact({first, other_attr, second, other_obj}, {other_attr, second, other_obj});
+        compact({first, first, first}, {first});
+        compact({first, other_obj}, {first, other_obj});
+        compact({}, {});
+    }
+
+    SUBCASE("conditional") {
+        const hotfix conditional{"SparkPatchEntry", "(1,1,0,),/Game/Obj.Obj,Attr,1,1,2"};
+        const hotfix conditional_commas{"SparkPatchEntry",
+                                        "(1,1,0,),/Game/Obj.Obj,Attr,5,(a,b),(c,d)"};
+
+        // A conditional hotfix doesn't always overwrite, but is always overwritten
+        compact({first, conditional}, {first, conditional});
+        compact({conditional, conditional_commas, second}, {second});
+
+        // Reading the attribute might read others on the same object, which must be kept
+        const hotfix conditional_other{"SparkPatchEntry", "(1,1,0,),/Game/Obj.Obj,Other,1,3,4"};
+        compact({first, conditional_other, second}, {first, conditional_other, second});
+        compact({other_obj, conditional_other, other_obj}, {conditional_other, other_obj});
+
+        // Unless it's dropped itself
+        compact({first, conditional_other, other_attr, second}, {other_attr, second});
+        compact({first, conditional_other, second, other_attr}, {second, other_attr});
+    }
+
+    SUBCASE("scopes") {
+        const hotfix level{"SparkLevelPatchEntry", "(1,1,0,Map_P),/Game/Obj.Obj,Attr,0,,1"};
+        const hotfix level_again{"SparkLevelPatchEntry", "(1,1,0,Map_P),/Game/Obj.Obj,Attr,0,,2"};
+        const hotfix other_map{"SparkLevelPatchEntry", "(1,1,0,Other_P),/Game/Obj.Obj,Attr,0,,2"};
+
+        compact({level, other_map}, {level, other_map});
+        compact({level, level_again}, {level_again});
+        compact({first, level}, {first, level});
+        compact({level, first}, {level, first});
+
+        const hotfix row{"SparkPatchEntry", "(1,2,0,),/Game/Table.Table,Row,Attr,0,,1"};
+        const hotfix row_again{"SparkPatchEntry", "(1,2,0,),/Game/Table.Table,Row,Attr,0,,2"};
+        const hotfix other_row{"SparkPatchEntry", "(1,2,0,),/Game/Table.Table,Other,Attr,0,,2"};
+        compact({row, other_row, row_again}, {other_row, row_again});
+    }
+
+    SUBCASE("case insensitive") {
+        const hotfix lower{"SparkPatchEntry", "(1,1,0,),/game/obj.obj,attr,0,,2"};
+        compact({first, lower}, {lower});
+        compact({lower, first}, {first});
+
+        // A differently cased read still blocks dropping writes it might read
+        const hotfix conditional_lower{"SparkPatchEntry", "(1,1,0,),/game/obj.obj,other,1,3,4"};
+        compact({first, conditional_lower, second}, {first, conditional_lower, second});
+
+        const hotfix type_11_upper{"SparkLevelPatchEntry",
+                                   "(1,11,0,Map_P),/GAME/OBJ.OBJ,Attr,0,,1"};
+        compact({first, type_11_upper, second}, {first, type_11_upper, second});
+
+        // The key itself isn't a name
+        const hotfix level{"SparkLevelPatchEntry", "(1,1,0,),/Game/Obj.Obj,Attr,0,,1"};
+        compact({first, level}, {first, level});
+    }
+
+    SUBCASE("barriers") {
+        const hotfix type_11{"SparkLevelPatchEntry", "(1,11,0,Map_P),/Game/Obj.Obj,Attr,0,,1"};
+        const hotfix early{"SparkEarlyLevelPatchEntry", "(1,1,0,Map_P),/Game/Obj.Obj,Attr,0,,1"};
+        const hotfix other_type{"SparkPatchEntry", "(1,6,0,),/Game/Obj.Obj,Attr,0,,1"};
+        const hotfix custom{"SparkSomeNewEntry", "(1,1,0,),/Game/Obj.Obj,Attr,0,,1"};
+        const hotfix garbage{"SparkPatchEntry", "garbage"};
+
+        for (const auto& barrier : {type_11, early, other_type, custom, garbage}) {
+            CAPTURE(barrier.value);
+            compact({first, barrier, second}, {first, barrier, second});
+            compact({barrier, barrier}, {barrier, barrier});
+        }
+
+        // Other objects aren't affected, unless we couldn't tell which object it was
+        compact({other_obj, type_11, other_obj}, {type_11, other_obj});
+        compact({other_obj, garbage, other_obj}, {other_obj, garbage, other_obj});
+    }
+}
+
+TEST_CASE("loader::compact_hotfixes - benchmark" * doctest::skip()) {
+    static const auto HOTFIX_COUNT = 200000;
+
+    // Every object gets patched by a few different "mods"
+    std::pmr::deque<hotfix> hotfixes{};
+    for (auto i = 0; i < HOTFIX_COUNT; i++) {
+        hotfixes.emplace_back("SparkPatchEntry",
+                              "(1,1,0,),/Game/Gear/Weapons/_Shared/_Design/Balance/Balance_"
+                                  + std::to_string(i % (HOTFIX_COUNT / 4))
+                                  + ".Balance,RarityData.BaseValueConstant,0,,"
+                                  + std::to_string(i));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto dropped = compact_hotfixes(hotfixes);
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    CHECK(dropped == HOTFIX_COUNT / 4 * 3);
+    MESSAGE("Compacted " << HOTFIX_COUNT << " hotfixes in " << time.count() << "ms, dropped "
+                         << dropped);
+}
+
+/**
+ * @brief Compacts the combined hotfixes, if enabled.
+ *
+ * @param hotfixes The hotfixes to compact.
+ */
+static void compact_if_enabled(std::pmr::deque<hotfix>& hotfixes) {
+    if (!ohl::args::compact_hotfixes()) {
+        return;
+    }
+
+    LOGD << "[OHL] Compacting hotfixes";
+    auto dropped = compact_hotfixes(hotfixes);
+    LOGI << "[OHL] Dropped " << dropped << " hotfixes which were overwritten by later ones";
+}
+
+#pragma endregion
+
+/**
+ * @brief Creates the news item for OHL.
+ *
+ * @param hotfix_count The amount of injected hotfixes
+ * @param file_order The display names of the injected mod files, in the order they were loaded.
+ * @return The OHL news item.
+ */
+static news_item get_ohl_news_item(size_t hotfix_count,
+                                   const std::vector<std::string>& file_order) {
+    // If we're in BL3, colour the name.
+    // WL doesn't support font tags :(
+    std::string ohl_name;
+    if (ohl::args::exe_path().stem() == "Borderlands3") {
+        ohl_name =
+            "<font color='#0080E0'>OHL</font><font size='14' color='#C0C0C0'> " VERSION_STRING
+            "</font>";
+    } else {
+        ohl_name = "OHL " VERSION_STRING;
+    }
+
+    std::string header;
+    if (hotfix_count > 1) {
+        header = ohl_name + ": " + std::to_string(hotfix_count) + " hotfixes loaded";
+    } else if (hotfix_count == 1) {
+        header = ohl_name + ": 1 hotfix loaded";
+    } else {
+        header = ohl_name + ": No hotfixes loaded";
+    }
+
+    std::string body;
+    if (hotfix_count == 0) {
+        body = "No hotfixes loaded";
+    } else {
+        std::stringstream stream{};
+        stream << "Loaded files:\n";
+
+        for (const auto& name : file_order) {
+            stream << name << ",\n";
+        }
+
+        body = stream.str();
+    }
+
+    return {header, OHL_NEWS_ITEM_IMAGE_URL, OHL_NEWS_ITEM_ARTICLE_URL, body};
+}
+
+TEST_CASE("loader::get_ohl_news_item") {
+    auto empty_news = get_ohl_news_item(0, {});
+    CHECK(empty_news.header == "OHL " VERSION_STRING ": No hotfixes loaded");
+    CHECK(empty_news.image_url == OHL_NEWS_ITEM_IMAGE_URL);
+    CHECK(empty_news.article_url == OHL_NEWS_ITEM_ARTICLE_URL);
+    CHECK(empty_news.body == "No hotfixes loaded");
+
+    auto one_news = get_ohl_news_item(1, {});
+    CHECK(one_news.header == "OHL " VERSION_STRING ": 1 hotfix loaded");
+    CHECK(one_news.image_url == OHL_NEWS_ITEM_IMAGE_URL);
+    CHECK(one_news.article_url == OHL_NEWS_ITEM_ARTICLE_URL);
+    // Going to leave body formatting indeterminate for >0
+
+    auto multi_news = get_ohl_news_item(1234, {});
+    CHECK(multi_news.header == "OHL " VERSION_STRING ": 1234 hotfixes loaded");
+    CHECK(multi_news.image_url == OHL_NEWS_ITEM_IMAGE_URL);
+    CHECK(multi_news.article_url == OHL_NEWS_ITEM_ARTICLE_URL);
+}
+
+#pragma region Public interface
+
+static std::mutex cache_file_mutex;
+
+/**
+ * @brief Runs reloads on a persistent thread, coalescing requests which come in while one's
+ *        already running.
+ * @note Requesting a reload never waits on the reload thread, so it's safe to call from the game
+ *       thread.
+ */
+class reload_controller {
+   public:
+    using generation = uint64_t;
+    using work_fn = std::function<void(generation)>;
+
+   private:
+    work_fn work;
+
+    std::mutex mutex;
+    std::condition_variable requested_cv;
+    std::condition_variable completed_cv;
+    std::atomic<generation> requested;
+    generation completed;
+    bool stopping;
+    std::thread thread;
+
+    /**
+     * @brief Main loop of the reload thread.
+     */
+    void run(void) {
+        SetThreadDescription(GetCurrentThread(), L"OpenHotfixLoader Loader");
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (true) {
+            this->requested_cv.wait(
+                lock, [&]() { return this->stopping || this->requested > this->completed; });
+            if (this->stopping) {
+                return;
+            }
+
+            // Everything requested up to now gets handled by this one run
+            auto target = this->requested.load();
+            lock.unlock();
+
+            try {
+                this->work(target);
+            } catch (const std::exception& ex) {
+                LOGE << "[OHL] Exception occured while reloading: " << ex.what();
+            }
+
+            // If superseded, the next run completes it instead
+            if (!this->is_superseded(target)) {
+                this->complete(target);
+            }
+
+            lock.lock();
+        }
+    }
+
+   public:
+    reload_controller(work_fn work)
+        : work(std::move(work)), requested(0), completed(0), stopping(false) {}
+
+    /**
+     * @brief Stops the reload thread, after waiting for any running reload to finish.
+     */
+    ~reload_controller() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->requested_cv.notify_all();
+        this->completed_cv.notify_all();
+
+        if (this->thread.joinable()) {
+            this->thread.join();
+        }
+    }
+
+    reload_controller(const reload_controller&) = delete;
+    reload_controller& operator=(const reload_controller&) = delete;
+
+    /**
+     * @brief Requests a reload.
+     * @note If one's already running, it gets cancelled, and a single new one runs afterwards.
+     *
+     * @return The generation of the requested reload.
+     */
+    generation request(void) {
+        generation requested_generation;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            requested_generation = ++this->requested;
+
+            // Only started on first use, since creating threads while the dll's being loaded can
+            //  deadlock
+            if (!this->thread.joinable()) {
+                this->thread = std::thread(&reload_controller::run, this);
+            }
+        }
+        this->requested_cv.notify_one();
+
+        return requested_generation;
+    }
+
+    /**
+     * @brief Checks if a reload has been superseded by a newer request, and should be cancelled.
+     *
+     * @param target The generation of the reload to check.
+     * @return True if a newer reload has been requested.
+     */
+    bool is_superseded(generation target) const { return this->requested > target; }
+
+    /**
+     * @brief Marks a reload as completed, waking anyone waiting on it.
+     * @note The reload may call this itself as soon as it's published it's data, so that any
+     *       cleanup afterwards doesn't block anyone.
+     *
+     * @param target The generation of the completed reload.
+     */
+    void complete(generation target) {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->completed = std::max(this->completed, target);
+        }
+        this->completed_cv.notify_all();
+    }
+
+    /**
+     * @brief Waits until every reload requested before calling this has completed.
+     */
+    void wait(void) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        auto target = this->requested.load();
+        this->completed_cv.wait(lock,
+                                [&]() { return this->stopping || this->completed >= target; });
+    }
+};
+
+TEST_CASE("loader::reload_controller - coalescing bursts") {
+    static const size_t BURST_SIZE = 100;
+    static const auto RELOAD_TIME = std::chrono::milliseconds(50);
+
+    std::mutex mutex;
+    std::vector<reload_controller::generation> runs{};
+    std::promise<void> first_started{};
+
+    reload_controller controller{[&](reload_controller::generation generation) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            runs.push_back(generation);
+            if (runs.size() == 1) {
+                first_started.set_value();
+            }
+        }
+        std::this_thread::sleep_for(RELOAD_TIME);
+    }};
+
+    controller.request();
+    first_started.get_future().wait();
+
+    // Everything requested while the first is running should turn into a single reload
+    for (size_t i = 0; i < BURST_SIZE; i++) {
+        controller.request();
+    }
+    controller.wait();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    REQUIRE(runs.size() == 2);
+    CHECK(runs[0] == 1);
+    CHECK(runs[1] == BURST_SIZE + 1);
+}
+
+TEST_CASE("loader::reload_controller - cancelling") {
+    static const auto MAX_RELOAD_TIME = std::chrono::seconds(5);
+    static const auto POLL_INTERVAL = std::chrono::milliseconds(1);
+
+    std::atomic<size_t> cancelled{0};
+    std::atomic<size_t> finished{0};
+    std::promise<void> first_started{};
+
+    reload_controller* controller_ptr = nullptr;
+    reload_controller controller{[&](reload_controller::generation generation) {
+        if (generation == 1) {
+            first_started.set_value();
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + MAX_RELOAD_TIME;
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (controller_ptr->is_superseded(generation)) {
+                cancelled++;
+                return;
+            }
+            // Pretend the last reload finishes quickly
+            if (generation > 1) {
+                break;
+            }
+            std::this_thread::sleep_for(POLL_INTERVAL);
+        }
+        finished++;
+    }};
+    controller_ptr = &controller;
+
+    auto start = std::chrono::steady_clock::now();
+    controller.request();
+    first_started.get_future().wait();
+
+    // Anyone waiting on the first should be woken by the second instead
+    auto waiting = std::async(std::launch::async, [&]() { controller.wait(); });
+    controller.request();
+    waiting.get();
+
+    CHECK(cancelled == 1);
+    CHECK(finished == 1);
+    CHECK(std::chrono::steady_clock::now() - start < MAX_RELOAD_TIME);
+}
+
+TEST_CASE("loader::reload_controller - requesting never blocks") {
+    static const size_t REQUEST_COUNT = 1000;
+    static const auto RELOAD_TIME = std::chrono::milliseconds(20);
+    static const auto MAX_REQUEST_TIME = std::chrono::microseconds(500);
+
+    reload_controller controller{
+        [&](reload_controller::generation) { std::this_thread::sleep_for(RELOAD_TIME); }};
+
+    // The first request starts the thread, don't count it
+    controller.request();
+
+    std::chrono::steady_clock::duration worst{};
+    for (size_t i = 0; i < REQUEST_COUNT; i++) {
+        auto start = std::chrono::steady_clock::now();
+        controller.request();
+        worst = std::max(worst, std::chrono::steady_clock::now() - start);
+    }
+    controller.wait();
+
+    CHECK(worst < MAX_REQUEST_TIME);
+}
+
+// Only ever accessed through the atomic shared pointer functions, readers never take a lock.
+static std::shared_ptr<const loaded_data> loaded_snapshot = std::make_shared<const loaded_data>();
+
+/**
+ * @brief Publishes the data from a finished reload, replacing the previous snapshot.
+ *
+ * @param data The combined mod data to publish. Moved out of.
+ * @param arena The arena the data was allocated from. Kept alive as long as the snapshot.
+ */
+static void publish_loaded_data(mod_data& data, std::shared_ptr<std::pmr::memory_resource> arena) {
+    // Everything allocated during a reload comes out of a single arena, which gets freed in one go
+    //  once the last reader drops the snapshot. The deleter holds the arena, so the data is always
+    //  destroyed first.
+    std::shared_ptr<const loaded_data> snapshot{
+        new loaded_data{std::move(data.hotfixes), std::move(data.news_items)},
+        [arena = std::move(arena)](const loaded_data* ptr) { delete ptr; }};
+
+    std::atomic_store(&loaded_snapshot, std::move(snapshot));
+}
+
+/**
+ * @brief Gets the stamps of every file loaded during the last reload, for the hotfix cache.
+ *
+ * @return The stamps, sorted by path, or std::nullopt if some of the data can't be cached.
+ */
+static std::optional<std::vector<ohl::cache::file_stamp>> get_cache_inputs(void) {
+    std::vector<ohl::cache::file_stamp> inputs{};
+
+    std::lock_guard<std::mutex> lock(known_mod_files_mutex);
+    for (const auto& [identifier, file] : known_mod_files) {
+        // Can't tell if a url has changed without downloading it again
+        auto local_file = dynamic_cast<mod_file_local*>(file.get());
+        if (local_file == nullptr) {
+            LOGD << "[OHL] Not caching hotfixes, since they include url " << identifier;
+            return std::nullopt;
+        }
+        if (!local_file->stamp) {
+            LOGD << "[OHL] Not caching hotfixes, since " << identifier << " couldn't be read";
+            return std::nullopt;
+        }
+        inputs.push_back(*local_file->stamp);
+    }
+
+    std::sort(inputs.begin(), inputs.end(),
+              [](const auto& a, const auto& b) { return a.path < b.path; });
+    return inputs;
+}
+
+/**
+ * @brief Logs how busy each of the load workers was.
+ *
+ * @param elapsed How long loading took in total.
+ */
+static void log_worker_stats(std::chrono::steady_clock::duration elapsed) {
+    auto elapsed_ns = std::max<std::chrono::nanoseconds::rep>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), 1);
+
+    auto stats = get_load_scheduler().get_stats();
+    for (size_t i = 0; i < stats.size(); i++) {
+        LOGD << "[OHL] Load worker " << i << ": " << (stats[i].busy.count() * 100 / elapsed_ns)
+             << "% busy, ran " << stats[i].tasks_run << " tasks (" << stats[i].tasks_stolen
+             << " stolen)";
+    }
+}
+
+/**
+ * @brief Loads every file in the mods folder into the known files, reusing any which haven't
+ *        changed since the last load.
+ * @note Must be called while holding the loading mutex.
+ *
+ * @param arena The arena to allocate newly loaded files from.
+ * @param combined_mod_data The mod data to append all the loaded data to.
+ * @param stats If not null, the reload stats to fill in the parse and merge times of.
+ * @param cancelled If set, checked while loading, returning true gives up on any url mods still
+ *                  downloading and skips merging. The caller must then discard the results.
+ * @return The identifiers of all included files, in load order.
+ */
+static std::vector<mod_file_identifier> load_mods_folder(
+    std::shared_ptr<std::pmr::memory_resource> arena,
+    mod_data& combined_mod_data,
+    reload_stats* stats = nullptr,
+    const std::function<bool(void)>& cancelled = {}) {
+    reused_file_count = 0;
+    loaded_file_count = 0;
+
+    // Keep the last load's files around, so we can reuse any which haven't changed
+    {
+        std::lock_guard<std::mutex> lock(known_mod_files_mutex);
+        previous_mod_files = std::move(known_mod_files);
+        known_mod_files.clear();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    download_deadline = start + ohl::args::download_budget();
+    load_cancelled = cancelled;
+    get_load_scheduler().reset_stats();
+
+    // Runs even if loading throws, so the deadline can't stay armed for later loads
+    ohl::util::scope_exit finish_load{[] {
+        download_deadline = std::chrono::steady_clock::time_point::max();
+        load_cancelled = nullptr;
+
+        // Nothing references the last load's files anymore - let them (and their arena) go.
+        //  Destroy them outside the lock, url files lock their downloads.
+        decltype(previous_mod_files) finished_files{};
+        {
+            std::lock_guard<std::mutex> lock(known_mod_files_mutex);
+            finished_files.swap(previous_mod_files);
+        }
+    }};
+
+    mods_folder folder_data{std::move(arena)};
+    folder_data.load();
+    // Loading only queues the files, wait for them all so the parse and merge times are separate
+    std::unordered_set<mod_file_identifier> joined_files{};
+    folder_data.join_nested(joined_files);
+    auto parsed = std::chrono::steady_clock::now();
+
+    // Local files always get joined, so the next load can safely reuse them, but once cancelled
+    //  url mods stop being waited on, and there's no point merging
+    if (cancelled && cancelled()) {
+        return {};
+    }
+
+    LOGD << "[OHL] Combining mod data";
+    std::vector<mod_file_identifier> seen_files;
+    folder_data.append_to(combined_mod_data, seen_files);
+
+    if (stats != nullptr) {
+        stats->parse = parsed - start;
+        stats->merge = std::chrono::steady_clock::now() - parsed;
+    }
 
-    CHECK(ITERABLE_EQUAL(data.hotfixes, expected_data.hotfixes));
-    CHECK(ITERABLE_EQUAL(data.type_11_hotfixes, expected_data.type_11_hotfixes));
-    CHECK(ITERABLE_EQUAL(data.type_11_maps, expected_data.type_11_maps));
-    CHECK(ITERABLE_EQUAL(data.news_items, expected_data.news_items));
+    log_worker_stats(std::chrono::steady_clock::now() - start);
 
-    mod_dir = original_mod_dir;
+    return seen_files;
 }
 
-#pragma endregion
+TEST_CASE("loader::load_mods_folder - deterministic order") {
+    static const size_t FILE_COUNT = 30;
+    static const size_t RUN_COUNT = 50;
+    static const auto MAX_DELAY = std::chrono::microseconds(500);
 
-/**
- * @brief Creates the news item for OHL.
- *
- * @param hotfix_count The amount of injected hotfixes
- * @param file_order The injected mod files, in the order they were loaded.
- * @return The OHL news item.
- */
-static news_item get_ohl_news_item(size_t hotfix_count,
-                                   std::vector<std::shared_ptr<mod_file>> file_order) {
-    // If we're in BL3, colour the name.
-    // WL doesn't support font tags :(
-    std::string ohl_name;
-    if (ohl::args::exe_path().stem() == "Borderlands3") {
-        ohl_name =
-            "<font color='#0080E0'>OHL</font><font size='14' color='#C0C0C0'> " VERSION_STRING
-            "</font>";
-    } else {
-        ohl_name = "OHL " VERSION_STRING;
-    }
+    const auto dir = std::filesystem::temp_directory_path() / "ohl_deterministic_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
 
-    std::string header;
-    if (hotfix_count > 1) {
-        header = ohl_name + ": " + std::to_string(hotfix_count) + " hotfixes loaded";
-    } else if (hotfix_count == 1) {
-        header = ohl_name + ": 1 hotfix loaded";
-    } else {
-        header = ohl_name + ": No hotfixes loaded";
+    auto write_file = [&](const std::string& name, const std::vector<std::string>& lines) {
+        std::ofstream out{dir / name, std::ios::binary | std::ios::trunc};
+        for (const auto& line : lines) {
+            out << line << "\n";
+        }
+    };
+    auto hotfix_line = [](const std::string& value) {
+        return "SparkPatchEntry,(1,1,0,),/" + value;
+    };
+
+    // Lots of files exec-ing a few shared ones, which themselves exec more
+    for (size_t i = 0; i < FILE_COUNT; i++) {
+        auto name = std::to_string(i);
+        std::vector<std::string> lines{hotfix_line(name + "_before")};
+        if (i % 3 == 0) {
+            lines.push_back("exec zz_shared.txt");
+        }
+        if (i % 5 == 0) {
+            lines.push_back("exec zz_deep.txt");
+        }
+        lines.push_back(hotfix_line(name + "_after"));
+        write_file(name + ".txt", lines);
     }
+    write_file("zz_shared.txt", {hotfix_line("shared_before"), "exec zz_deep.txt",
+                                 hotfix_line("shared_after")});
+    write_file("zz_deep.txt", {hotfix_line("deep")});
+    const size_t total_files = FILE_COUNT + 2;
 
-    std::string body;
-    if (hotfix_count == 0) {
-        body = "No hotfixes loaded";
-    } else {
-        std::stringstream stream{};
-        stream << "Loaded files:\n";
+    auto original_mod_dir = mod_dir;
+    mod_dir = dir;
 
-        for (const auto& file : file_order) {
-            stream << file->get_display_name() << ",\n";
+    std::atomic<size_t> load_count{0};
+    auto load = [&]() {
+        known_mod_files.clear();
+        load_count = 0;
+
+        mod_data data{};
+        auto seen_files = load_mods_folder(nullptr, data);
+
+        std::vector<std::string> values{};
+        for (const auto& hotfix : data.hotfixes) {
+            values.emplace_back(hotfix.value);
         }
+        return std::make_pair(seen_files, values);
+    };
 
-        body = stream.str();
-    }
+    local_load_hook = [&]() { load_count++; };
+    const auto expected = load();
+    REQUIRE(expected.first.size() == total_files);
+    REQUIRE(expected.second.size() == (FILE_COUNT * 2) + 3);
+    CHECK(load_count == total_files);
 
-    return {header, OHL_NEWS_ITEM_IMAGE_URL, OHL_NEWS_ITEM_ARTICLE_URL, body};
-}
+    // Shuffle the order loads finish in, the result should never change
+    local_load_hook = [&]() {
+        thread_local std::minstd_rand rng{static_cast<std::minstd_rand::result_type>(
+            std::hash<std::thread::id>{}(std::this_thread::get_id()))};
+        std::uniform_int_distribution<std::chrono::microseconds::rep> delay{0, MAX_DELAY.count()};
 
-TEST_CASE("loader::get_ohl_news_item") {
-    auto empty_news = get_ohl_news_item(0, {});
-    CHECK(empty_news.header == "OHL " VERSION_STRING ": No hotfixes loaded");
-    CHECK(empty_news.image_url == OHL_NEWS_ITEM_IMAGE_URL);
-    CHECK(empty_news.article_url == OHL_NEWS_ITEM_ARTICLE_URL);
-    CHECK(empty_news.body == "No hotfixes loaded");
+        load_count++;
+        std::this_thread::sleep_for(std::chrono::microseconds(delay(rng)));
+    };
 
-    auto one_news = get_ohl_news_item(1, {});
-    CHECK(one_news.header == "OHL " VERSION_STRING ": 1 hotfix loaded");
-    CHECK(one_news.image_url == OHL_NEWS_ITEM_IMAGE_URL);
-    CHECK(one_news.article_url == OHL_NEWS_ITEM_ARTICLE_URL);
-    // Going to leave body formatting indeterminate for >0
+    for (size_t run = 0; run < RUN_COUNT; run++) {
+        CAPTURE(run);
 
-    auto multi_news = get_ohl_news_item(1234, {});
-    CHECK(multi_news.header == "OHL " VERSION_STRING ": 1234 hotfixes loaded");
-    CHECK(multi_news.image_url == OHL_NEWS_ITEM_IMAGE_URL);
-    CHECK(multi_news.article_url == OHL_NEWS_ITEM_ARTICLE_URL);
+        auto [seen_files, values] = load();
+        CHECK(ITERABLE_EQUAL(seen_files, expected.first));
+        CHECK(ITERABLE_EQUAL(values, expected.second));
+
+        // Every file should only ever get loaded once
+        CHECK(load_count == total_files);
+        CHECK(loaded_file_count == total_files);
+    }
+
+    local_load_hook = nullptr;
+    known_mod_files.clear();
+    mod_dir = original_mod_dir;
+    std::filesystem::remove_all(dir);
 }
 
-#pragma region Public interface
+static reload_controller& get_reload_controller(void);
 
-static std::mutex reloading_mutex;
-static std::atomic<bool> reloading_started{false};
-static mod_data loaded_mod_data;
+static std::mutex reload_stats_mutex;
+static std::optional<reload_stats> last_reload_stats = std::nullopt;
 
 /**
- * @brief Implementation of `reload`, which reloads the hotfix list.
- * @note Intended to be run in a thread.
+ * @brief Stores the stats of a finished reload, and logs them.
+ *
+ * @param stats The stats to store.
  */
-static void reload_impl(void) {
-    std::lock_guard<std::mutex> lock(reloading_mutex);
-    reloading_started = true;
+static void store_reload_stats(const reload_stats& stats) {
+    auto ms = [](reload_stats::duration duration) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+    };
+    LOGD << "[OHL] Reload took " << ms(stats.total) << "ms: enumerate " << ms(stats.enumerate)
+         << "ms, cache load " << ms(stats.cache_load) << "ms, parse " << ms(stats.parse)
+         << "ms, merge " << ms(stats.merge) << "ms, type 11s " << ms(stats.type_11)
+         << "ms, cache encode " << ms(stats.cache_encode) << "ms, compact " << ms(stats.compact)
+         << "ms, news " << ms(stats.news) << "ms, publish " << ms(stats.publish) << "ms";
+
+    std::lock_guard<std::mutex> lock(reload_stats_mutex);
+    last_reload_stats = stats;
+}
 
-    SetThreadDescription(GetCurrentThread(), L"OpenHotfixLoader Loader");
+/**
+ * @brief Implementation of `reload`, which reloads the hotfix list.
+ * @note Run on the reload controller's thread.
+ *
+ * @param generation The generation of this reload.
+ */
+static void reload_impl(reload_controller::generation generation) {
+    auto& controller = get_reload_controller();
 
     // If the mod folder doesn't exist, create it, and then just quit early since we know we won't
     //  load anything
@@ -1174,16 +3948,74 @@ static void reload_impl(void) {
         return;
     }
 
-    // No need to lock here since we haven't started loading
-    known_mod_files.clear();
+    using clock = std::chrono::steady_clock;
+    reload_stats stats{};
+    auto start = clock::now();
+    auto stage_start = start;
+    auto end_stage = [&](reload_stats::duration& stage) {
+        auto now = clock::now();
+        stage = now - stage_start;
+        stage_start = now;
+    };
 
-    mods_folder folder_data{};
-    folder_data.load();
+    auto arena = std::make_shared<ohl::util::arena>();
 
-    LOGD << "[OHL] Combining mod data";
-    mod_data combined_mod_data{};
-    std::vector<mod_file_identifier> seen_files;
-    folder_data.append_to(combined_mod_data, seen_files);
+    std::vector<std::string> folder_listing{};
+    for (const auto& path : ohl::util::get_sorted_files_in_dir(mod_dir)) {
+        folder_listing.push_back(path.string());
+    }
+    end_stage(stats.enumerate);
+
+    auto cached = ohl::cache::load(cache_file, folder_listing, arena.get());
+    end_stage(stats.cache_load);
+    if (cached) {
+        mod_data cached_mod_data{arena.get()};
+        cached_mod_data.hotfixes = std::move(cached->hotfixes);
+        cached_mod_data.news_items = std::move(cached->news_items);
+        compact_if_enabled(cached_mod_data.hotfixes);
+        end_stage(stats.compact);
+
+        cached_mod_data.news_items.push_front(
+            get_ohl_news_item(cached_mod_data.hotfixes.size(), cached->file_order));
+        end_stage(stats.news);
+
+        stats.from_cache = true;
+        stats.hotfix_count = cached_mod_data.hotfixes.size();
+        stats.news_item_count = cached_mod_data.news_items.size();
+
+        publish_loaded_data(cached_mod_data, arena);
+        end_stage(stats.publish);
+
+        reused_file_count = 0;
+        loaded_file_count = 0;
+        stats.total = clock::now() - start;
+        store_reload_stats(stats);
+
+        LOGI << "[OHL] Loading finished (from cache), loaded files:";
+        for (const auto& name : cached->file_order) {
+            LOGI << "[OHL] " << name;
+        }
+        return;
+    }
+
+    // If a background pre-parse is running this waits for it, it's done most of our work for us
+    std::unique_lock<std::mutex> loading_lock(loading_mutex);
+
+    if (controller.is_superseded(generation)) {
+        LOGI << "[OHL] Cancelling reload, since a newer one was requested";
+        return;
+    }
+
+    mod_data combined_mod_data{arena.get()};
+    auto seen_files = load_mods_folder(arena, combined_mod_data, &stats,
+                                       [&]() { return controller.is_superseded(generation); });
+    stage_start = clock::now();
+
+    // The files we loaded stay known, so the newer reload can still reuse them
+    if (controller.is_superseded(generation)) {
+        LOGI << "[OHL] Cancelling reload, since a newer one was requested";
+        return;
+    }
 
     LOGD << "[OHL] Processing type 11s";
 
@@ -1206,10 +4038,11 @@ static void reload_impl(void) {
          it != combined_mod_data.type_11_hotfixes.rend(); it++) {
         combined_mod_data.hotfixes.push_front(*it);
     }
+    end_stage(stats.type_11);
 
-    LOGD << "[OHL] Adding OHL news item";
-
-    std::vector<std::shared_ptr<mod_file>> file_order;
+    std::vector<std::string> file_order;
+    // Downloads we gave up on might still be registering files
+    std::unique_lock<std::mutex> known_lock(known_mod_files_mutex);
     for (const auto& identifier : seen_files) {
         auto file = known_mod_files.at(identifier);
         if (file->sections.size() == 0) {
@@ -1227,50 +4060,381 @@ static void reload_impl(void) {
             }
         }
 
-        file_order.push_back(file);
+        file_order.push_back(file->get_display_name());
     }
+    known_lock.unlock();
+
+    // Encode the cache before adding our news item, since it depends on the exe
+    std::optional<std::string> encoded_cache = std::nullopt;
+    auto cache_inputs = get_cache_inputs();
+    if (cache_inputs) {
+        LOGD << "[OHL] Encoding hotfix cache";
+
+        // Same resource on both sides, so these moves don't copy anything
+        ohl::cache::cached_data cache_data{arena.get()};
+        cache_data.folder_listing = std::move(folder_listing);
+        cache_data.inputs = std::move(*cache_inputs);
+        cache_data.file_order = file_order;
+        cache_data.hotfixes = std::move(combined_mod_data.hotfixes);
+        cache_data.news_items = std::move(combined_mod_data.news_items);
+
+        encoded_cache = ohl::cache::encode(cache_data);
+
+        combined_mod_data.hotfixes = std::move(cache_data.hotfixes);
+        combined_mod_data.news_items = std::move(cache_data.news_items);
+    }
+    end_stage(stats.cache_encode);
+
+    // Done after encoding the cache, so that changing the setting doesn't need it to be rebuilt
+    compact_if_enabled(combined_mod_data.hotfixes);
+    end_stage(stats.compact);
+
+    LOGD << "[OHL] Adding OHL news item";
 
     combined_mod_data.news_items.push_front(
         get_ohl_news_item(combined_mod_data.hotfixes.size(), file_order));
+    end_stage(stats.news);
+
+    stats.hotfix_count = combined_mod_data.hotfixes.size();
+    stats.news_item_count = combined_mod_data.news_items.size();
 
     LOGD << "[OHL] Replacing globals";
 
-    loaded_mod_data = combined_mod_data;
+    publish_loaded_data(combined_mod_data, arena);
+    end_stage(stats.publish);
+
+    stats.loaded_file_count = loaded_file_count;
+    stats.reused_file_count = reused_file_count;
+    stats.total = clock::now() - start;
+    store_reload_stats(stats);
 
-    LOGI << "[OHL] Loading finished, loaded files:";
-    for (const auto& file : file_order) {
-        LOGI << "[OHL] " << file->get_display_name();
+    LOGI << "[OHL] Loading finished, reused " << reused_file_count << " unchanged files, loaded "
+         << loaded_file_count << " files. Loaded files:";
+    for (const auto& name : file_order) {
+        LOGI << "[OHL] " << name;
     }
+
+    loading_lock.unlock();
+
+    if (!encoded_cache) {
+        return;
+    }
+
+    // Writing the cache doesn't need to block anyone waiting on the new data. Take the cache lock
+    //  first though, so anyone waiting on both sees the write finished.
+    std::lock_guard<std::mutex> cache_lock(cache_file_mutex);
+    controller.complete(generation);
+
+    try {
+        ohl::cache::write(cache_file, *encoded_cache);
+        LOGD << "[OHL] Wrote hotfix cache";
+    } catch (const std::runtime_error& ex) {
+        LOGE << "[OHL] Failed to write hotfix cache: " << ex.what();
+    }
+}
+
+/**
+ * @brief Loads any changes to the mods folder in the background, without publishing them.
+ * @note Only replaces the known files, so that the next reload can reuse them.
+ * @note Only loads local files, url mods are left for the reload to download.
+ */
+static void preparse(void) {
+    std::lock_guard<std::mutex> lock(loading_mutex);
+
+    if (!std::filesystem::exists(mod_dir)) {
+        return;
+    }
+
+    LOGD << "[OHL] Mods folder changed, pre-parsing";
+
+    auto arena = std::make_shared<ohl::util::arena>();
+    mod_data discarded_mod_data{arena.get()};
+    // If this were left set after a throw, every later reload would skip url mods
+    preparsing = true;
+    ohl::util::scope_exit reset_preparsing{[] { preparsing = false; }};
+    load_mods_folder(arena, discarded_mod_data);
+
+    LOGD << "[OHL] Pre-parsing finished, reused " << reused_file_count
+         << " unchanged files, loaded " << loaded_file_count << " files";
 }
 
 void init(void) {
     auto dll_path = ohl::args::dll_path();
     if (std::filesystem::exists(dll_path)) {
-        mod_dir = dll_path.remove_filename() / mod_dir;
+        dll_path.remove_filename();
+        mod_dir = dll_path / mod_dir;
+        cache_file = dll_path / cache_file;
+        url_cache.dir = dll_path / url_cache.dir;
+    }
+
+    if (ohl::args::watch_mods()) {
+        // Need the folder to exist to be able to watch it
+        std::filesystem::create_directories(mod_dir);
+
+        ohl::util::leaked([] {
+            return ohl::watcher::watcher(ohl::watcher::create_backend(mod_dir), preparse);
+        });
+        LOGI << "[OHL] Watching " << mod_dir << " for changes";
     }
 }
 
+/**
+ * @brief Gets the controller reloads are run on.
+ *
+ * @return The controller.
+ */
+static reload_controller& get_reload_controller(void) {
+    return ohl::util::leaked([] { return reload_controller(reload_impl); });
+}
+
 void reload(void) {
-    reloading_started = false;
+    get_reload_controller().request();
+}
+
+std::shared_ptr<const loaded_data> get_loaded_data(bool wait_for_reload) {
+    if (wait_for_reload) {
+        get_reload_controller().wait();
+    }
+
+    return std::atomic_load(&loaded_snapshot);
+}
+
+std::optional<reload_stats> get_last_reload_stats(void) {
+    std::lock_guard<std::mutex> lock(reload_stats_mutex);
+    return last_reload_stats;
+}
+
+TEST_CASE("loader::get_loaded_data - concurrent publishing") {
+    static const size_t GENERATIONS = 500;
+    static const auto READER_COUNT = 4;
+
+    auto original_snapshot = std::atomic_load(&loaded_snapshot);
+
+    // Every generation holds one hotfix per generation number, each with the number as it's value
+    auto publish_generation = [](size_t generation) {
+        auto arena = std::make_shared<ohl::util::arena>();
+        mod_data data{arena.get()};
+        auto value = std::to_string(generation);
+        for (size_t i = 0; i < generation; i++) {
+            data.hotfixes.emplace_back("SparkPatchEntry", value);
+        }
+        data.news_items.emplace_back(value, "", "", "");
+        publish_loaded_data(data, arena);
+    };
+    publish_generation(0);
+
+    std::atomic<bool> finished{false};
+    std::atomic<size_t> reads{0};
+    std::atomic<size_t> errors{0};
+    std::vector<std::thread> readers{};
+    for (auto i = 0; i < READER_COUNT; i++) {
+        readers.emplace_back([&]() {
+            size_t last_generation = 0;
+            while (!finished) {
+                auto data = get_loaded_data(false);
+                auto generation = data->hotfixes.size();
+                auto value = std::to_string(generation);
+
+                // Snapshots should never go backwards, and should never be partially written
+                if (generation < last_generation) {
+                    errors++;
+                }
+                if (data->news_items.size() != 1
+                    || std::string_view(data->news_items[0].header) != value) {
+                    errors++;
+                }
+                for (const auto& hotfix : data->hotfixes) {
+                    if (std::string_view(hotfix.value) != value) {
+                        errors++;
+                    }
+                }
+
+                last_generation = generation;
+                reads++;
+            }
+        });
+    }
+
+    for (size_t generation = 1; generation <= GENERATIONS; generation++) {
+        publish_generation(generation);
+    }
+    // Make sure the readers got a chance to run, even on a single core
+    while (reads < READER_COUNT) {
+        std::this_thread::yield();
+    }
+    finished = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    CHECK(errors == 0);
+    CHECK(get_loaded_data(false)->hotfixes.size() == GENERATIONS);
+
+    SUBCASE("waiting") {
+        const auto dir = std::filesystem::temp_directory_path() / "ohl_waiting_test";
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        {
+            std::ofstream out{dir / "mod.bl3hotfix", std::ios::binary | std::ios::trunc};
+            out << "SparkPatchEntry,(1,1,0,),/Hotfix\n";
+        }
+
+        auto original_mod_dir = mod_dir;
+        mod_dir = dir;
+        auto original_cache_file = cache_file;
+        cache_file = dir.parent_path() / "ohl_waiting_cache.bin";
+        std::filesystem::remove(cache_file);
+
+        {
+            // Stalls the reload partway through
+            std::unique_lock<std::mutex> lock(loading_mutex);
+            reload();
+
+            // Shouldn't wait, since we're holding the lock this would deadlock otherwise
+            CHECK(get_loaded_data(false)->hotfixes.size() == GENERATIONS);
+
+            auto waiting = std::async(std::launch::async, []() { return get_loaded_data(true); });
+            CHECK(waiting.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
+
+            lock.unlock();
+            CHECK(waiting.get()->hotfixes.size() == 1);
+        }
 
-    std::thread thread(reload_impl);
-    thread.detach();
+        {
+            std::lock_guard<std::mutex> lock(cache_file_mutex);
+            std::filesystem::remove(cache_file);
+        }
+        cache_file = original_cache_file;
+        mod_dir = original_mod_dir;
+        std::filesystem::remove_all(dir);
+    }
 
-    // Busy wait for the thread to start before exiting
-    while (!reloading_started) {}
-    reloading_started = false;
+    std::atomic_store(&loaded_snapshot, original_snapshot);
 }
 
-std::deque<hotfix> get_hotfixes(void) {
-    std::lock_guard<std::mutex> lock(reloading_mutex);
+TEST_CASE("loader::get_loaded_data - reader latency benchmark" * doctest::skip()) {
+    static const auto RELOAD_COUNT = 20;
+    static const auto RELOAD_TIME = std::chrono::milliseconds(50);
+    static const size_t HOTFIX_COUNT = 50000;
+
+    auto original_snapshot = std::atomic_load(&loaded_snapshot);
+
+    auto publish = []() {
+        auto arena = std::make_shared<ohl::util::arena>();
+        mod_data data{arena.get()};
+        for (size_t i = 0; i < HOTFIX_COUNT; i++) {
+            data.hotfixes.emplace_back("SparkPatchEntry",
+                                       "(1,1,0,),/Game/Gear/Weapons/_Shared/_Design/Balance/"
+                                       "Balance.Balance,RarityData.BaseValueConstant,0,,1.0");
+        }
+        publish_loaded_data(data, arena);
+    };
+    publish();
+
+    // How readers used to work, blocking on the reload and then copying everything
+    std::mutex reloading_mutex;
+    auto locked_copy = [&]() {
+        std::lock_guard<std::mutex> lock(reloading_mutex);
+        auto data = std::atomic_load(&loaded_snapshot);
+        return std::deque<hotfix>{data->hotfixes.begin(), data->hotfixes.end()};
+    };
+
+    using clock = std::chrono::steady_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    using std::chrono::nanoseconds;
+
+    for (auto use_snapshot : {false, true}) {
+        std::atomic<bool> reloading{true};
+        std::thread reloader([&]() {
+            for (auto i = 0; i < RELOAD_COUNT; i++) {
+                {
+                    std::lock_guard<std::mutex> lock(reloading_mutex);
+                    std::this_thread::sleep_for(RELOAD_TIME);
+                    publish();
+                }
+                std::this_thread::sleep_for(RELOAD_TIME / 5);
+            }
+            reloading = false;
+        });
+
+        size_t reads = 0;
+        clock::duration total{};
+        clock::duration worst{};
+        while (reloading) {
+            auto start = clock::now();
+            size_t size;
+            if (use_snapshot) {
+                size = get_loaded_data(false)->hotfixes.size();
+            } else {
+                size = locked_copy().size();
+            }
+            auto time = clock::now() - start;
+            REQUIRE(size == HOTFIX_COUNT);
+
+            reads++;
+            total += time;
+            worst = std::max(worst, time);
+        }
+        reloader.join();
+
+        MESSAGE((use_snapshot ? "Snapshot: " : "Locked copy: ")
+                << reads << " reads, mean " << duration_cast<nanoseconds>(total / reads).count()
+                << "ns, worst " << duration_cast<microseconds>(worst).count() << "us");
+    }
 
-    return loaded_mod_data.hotfixes;
+    std::atomic_store(&loaded_snapshot, original_snapshot);
 }
 
-std::deque<news_item> get_news_items(void) {
-    std::lock_guard<std::mutex> lock(reloading_mutex);
+TEST_CASE("loader::image_url_index - hook benchmark" * doctest::skip()) {
+    auto original_snapshot = std::atomic_load(&loaded_snapshot);
+
+    // Something the game would cache, which misses every injected image
+    const std::wstring request_url = L"https://cdn.example.com/game/images/some_game_image.png";
 
-    return loaded_mod_data.news_items;
+    using clock = std::chrono::steady_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+
+    for (size_t news_count : {1, 100, 10000}) {
+        auto arena = std::make_shared<ohl::util::arena>();
+        mod_data data{arena.get()};
+        for (size_t i = 0; i < news_count; i++) {
+            auto idx = std::to_string(i);
+            data.news_items.emplace_back("Header " + idx,
+                                         "https://example.com/images/news_" + idx + ".png",
+                                         "https://example.com/articles/" + idx, "Body");
+        }
+        publish_loaded_data(data, arena);
+
+        auto iterations = std::max<size_t>(100, 1000000 / news_count);
+        size_t blocked = 0;
+
+        // How the hook used to work: narrow, copy every news item, then a linear search
+        auto old_start = clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            auto url = ohl::util::narrow(request_url);
+            auto snapshot = get_loaded_data(false);
+            std::deque<news_item> news_items{snapshot->news_items.begin(),
+                                             snapshot->news_items.end()};
+            auto match = [&](auto item) { return std::string_view(item.image_url) == url; };
+            blocked +=
+                std::find_if(news_items.begin(), news_items.end(), match) != news_items.end();
+        }
+        auto old_time = duration_cast<nanoseconds>(clock::now() - old_start) / iterations;
+
+        auto new_start = clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            blocked += get_loaded_data(false)->image_urls.contains(std::wstring_view(request_url));
+        }
+        auto new_time = duration_cast<nanoseconds>(clock::now() - new_start) / iterations;
+
+        CHECK(blocked == 0);
+        MESSAGE(news_count << " news items: old " << old_time.count() << "ns, indexed "
+                           << new_time.count() << "ns per call");
+    }
+
+    std::atomic_store(&loaded_snapshot, original_snapshot);
 }
 
 TEST_CASE("loader integration") {
@@ -1350,22 +4514,262 @@ TEST_CASE("loader integration") {
 
     auto original_mod_dir = mod_dir;
     mod_dir = std::filesystem::path("tests") / "mods_dir";
+    auto original_cache_file = cache_file;
+    cache_file = std::filesystem::temp_directory_path() / "ohl_integration_cache.bin";
+    std::filesystem::remove(cache_file);
+
+    // The first reload parses everything and writes the cache, the second should read it back
+    for (auto from_cache : {false, true}) {
+        CAPTURE(from_cache);
+
+        reload();
+        auto data = get_loaded_data();
+        const auto& hotfixes = data->hotfixes;
+        std::deque<news_item> news_items{data->news_items.begin(), data->news_items.end()};
+
+        if (from_cache) {
+            CHECK(loaded_file_count == 0);
+            CHECK(reused_file_count == 0);
+        } else {
+            CHECK(loaded_file_count > 0);
+        }
+
+        auto stats = get_last_reload_stats();
+        REQUIRE(stats.has_value());
+        CHECK(stats->from_cache == from_cache);
+        CHECK(stats->hotfix_count == hotfixes.size());
+
+        news_item ohl_news = news_items[0];
+        news_items.pop_front();
+
+        CHECK(ohl_news.header == "OHL " VERSION_STRING ": 14 hotfixes loaded");
+        CHECK(ohl_news.image_url == OHL_NEWS_ITEM_IMAGE_URL);
+        CHECK(ohl_news.article_url == OHL_NEWS_ITEM_ARTICLE_URL);
+
+        CHECK(ITERABLE_EQUAL(hotfixes, expected_hotfixes));
+        CHECK(ITERABLE_EQUAL(news_items, expected_news_items));
+
+        // Make sure the cache has been written before the next loop
+        std::lock_guard<std::mutex> lock(cache_file_mutex);
+        CHECK(std::filesystem::exists(cache_file));
+    }
+
+    std::filesystem::remove(cache_file);
+    cache_file = original_cache_file;
+    mod_dir = original_mod_dir;
+}
+
+TEST_CASE("loader incremental reload") {
+    const auto dir = std::filesystem::temp_directory_path() / "ohl_incremental_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "nested");
+
+    auto write_file = [&](const std::filesystem::path& path, const std::string& contents) {
+        std::ofstream out{dir / path, std::ios::binary | std::ios::trunc};
+        out << contents;
+    };
+    auto hotfix_line = [](const std::string& name) {
+        return "SparkPatchEntry,(1,1,0,),/" + name + "\n";
+    };
+
+    // a.bl3hotfix -> nested/mid.txt -> nested/leaf.txt, then b.bl3hotfix
+    write_file("a.bl3hotfix",
+               hotfix_line("a1") + "exec nested/mid.txt\n" + hotfix_line("a2"));
+    write_file(std::filesystem::path("nested") / "mid.txt",
+               hotfix_line("mid1") + "exec nested/leaf.txt\n" + hotfix_line("mid2"));
+    write_file(std::filesystem::path("nested") / "leaf.txt", hotfix_line("leaf"));
+    write_file("b.bl3hotfix", hotfix_line("b"));
+
+    auto original_mod_dir = mod_dir;
+    mod_dir = dir;
+    auto original_cache_file = cache_file;
+    cache_file = dir / "cache.bin";
+
+    auto reload_values = [&]() {
+        // Make sure we always go through the incremental path
+        {
+            std::lock_guard<std::mutex> lock(cache_file_mutex);
+            std::filesystem::remove(cache_file);
+        }
+
+        reload();
+        auto data = get_loaded_data();
+
+        std::vector<std::string> values{};
+        for (const auto& hotfix : data->hotfixes) {
+            values.emplace_back(hotfix.value.substr(hotfix.value.find('/') + 1));
+        }
+        return values;
+    };
+
+    SUBCASE("") {
+        CHECK(reload_values() == std::vector<std::string>{"a1", "mid1", "leaf", "mid2", "a2", "b"});
+        CHECK(reused_file_count == 0);
+        CHECK(loaded_file_count == 4);
+
+        // Nothing changed, everything should be reused, with the same result
+        CHECK(reload_values() == std::vector<std::string>{"a1", "mid1", "leaf", "mid2", "a2", "b"});
+        CHECK(reused_file_count == 4);
+        CHECK(loaded_file_count == 0);
+
+        // Changing the end of the chain should only reload that file
+        write_file(std::filesystem::path("nested") / "leaf.txt",
+                   hotfix_line("leaf") + hotfix_line("leaf2"));
+        CHECK(reload_values()
+              == std::vector<std::string>{"a1", "mid1", "leaf", "leaf2", "mid2", "a2", "b"});
+        CHECK(reused_file_count == 3);
+        CHECK(loaded_file_count == 1);
+
+        // Same size, only the contents changed
+        write_file(std::filesystem::path("nested") / "leaf.txt",
+                   hotfix_line("fael") + hotfix_line("leaf2"));
+        CHECK(reload_values()
+              == std::vector<std::string>{"a1", "mid1", "fael", "leaf2", "mid2", "a2", "b"});
+        CHECK(reused_file_count == 3);
+        CHECK(loaded_file_count == 1);
+
+        // Point the middle of the chain at a new file, the old leaf should drop out entirely
+        write_file(std::filesystem::path("nested") / "mid.txt",
+                   hotfix_line("mid1") + "exec nested/new.txt\n" + hotfix_line("mid2"));
+        write_file(std::filesystem::path("nested") / "new.txt", hotfix_line("new"));
+        CHECK(reload_values() == std::vector<std::string>{"a1", "mid1", "new", "mid2", "a2", "b"});
+        CHECK(reused_file_count == 2);
+        CHECK(loaded_file_count == 2);
+
+        // Exec the chain a second time from a later file, it should still only be included once
+        write_file("b.bl3hotfix", hotfix_line("b") + "exec nested/mid.txt\n");
+        CHECK(reload_values() == std::vector<std::string>{"a1", "mid1", "new", "mid2", "a2", "b"});
+        CHECK(reused_file_count == 3);
+        CHECK(loaded_file_count == 1);
+
+        // Create a file which an unchanged file tried to exec before it existed
+        write_file("a.bl3hotfix", hotfix_line("a1") + "exec nested/mid.txt\n"
+                                      + "exec nested/later.txt\n" + hotfix_line("a2"));
+        CHECK(reload_values() == std::vector<std::string>{"a1", "mid1", "new", "mid2", "a2", "b"});
+        write_file(std::filesystem::path("nested") / "later.txt", hotfix_line("later"));
+        CHECK(reload_values()
+              == std::vector<std::string>{"a1", "mid1", "new", "mid2", "later", "a2", "b"});
+        CHECK(reused_file_count == 4);
+        CHECK(loaded_file_count == 1);
+    }
+
+    {
+        // Wait for the last cache write
+        std::lock_guard<std::mutex> lock(cache_file_mutex);
+        cache_file = original_cache_file;
+    }
+    mod_dir = original_mod_dir;
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("loader::preparse") {
+    const auto dir = std::filesystem::temp_directory_path() / "ohl_preparse_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    auto write_file = [&](const std::string& name, const std::string& value) {
+        std::ofstream out{dir / name, std::ios::binary | std::ios::trunc};
+        out << "SparkPatchEntry,(1,1,0,),/" << value << "\n";
+    };
+    write_file("a.bl3hotfix", "a");
+    write_file("b.bl3hotfix", "b");
+
+    auto original_mod_dir = mod_dir;
+    mod_dir = dir;
+    auto original_cache_file = cache_file;
+    cache_file = dir.parent_path() / "ohl_preparse_cache.bin";
+    std::filesystem::remove(cache_file);
+
+    reload();
+    CHECK(get_loaded_data()->hotfixes.size() == 2);
+    CHECK(loaded_file_count == 2);
+
+    write_file("b.bl3hotfix", "changed");
+    preparse();
+    CHECK(reused_file_count == 1);
+    CHECK(loaded_file_count == 1);
+
+    // Pre-parsing shouldn't have published anything
+    CHECK(std::string_view(get_loaded_data()->hotfixes[1].value) == "(1,1,0,),/b");
+
+    // The reload should be able to reuse everything
+    {
+        std::lock_guard<std::mutex> lock(cache_file_mutex);
+        std::filesystem::remove(cache_file);
+    }
+    reload();
+    CHECK(std::string_view(get_loaded_data()->hotfixes[1].value) == "(1,1,0,),/changed");
+    CHECK(reused_file_count == 2);
+    CHECK(loaded_file_count == 0);
+
+    {
+        std::lock_guard<std::mutex> lock(cache_file_mutex);
+        std::filesystem::remove(cache_file);
+    }
+    cache_file = original_cache_file;
+    mod_dir = original_mod_dir;
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("loader::preparse - url mods") {
+    const auto dir = std::filesystem::temp_directory_path() / "ohl_preparse_url_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "mods");
+    {
+        std::ofstream out{dir / "mods" / "a.bl3hotfix", std::ios::binary | std::ios::trunc};
+        out << "URL=https://example.com/mod.bl3hotfix\n";
+    }
+
+    auto original_mod_dir = mod_dir;
+    mod_dir = dir / "mods";
+    auto original_url_cache_dir = url_cache.dir;
+    url_cache.dir = dir / "url-cache";
+
+    size_t fetches = 0;
+    auto original_fetcher = url_fetcher;
+    url_fetcher = [&](const std::string&, const std::string&, const std::string&,
+                      const ohl::cache::body_handler& on_body) -> ohl::cache::http_response {
+        fetches++;
+        on_body("SparkPatchEntry,(1,1,0,),/Some/Hotfix\n");
+        return {200, "", "", ""};
+    };
 
     reload();
-    auto hotfixes = get_hotfixes();
-    auto news_items = get_news_items();
+    CHECK(get_loaded_data()->hotfixes.size() == 1);
+    CHECK(fetches == 1);
 
-    news_item ohl_news = news_items[0];
-    news_items.pop_front();
+    // Should only touch the local file
+    preparse();
+    CHECK(fetches == 1);
 
-    CHECK(ohl_news.header == "OHL " VERSION_STRING ": 14 hotfixes loaded");
-    CHECK(ohl_news.image_url == OHL_NEWS_ITEM_IMAGE_URL);
-    CHECK(ohl_news.article_url == OHL_NEWS_ITEM_ARTICLE_URL);
+    // Which the reload can reuse, while still downloading the url
+    reload();
+    CHECK(get_loaded_data()->hotfixes.size() == 1);
+    CHECK(fetches == 2);
+    CHECK(reused_file_count == 1);
+
+    // A preparse which throws part way through shouldn't stop later reloads downloading urls
+    mod_dir = dir / "not_a_folder.txt";
+    {
+        std::ofstream out{mod_dir};
+    }
+    CHECK_THROWS(preparse());
+    CHECK_FALSE(preparsing);
+    CHECK(download_deadline == std::chrono::steady_clock::time_point::max());
+    {
+        std::lock_guard<std::mutex> lock(known_mod_files_mutex);
+        CHECK(previous_mod_files.empty());
+    }
 
-    CHECK(ITERABLE_EQUAL(hotfixes, expected_hotfixes));
-    CHECK(ITERABLE_EQUAL(news_items, expected_news_items));
+    mod_dir = dir / "mods";
+    reload();
+    CHECK(get_loaded_data()->hotfixes.size() == 1);
+    CHECK(fetches == 3);
 
+    url_fetcher = original_fetcher;
+    url_cache.dir = original_url_cache_dir;
     mod_dir = original_mod_dir;
+    std::filesystem::remove_all(dir);
 }
 
 #pragma endregion
@@ -6,33 +6,79 @@ namespace ohl::loader {
 
 /**
  * @brief Struct representing a single hotfix entry.
+ * @note Common keys are interned, and only store a small id. Other keys fall back to a string.
+ * @note Allocator aware, the value is allocated from the same resource as the containing container.
  */
 struct hotfix {
-    std::string key;
-    std::string value;
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
 
-    hotfix(const std::string& key = "", const std::string& value = "") : key(key), value(value) {}
+   private:
+    uint8_t key_atom;
+    std::unique_ptr<std::string> custom_key;
 
-    bool operator==(const hotfix& rhs) const {
-        return this->key == rhs.key && this->value == rhs.value;
-    }
+   public:
+    std::pmr::string value;
+
+    explicit hotfix(const allocator_type& alloc);
+    hotfix(std::string_view key = "",
+           std::string_view value = "",
+           const allocator_type& alloc = {});
+
+    hotfix(const hotfix& other, const allocator_type& alloc = {});
+    hotfix(hotfix&& other) = default;
+    hotfix(hotfix&& other, const allocator_type& alloc);
+    hotfix& operator=(const hotfix& other);
+    hotfix& operator=(hotfix&& other) = default;
+
+    /**
+     * @brief Gets this hotfix's key.
+     *
+     * @return The key.
+     */
+    const std::string& get_key(void) const;
+
+    bool operator==(const hotfix& rhs) const;
     bool operator!=(const hotfix& rhs) const { return !operator==(rhs); }
 };
 
 /**
- * @brief Struct representing a single injected news item. *
+ * @brief Struct representing a single injected news item.
+ * @note Allocator aware, the strings are allocated from the same resource as the containing
+ *       container.
  */
 struct news_item {
-    std::string header;
-    std::string image_url;
-    std::string article_url;
-    std::string body;
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
 
-    news_item(const std::string& header = "",
-              const std::string& image_url = "",
-              const std::string& article_url = "",
-              const std::string& body = "")
-        : header(header), image_url(image_url), article_url(article_url), body(body) {}
+    std::pmr::string header;
+    std::pmr::string image_url;
+    std::pmr::string article_url;
+    std::pmr::string body;
+
+    explicit news_item(const allocator_type& alloc)
+        : header(alloc), image_url(alloc), article_url(alloc), body(alloc) {}
+    news_item(std::string_view header = "",
+              std::string_view image_url = "",
+              std::string_view article_url = "",
+              std::string_view body = "",
+              const allocator_type& alloc = {})
+        : header(header, alloc),
+          image_url(image_url, alloc),
+          article_url(article_url, alloc),
+          body(body, alloc) {}
+
+    news_item(const news_item& other, const allocator_type& alloc = {})
+        : header(other.header, alloc),
+          image_url(other.image_url, alloc),
+          article_url(other.article_url, alloc),
+          body(other.body, alloc) {}
+    news_item(news_item&& other) = default;
+    news_item(news_item&& other, const allocator_type& alloc)
+        : header(std::move(other.header), alloc),
+          image_url(std::move(other.image_url), alloc),
+          article_url(std::move(other.article_url), alloc),
+          body(std::move(other.body), alloc) {}
+    news_item& operator=(const news_item& other) = default;
+    news_item& operator=(news_item&& other) = default;
 
     bool operator==(const news_item& rhs) const {
         return this->header == rhs.header && this->image_url == rhs.image_url
@@ -41,29 +87,177 @@ struct news_item {
     bool operator!=(const news_item& rhs) const { return !operator==(rhs); }
 };
 
+/**
+ * @brief Hashed set of the image urls used by a list of news items.
+ * @note Holds each url in both utf8 and utf16, so it can be checked against game strings directly.
+ * @note Views into the news items, so must not outlive them.
+ */
+class image_url_index {
+   private:
+    std::pmr::deque<std::pmr::wstring> wide_storage;
+    std::pmr::unordered_set<std::string_view> urls;
+    std::pmr::unordered_set<std::wstring_view> wide_urls;
+
+   public:
+    image_url_index(const std::pmr::deque<news_item>& news_items);
+
+    image_url_index(const image_url_index&) = delete;
+    image_url_index& operator=(const image_url_index&) = delete;
+
+    /**
+     * @brief Checks if an image url is used by any of the news items.
+     * @note Does not allocate.
+     *
+     * @param url The url to check.
+     * @return True if the url is used, false otherwise.
+     */
+    bool contains(std::string_view url) const;
+    bool contains(std::wstring_view url) const;
+};
+
+/**
+ * @brief A list of hotfixes, pre-rendered into utf16 so they can be copied straight into game
+ *        strings.
+ * @note All keys and values are stored back to back in a single buffer, indexed by an offset table.
+ *       None of them are null terminated.
+ * @note Keys don't include the counter suffix, since that depends on where they get injected.
+ */
+class hotfix_payload {
+   public:
+    struct entry {
+        std::wstring_view key;
+        std::wstring_view value;
+    };
+
+   private:
+    struct offsets {
+        size_t key;
+        // The key ends where the value starts
+        size_t value;
+        size_t end;
+    };
+
+    std::pmr::vector<wchar_t> buffer;
+    std::pmr::vector<offsets> table;
+
+    /**
+     * @brief Appends a utf8 string to the end of the buffer.
+     * @note The buffer must already have enough space reserved.
+     *
+     * @param str The string to append.
+     */
+    void append(std::string_view str);
+
+   public:
+    hotfix_payload(const std::pmr::deque<hotfix>& hotfixes);
+
+    hotfix_payload(const hotfix_payload&) = delete;
+    hotfix_payload& operator=(const hotfix_payload&) = delete;
+
+    /**
+     * @brief Gets the amount of hotfixes in the payload.
+     *
+     * @return The amount of hotfixes.
+     */
+    size_t size(void) const;
+
+    /**
+     * @brief Gets a single hotfix out of the payload.
+     * @note Does not allocate.
+     *
+     * @param idx The index of the hotfix to get.
+     * @return Views of the hotfix's key and value.
+     */
+    entry operator[](size_t idx) const;
+};
+
+/**
+ * @brief Immutable snapshot of all the data loaded by a single reload.
+ * @note Owns the memory of the reload which created it, it's freed once the last reference to the
+ *       snapshot is dropped.
+ */
+struct loaded_data {
+    std::pmr::deque<hotfix> hotfixes;
+    std::pmr::deque<news_item> news_items;
+    const image_url_index image_urls;
+    // Rendered while reloading, so that injecting them on the game thread only needs to copy them
+    const hotfix_payload rendered_hotfixes;
+
+    loaded_data(std::pmr::deque<hotfix>&& hotfixes = {},
+                std::pmr::deque<news_item>&& news_items = {})
+        : hotfixes(std::move(hotfixes)),
+          news_items(std::move(news_items)),
+          image_urls(this->news_items),
+          rendered_hotfixes(this->hotfixes) {}
+};
+
+/**
+ * @brief Struct holding how long each stage of a reload took.
+ */
+struct reload_stats {
+    using duration = std::chrono::steady_clock::duration;
+
+    // True if the hotfixes were loaded from the hotfix cache, in which case only the enumerate,
+    //  cache load, compact, news and publish stages run
+    bool from_cache;
+
+    // Listing the mods folder
+    duration enumerate;
+    // Checking, and possibly loading, the hotfix cache
+    duration cache_load;
+    // Loading and parsing every mod file, including any they exec
+    duration parse;
+    // Combining the mod files' data, in load order
+    duration merge;
+    // Moving type 11s to the front, and adding their delays
+    duration type_11;
+    // Encoding the new hotfix cache
+    duration cache_encode;
+    // Dropping overwritten hotfixes, if enabled
+    duration compact;
+    // Creating the OHL news item
+    duration news;
+    // Creating and publishing the loaded data snapshot
+    duration publish;
+    duration total;
+
+    size_t hotfix_count;
+    size_t news_item_count;
+    size_t loaded_file_count;
+    size_t reused_file_count;
+};
+
 /**
  * @brief Initalizes the loader module.
  */
 void init(void);
 
 /**
- * @brief Starts reloads the hotfix list.
- * @note Runs in a thread, `get_hotfixes` or `get_news_items` calls will block until it compeltes.
+ * @brief Starts reloading the hotfix list.
+ * @note Runs in a thread, waiting `get_loaded_data` calls will block until it completes.
+ * @note Never blocks the caller. If a reload is already running, it gets cancelled, and all
+ *       requests made in the meantime are coalesced into a single new reload.
  */
 void reload(void);
 
 /**
- * @brief Get the list of hotfixes to inject.
+ * @brief Gets a snapshot of the most recently loaded data.
+ * @note The snapshot is never modified, a reload publishes a new one instead, so it's safe to hold
+ *       on to it for as long as needed.
  *
- * @return A list of hotfixes.
+ * @param wait_for_reload If true, blocks until every reload requested before this call has
+ *                        completed. If false, returns the previous snapshot straight away.
+ * @return The loaded data. Never null, holds no data if nothing has been loaded yet.
  */
-std::deque<hotfix> get_hotfixes(void);
+std::shared_ptr<const loaded_data> get_loaded_data(bool wait_for_reload = true);
 
 /**
- * @brief Get the list of news items to inject.
+ * @brief Gets the stats of the most recently completed reload.
+ * @note Updated before the reload completes, so a `get_loaded_data` call which waited for a reload
+ *       will always see its stats.
  *
- * @return A list of news items.
+ * @return The stats, or std::nullopt if no reload has finished yet.
  */
-std::deque<news_item> get_news_items(void);
+std::optional<reload_stats> get_last_reload_stats(void);
 
 }  // namespace ohl::loader
@@ -17,20 +17,30 @@
 #include <array>
 #include <atomic>
 #include <cctype>
+#include <chrono>
 #include <codecvt>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
 #include <cwchar>
 #include <deque>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <future>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <optional>
+#include <random>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -47,6 +57,11 @@ using std::uint64_t;
 using std::uint8_t;
 #endif
 
+#if defined(_M_X64) || defined(__SSE2__)
+#define OHL_SSE2
+#include <emmintrin.h>
+#endif
+
 #ifdef __MINGW32__
 // blank out SetThreadDescription
 #define SetThreadDescription(x, y)
@@ -1,6 +1,9 @@
 #include <pch.h>
 
+#include <doctest/doctest.h>
+
 #include "args.h"
+#include "cache.h"
 #include "hooks.h"
 #include "loader.h"
 #include "unreal.h"
@@ -9,9 +12,14 @@
 using namespace ohl::unreal;
 
 namespace ohl::processing {
+TEST_SUITE_BEGIN("processing");
 
 static const auto HOTFIX_COUNTER_OFFSET = 100000;
 static const std::filesystem::path HOTFIX_DUMP_FILE = "hotfixes.dump";
+static const std::filesystem::path INDEXED_HOTFIX_DUMP_FILE = "hotfixes.indexed.dump";
+
+static constexpr std::string_view INDEXED_DUMP_MAGIC = "OHLHFDMP";
+static const uint32_t INDEXED_DUMP_FORMAT_VERSION = 1;
 
 /**
  * @brief Struct holding all the vf tables we need to grab copies of.
@@ -104,13 +112,21 @@ static void add_ref_controller(TSharedPtr<T>* ptr, void* vf_table) {
  *
  * @param str The FString to fill.
  * @param value The value to set.
+ * @param suffix A suffix to append to the value.
  */
-static void alloc_string(FString* str, const std::string& value) {
-    auto wide = ohl::util::widen(value);
-    str->count = wide.size() + 1;
+static void alloc_string(FString* str, std::wstring_view value, std::wstring_view suffix = {}) {
+    str->count = value.size() + suffix.size() + 1;
     str->max = str->count;
     str->data = ohl::hooks::malloc<wchar_t>(str->count * sizeof(wchar_t));
-    wcsncpy(str->data, wide.c_str(), str->count - 1);
+    std::copy(value.begin(), value.end(), str->data);
+    std::copy(suffix.begin(), suffix.end(), str->data + value.size());
+    str->data[str->count - 1] = '\0';
+}
+static void alloc_string(FString* str, std::string_view value) {
+    // Never need more wchars than chars, so can widen straight into the allocation
+    str->max = value.size() + 1;
+    str->data = ohl::hooks::malloc<wchar_t>(str->max * sizeof(wchar_t));
+    str->count = ohl::util::widen_into(value, str->data) + 1;
     str->data[str->count - 1] = '\0';
 }
 
@@ -118,9 +134,19 @@ static void alloc_string(FString* str, const std::string& value) {
  * @brief Creates a json string object.
  *
  * @param value The value of the string.
+ * @param suffix A suffix to append to the value.
  * @return A pointer to the new object.
  */
-static FJsonValueString* create_json_string(const std::string& value) {
+static FJsonValueString* create_json_string(std::wstring_view value,
+                                            std::wstring_view suffix = {}) {
+    auto obj = ohl::hooks::malloc<FJsonValueString>(sizeof(FJsonValueString));
+    obj->vf_table = vf_table.json_value_string;
+    obj->type = EJson::String;
+    alloc_string(&obj->str, value, suffix);
+
+    return obj;
+}
+static FJsonValueString* create_json_string(std::string_view value) {
     auto obj = ohl::hooks::malloc<FJsonValueString>(sizeof(FJsonValueString));
     obj->vf_table = vf_table.json_value_string;
     obj->type = EJson::String;
@@ -138,7 +164,7 @@ static FJsonValueString* create_json_string(const std::string& value) {
  */
 template <size_t n>
 static FJsonObject* create_json_object(
-    const std::array<std::pair<std::string, FJsonValue*>, n>& entries) {
+    const std::array<std::pair<std::wstring_view, FJsonValue*>, n>& entries) {
     static_assert(0 < n && n <= ARRAYSIZE(KNOWN_OBJECT_PATTERNS));
 
     auto obj = ohl::hooks::malloc<FJsonObject>(sizeof(FJsonObject));
@@ -219,101 +245,716 @@ static std::string get_current_time_str(void) {
     return std::string(buf);
 }
 
-void handle_get_verification(void) {
-    LOGI << "[OHL] Starting to reload mods";
-    ohl::loader::reload();
+/**
+ * @brief Formats the counter suffix added to each hotfix key.
+ * @note Does not allocate.
+ *
+ * @param buf The buffer to format into.
+ * @param counter The value of the counter.
+ * @return A view of the formatted counter, pointing into the buffer.
+ */
+static std::wstring_view format_counter(std::array<wchar_t, 16>& buf, uint32_t counter) {
+    auto start = buf.end();
+    do {
+        *(--start) = L'0' + (counter % 10);
+        counter /= 10;
+    } while (counter > 0);
+
+    return std::wstring_view(&*start, buf.end() - start);
 }
 
-void handle_discovery_from_json(FJsonObject** json) {
-    gather_vf_tables(*json);
+/**
+ * @brief Appends hotfixes to the end of the micropatch parameters array.
+ * @note Only allocates the game objects, all strings are copied straight out of the payload.
+ *
+ * @param params The parameters array to append to.
+ * @param payload The pre-rendered hotfixes to inject.
+ */
+static void inject_hotfixes(FJsonValueArray* params, const ohl::loader::hotfix_payload& payload) {
+    auto new_hotfix_count = params->entries.count + payload.size();
+    if (new_hotfix_count > params->entries.max) {
+        params->entries.max = new_hotfix_count;
+        params->entries.data = ohl::hooks::realloc<TSharedPtr<FJsonValue>>(
+            params->entries.data, params->entries.max * sizeof(TSharedPtr<FJsonValue>));
+    }
 
-    auto services = (*json)->get<FJsonValueArray>(L"services");
+    std::array<wchar_t, 16> counter_buf{};
+    auto i = params->entries.count;
+    for (size_t hotfix_idx = 0; hotfix_idx < payload.size(); hotfix_idx++) {
+        auto hotfix = payload[hotfix_idx];
+        auto counter = format_counter(counter_buf, i + HOTFIX_COUNTER_OFFSET);
 
-    FJsonObject* micropatch = nullptr;
-    for (auto i = 0; i < services->count(); i++) {
-        auto service = services->get<FJsonValueObject>(i)->to_obj();
-        if (service->get<FJsonValueString>(L"service_name")->to_wstr() == L"Micropatch") {
-            micropatch = service;
-            break;
+        auto hotfix_entry =
+            create_json_object<2>({{{L"key", create_json_string(hotfix.key, counter)},
+                                    {L"value", create_json_string(hotfix.value)}}});
+
+        params->entries.data[i].obj = create_json_value_object(hotfix_entry);
+        add_ref_controller(&params->entries.data[i], vf_table.shared_ptr_json_value);
+        i++;
+    }
+
+    params->entries.count = new_hotfix_count;
+}
+
+/**
+ * @brief Stands in for the game's allocator while testing, allocating out of a memory resource.
+ * @note Frees nothing, everything is released when the resource is.
+ */
+struct mock_allocator {
+    struct header {
+        size_t size;
+        size_t padding;
+    };
+
+    static inline std::pmr::memory_resource* resource = nullptr;
+
+    static void* malloc(size_t count, uint32_t align) {
+        auto ptr = reinterpret_cast<header*>(resource->allocate(sizeof(header) + count, align));
+        ptr->size = count;
+        return ptr + 1;
+    }
+
+    static void* realloc(void* original, size_t count, uint32_t align) {
+        auto ptr = mock_allocator::malloc(count, align);
+        if (original != nullptr) {
+            auto original_size = (reinterpret_cast<header*>(original) - 1)->size;
+            memcpy(ptr, original, std::min(original_size, count));
         }
+        return ptr;
     }
 
-    // This happens during the first verify call so don't throw
-    if (micropatch == nullptr) {
-        return;
+    static void free(void* /* data */) {}
+
+    mock_allocator(std::pmr::memory_resource* resource) {
+        mock_allocator::resource = resource;
+        ohl::hooks::set_allocator(&mock_allocator::malloc, &mock_allocator::realloc,
+                                  &mock_allocator::free);
     }
+    ~mock_allocator() {
+        ohl::hooks::set_allocator(nullptr, nullptr, nullptr);
+        mock_allocator::resource = nullptr;
+    }
+};
 
-    if (!vf_table.found) {
-        throw std::runtime_error("Didn't find vf tables in time!");
+TEST_CASE("processing::inject_hotfixes") {
+    std::pmr::monotonic_buffer_resource resource{};
+    mock_allocator allocator{&resource};
+
+    const std::pmr::deque<ohl::loader::hotfix> hotfixes{
+        {"SparkPatchEntry", "(1,1,0,),/Game/Gear/Weapons/_Shared/_Design/Balance/Balance.Balance"},
+        {"SparkEarlyLevelPatchEntry", "(1,11,0,Map_P),/Some/Object"},
+        {"SparkPatchEntry", ""},
+    };
+    const ohl::loader::hotfix_payload payload{hotfixes};
+
+    // Start with an existing entry, injected ones should go after it
+    auto params = ohl::hooks::malloc<FJsonValueArray>(sizeof(FJsonValueArray));
+    params->type = EJson::Array;
+    params->entries.count = 1;
+    params->entries.max = 1;
+    params->entries.data =
+        ohl::hooks::malloc<TSharedPtr<FJsonValue>>(sizeof(TSharedPtr<FJsonValue>));
+    auto existing_obj = create_json_object<1>({{{L"key", create_json_string("existing")}}});
+    auto existing = create_json_value_object(existing_obj);
+    params->entries.data[0].obj = existing;
+
+    inject_hotfixes(params, payload);
+
+    REQUIRE(params->count() == hotfixes.size() + 1);
+    CHECK(params->entries.max >= params->entries.count);
+    CHECK(params->get<FJsonValueObject>(0) == existing);
+
+    for (size_t i = 0; i < hotfixes.size(); i++) {
+        auto entry = params->get<FJsonValueObject>(i + 1)->to_obj();
+        auto key = entry->get<FJsonValueString>(L"key")->str;
+        auto value = entry->get<FJsonValueString>(L"value")->str;
+
+        auto expected_key =
+            hotfixes[i].get_key() + std::to_string(i + 1 + HOTFIX_COUNTER_OFFSET);
+        CHECK(key.to_wstr_view() == ohl::util::widen(expected_key));
+        CHECK(value.to_wstr_view() == ohl::util::widen(hotfixes[i].value));
+
+        // Strings must be null terminated, with the terminator included in the count
+        CHECK(key.data[key.count - 1] == L'\0');
+        CHECK(value.data[value.count - 1] == L'\0');
     }
 
-    auto hotfixes = ohl::loader::get_hotfixes();
+    std::array<wchar_t, 16> counter_buf{};
+    CHECK(format_counter(counter_buf, 0) == L"0");
+    CHECK(format_counter(counter_buf, 100123) == L"100123");
+    CHECK(format_counter(counter_buf, UINT32_MAX) == L"4294967295");
+}
 
-    LOGD << "[OHL] Allocating space for hotfixes";
+TEST_CASE("processing::inject_hotfixes - pre-rendered vs per hotfix benchmark" * doctest::skip()) {
+    static const auto HOTFIX_COUNT = 200000;
 
-    auto params = micropatch->get<FJsonValueArray>(L"parameters");
-    auto new_hotfix_count = params->entries.count + hotfixes.size();
-    if (new_hotfix_count > params->entries.max) {
-        params->entries.max = new_hotfix_count;
+    std::pmr::deque<ohl::loader::hotfix> hotfixes{};
+    for (auto i = 0; i < HOTFIX_COUNT; i++) {
+        hotfixes.emplace_back("SparkPatchEntry",
+                              "(1,1,0,),/Game/Gear/Weapons/_Shared/_Design/Balance/Balance_"
+                                  + std::to_string(i)
+                                  + ".Balance,RarityData.BaseValueConstant,0,,1.0");
+    }
+
+    using clock = std::chrono::steady_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    auto create_params = []() {
+        auto params = ohl::hooks::malloc<FJsonValueArray>(sizeof(FJsonValueArray));
+        params->type = EJson::Array;
+        return params;
+    };
+
+    // What the hook used to do, converting each hotfix as it's injected
+    milliseconds per_hotfix_time{};
+    {
+        std::pmr::monotonic_buffer_resource resource{};
+        mock_allocator allocator{&resource};
+        auto params = create_params();
+
+        auto start = clock::now();
+        params->entries.max = hotfixes.size();
         params->entries.data = ohl::hooks::realloc<TSharedPtr<FJsonValue>>(
             params->entries.data, params->entries.max * sizeof(TSharedPtr<FJsonValue>));
+        auto i = params->entries.count;
+        for (const auto& hotfix : hotfixes) {
+            auto hotfix_entry = create_json_object<2>(
+                {{{L"key", create_json_string(hotfix.get_key()
+                                              + std::to_string(i + HOTFIX_COUNTER_OFFSET))},
+                  {L"value", create_json_string(hotfix.value)}}});
+
+            params->entries.data[i].obj = create_json_value_object(hotfix_entry);
+            add_ref_controller(&params->entries.data[i], vf_table.shared_ptr_json_value);
+            i++;
+        }
+        params->entries.count = i;
+        per_hotfix_time = duration_cast<milliseconds>(clock::now() - start);
     }
 
-    LOGD << "[OHL] Injecting hotfixes";
+    // Rendering happens on the reload thread, so isn't part of the hook's time
+    auto render_start = clock::now();
+    const ohl::loader::hotfix_payload payload{hotfixes};
+    auto render_time = duration_cast<milliseconds>(clock::now() - render_start);
 
-    auto i = params->entries.count;
-    for (const auto& [key, value] : hotfixes) {
-        auto hotfix_entry = create_json_object<2>(
-            {{{"key", create_json_string(key + std::to_string(i + HOTFIX_COUNTER_OFFSET))},
-              {"value", create_json_string(value)}}});
+    milliseconds pre_rendered_time{};
+    {
+        std::pmr::monotonic_buffer_resource resource{};
+        mock_allocator allocator{&resource};
+        auto params = create_params();
 
-        params->entries.data[i].obj = create_json_value_object(hotfix_entry);
-        add_ref_controller(&params->entries.data[i], vf_table.shared_ptr_json_value);
-        i++;
+        auto start = clock::now();
+        inject_hotfixes(params, payload);
+        pre_rendered_time = duration_cast<milliseconds>(clock::now() - start);
+
+        CHECK(params->count() == HOTFIX_COUNT);
     }
 
-    params->entries.count = new_hotfix_count;
+    MESSAGE("Hook time, per hotfix: " << per_hotfix_time.count()
+                                      << "ms, pre-rendered: " << pre_rendered_time.count()
+                                      << "ms (rendering on reload thread: " << render_time.count()
+                                      << "ms)");
+}
 
-    LOGI << "[OHL] Injected hotfixes";
+/**
+ * @brief Struct holding everything needed to write a hotfix dump.
+ */
+struct dump_job {
+    std::filesystem::path path;
+    bool indexed;
+    // The entries which were already in the parameters before we injected ours
+    std::vector<std::pair<std::wstring, std::wstring>> existing;
+    // Keeps the injected hotfixes alive until they've been written
+    std::shared_ptr<const ohl::loader::loaded_data> data;
+};
 
-    if (ohl::args::dump_hotfixes()) {
-        LOGD << "[OHL] Dumping hotfixes";
-
-        // For some god forsaken reason the default behaviour of **w**ofstream is to output ascii.
-        // Since encodings are a pain, just write directly in binary.
-        // This also means we can actually use this to double check our utf8-utf16 conversion works
-        std::fstream dump(HOTFIX_DUMP_FILE, std::ios::out | std::ios::binary | std::ios::trunc);
-        if (!dump.is_open()) {
-            LOGE << "[OHL] Failed to open dump file!";
-            return;
+/**
+ * @brief Appends a wide string to a buffer as utf16le.
+ *
+ * @param buffer The buffer to append to.
+ * @param str The string to append.
+ */
+static void append_utf16(std::string& buffer, std::wstring_view str) {
+    if constexpr (sizeof(wchar_t) == sizeof(char16_t)) {
+        buffer.append(reinterpret_cast<const char*>(str.data()), str.size() * sizeof(wchar_t));
+    } else {
+        for (auto wchar : str) {
+            auto code_point = static_cast<uint32_t>(wchar);
+            std::array<char16_t, 2> units{static_cast<char16_t>(code_point), 0};
+            size_t count = 1;
+            if (code_point > 0xFFFF) {
+                code_point -= 0x10000;
+                units = {static_cast<char16_t>(0xD800 + (code_point >> 10)),
+                         static_cast<char16_t>(0xDC00 + (code_point & 0x3FF))};
+                count = 2;
+            }
+            buffer.append(reinterpret_cast<const char*>(units.data()), count * sizeof(char16_t));
         }
+    }
+}
 
-        // Since it should look like utf16, add a BOM
-        dump.put(0xFF);
-        dump.put(0xFE);
+/**
+ * @brief Renders a hotfix dump in the default format.
+ * @note This is utf16le text, with a BOM, and a `key: value` line per hotfix.
+ *
+ * @param job The dump to render.
+ * @return The contents of the dump file.
+ */
+static std::string render_dump(const dump_job& job) {
+    const auto& payload = job.data->rendered_hotfixes;
+
+    size_t wchar_count = 1;
+    for (const auto& [key, value] : job.existing) {
+        wchar_count += key.size() + value.size() + 3;
+    }
+    for (size_t i = 0; i < payload.size(); i++) {
+        auto hotfix = payload[i];
+        wchar_count += hotfix.key.size() + hotfix.value.size() + 13;
+    }
+
+    std::string buffer{};
+    buffer.reserve(wchar_count * sizeof(char16_t));
+
+    // Since it should look like utf16, add a BOM
+    append_utf16(buffer, L"\xFEFF");
+
+    for (const auto& [key, value] : job.existing) {
+        append_utf16(buffer, key);
+        append_utf16(buffer, L": ");
+        append_utf16(buffer, value);
+        append_utf16(buffer, L"\n");
+    }
+
+    std::array<wchar_t, 16> counter_buf{};
+    auto counter = job.existing.size() + HOTFIX_COUNTER_OFFSET;
+    for (size_t i = 0; i < payload.size(); i++, counter++) {
+        auto hotfix = payload[i];
+        append_utf16(buffer, hotfix.key);
+        append_utf16(buffer, format_counter(counter_buf, static_cast<uint32_t>(counter)));
+        append_utf16(buffer, L": ");
+        append_utf16(buffer, hotfix.value);
+        append_utf16(buffer, L"\n");
+    }
+
+    return buffer;
+}
+
+/**
+ * @brief Renders a hotfix dump in the indexed format.
+ * @note Starts with a header of the magic, the format version (uint32), the hotfix count (uint64),
+ *       then count + 1 file offsets (uint64), one to the start of each line and one to the end of
+ *       the file. This is followed by utf8 text, with a `key: value` line per hotfix.
+ *
+ * @param job The dump to render.
+ * @return The contents of the dump file.
+ */
+static std::string render_indexed_dump(const dump_job& job) {
+    const auto& hotfixes = job.data->hotfixes;
+    const uint64_t count = job.existing.size() + hotfixes.size();
+
+    std::string buffer{INDEXED_DUMP_MAGIC};
+    auto put = [&](auto value) {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    put(INDEXED_DUMP_FORMAT_VERSION);
+    put(count);
+
+    // Fill in the index as we go
+    auto index_start = buffer.size();
+    buffer.resize(index_start + (count + 1) * sizeof(uint64_t));
+    auto set_index = [&](size_t idx) {
+        uint64_t offset = buffer.size();
+        memcpy(&buffer[index_start + idx * sizeof(uint64_t)], &offset, sizeof(offset));
+    };
+
+    size_t idx = 0;
+    for (const auto& [key, value] : job.existing) {
+        set_index(idx++);
+        buffer += ohl::util::narrow(key);
+        buffer += ": ";
+        buffer += ohl::util::narrow(value);
+        buffer += '\n';
+    }
+
+    auto counter = job.existing.size() + HOTFIX_COUNTER_OFFSET;
+    for (const auto& hotfix : hotfixes) {
+        set_index(idx++);
+        buffer += hotfix.get_key();
+        buffer += std::to_string(counter++);
+        buffer += ": ";
+        buffer += hotfix.value;
+        buffer += '\n';
+    }
+    set_index(idx);
+
+    return buffer;
+}
+
+/**
+ * @brief Renders and writes a hotfix dump.
+ *
+ * @param job The dump to write.
+ */
+static void write_dump(const dump_job& job) {
+    try {
+        auto contents = job.indexed ? render_indexed_dump(job) : render_dump(job);
+        ohl::cache::write(job.path, contents);
+        LOGI << "[OHL] Dumped hotfixes to " << job.path;
+    } catch (const std::runtime_error& ex) {
+        LOGE << "[OHL] Failed to dump hotfixes: " << ex.what();
+    }
+}
 
-        for (auto i = 0; i < params->count(); i++) {
+/**
+ * @brief Writes hotfix dumps on a background thread, so that the game thread only needs to queue
+ *        them.
+ * @note If several dumps are queued while one's being written, only the latest gets written.
+ */
+class dump_writer {
+   private:
+    std::mutex mutex;
+    std::condition_variable queued_cv;
+    std::condition_variable idle_cv;
+    std::optional<dump_job> queued;
+    bool writing;
+    bool stopping;
+    std::thread thread;
+
+    /**
+     * @brief Main loop of the dump thread.
+     */
+    void run(void) {
+        SetThreadDescription(GetCurrentThread(), L"OpenHotfixLoader Dumper");
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (true) {
+            this->queued_cv.wait(lock, [&]() { return this->stopping || this->queued; });
+            if (!this->queued) {
+                return;
+            }
+
+            auto job = std::move(*this->queued);
+            this->queued.reset();
+            this->writing = true;
+
+            lock.unlock();
+            write_dump(job);
+            lock.lock();
+
+            this->writing = false;
+            this->idle_cv.notify_all();
+        }
+    }
+
+   public:
+    dump_writer(void) : writing(false), stopping(false) {}
+
+    /**
+     * @brief Stops the dump thread, after writing any queued dump.
+     */
+    ~dump_writer() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->queued_cv.notify_all();
+
+        if (this->thread.joinable()) {
+            this->thread.join();
+        }
+    }
+
+    dump_writer(const dump_writer&) = delete;
+    dump_writer& operator=(const dump_writer&) = delete;
+
+    /**
+     * @brief Queues a dump to be written.
+     *
+     * @param job The dump to write.
+     */
+    void queue(dump_job&& job) {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->queued = std::move(job);
+
+            if (!this->thread.joinable()) {
+                this->thread = std::thread(&dump_writer::run, this);
+            }
+        }
+        this->queued_cv.notify_one();
+    }
+
+    /**
+     * @brief Waits until all queued dumps have been written.
+     */
+    void wait(void) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->idle_cv.wait(lock, [&]() { return !this->queued && !this->writing; });
+    }
+};
+
+/**
+ * @brief Gets the writer dumps are written on.
+ *
+ * @return The writer.
+ */
+static dump_writer& get_dump_writer(void) {
+    return ohl::util::leaked([] { return dump_writer(); });
+}
+
+/**
+ * @brief Queues a dump of the micropatch parameters, after hotfixes have been injected into them.
+ * @note Only copies the entries which were there before injecting, everything else is rendered
+ *       from the loaded data on the dump thread.
+ *
+ * @param params The parameters array.
+ * @param existing_count How many entries were in the parameters before injecting.
+ * @param data The data the injected hotfixes came from.
+ * @param path The path to write the dump to.
+ * @param indexed If to write the indexed format.
+ */
+static void queue_dump(const FJsonValueArray* params,
+                       size_t existing_count,
+                       std::shared_ptr<const ohl::loader::loaded_data> data,
+                       const std::filesystem::path& path,
+                       bool indexed) {
+    dump_job job{path, indexed, {}, std::move(data)};
+    job.existing.reserve(existing_count);
+    for (uint32_t i = 0; i < existing_count; i++) {
+        auto entry = params->get<FJsonValueObject>(i)->to_obj();
+        job.existing.emplace_back(entry->get<FJsonValueString>(L"key")->str.to_wstr_view(),
+                                  entry->get<FJsonValueString>(L"value")->str.to_wstr_view());
+    }
+
+    get_dump_writer().queue(std::move(job));
+}
+
+/**
+ * @brief Creates a micropatch parameters array, holding some existing hotfixes.
+ * @note Allocates using the game's allocator, so should be used with a mock allocator.
+ *
+ * @param existing The existing hotfixes to add.
+ * @return The parameters array.
+ */
+static FJsonValueArray* create_test_params(
+    const std::vector<std::pair<std::string, std::string>>& existing) {
+    auto params = ohl::hooks::malloc<FJsonValueArray>(sizeof(FJsonValueArray));
+    params->type = EJson::Array;
+    params->entries.count = 0;
+    params->entries.max = static_cast<int32_t>(existing.size());
+    params->entries.data = ohl::hooks::malloc<TSharedPtr<FJsonValue>>(
+        std::max<size_t>(existing.size(), 1) * sizeof(TSharedPtr<FJsonValue>));
+    for (const auto& [key, value] : existing) {
+        auto obj = create_json_object<2>(
+            {{{L"key", create_json_string(key)}, {L"value", create_json_string(value)}}});
+        params->entries.data[params->entries.count++].obj = create_json_value_object(obj);
+    }
+    return params;
+}
+
+TEST_CASE("processing::render_dump") {
+    std::pmr::monotonic_buffer_resource resource{};
+    mock_allocator allocator{&resource};
+
+    std::pmr::deque<ohl::loader::hotfix> hotfixes{
+        {"SparkPatchEntry", "(1,1,0,),/Some/Object,Attr,0,,1"},
+        {"SparkEarlyLevelPatchEntry", u8"(1,11,0,Map_P),/Some/Object,Name,0,,Cú Chulainn"},
+        {"SparkPatchEntry", ""},
+    };
+    auto data = std::make_shared<const ohl::loader::loaded_data>(std::move(hotfixes));
+
+    auto params = create_test_params({{"SparkServerEntry1", "server value"}});
+    auto existing_count = params->count();
+    inject_hotfixes(params, data->rendered_hotfixes);
+
+    dump_job job{"", false, {{L"SparkServerEntry1", L"server value"}}, data};
+
+    SUBCASE("compatible") {
+        // What the hook used to write, straight from the injected game objects
+        std::string expected{};
+        append_utf16(expected, L"\xFEFF");
+        for (uint32_t i = 0; i < params->count(); i++) {
             auto entry = params->get<FJsonValueObject>(i)->to_obj();
-            auto key = entry->get<FJsonValueString>(L"key")->str;
-            auto value = entry->get<FJsonValueString>(L"value")->str;
+            append_utf16(expected, entry->get<FJsonValueString>(L"key")->str.to_wstr_view());
+            append_utf16(expected, L": ");
+            append_utf16(expected, entry->get<FJsonValueString>(L"value")->str.to_wstr_view());
+            append_utf16(expected, L"\n");
+        }
+
+        auto rendered = render_dump(job);
+        CHECK(rendered == expected);
+        CHECK(std::string_view(rendered).substr(0, 2) == "\xFF\xFE");
+    }
+
+    SUBCASE("indexed") {
+        auto rendered = render_indexed_dump(job);
+
+        REQUIRE(rendered.size() > INDEXED_DUMP_MAGIC.size() + 12);
+        CHECK(std::string_view(rendered).substr(0, INDEXED_DUMP_MAGIC.size())
+              == INDEXED_DUMP_MAGIC);
+
+        uint32_t version;
+        uint64_t count;
+        memcpy(&version, &rendered[INDEXED_DUMP_MAGIC.size()], sizeof(version));
+        memcpy(&count, &rendered[INDEXED_DUMP_MAGIC.size() + 4], sizeof(count));
+        CHECK(version == INDEXED_DUMP_FORMAT_VERSION);
+        REQUIRE(count == params->count());
+
+        std::vector<uint64_t> index(count + 1);
+        memcpy(index.data(), &rendered[INDEXED_DUMP_MAGIC.size() + 12],
+               index.size() * sizeof(uint64_t));
+        CHECK(index.back() == rendered.size());
+
+        // Each line should be the utf8 version of the entry in the game objects
+        for (uint32_t i = 0; i < count; i++) {
+            auto entry = params->get<FJsonValueObject>(i)->to_obj();
+            auto expected =
+                ohl::util::narrow(entry->get<FJsonValueString>(L"key")->str.to_wstr_view()) + ": "
+                + ohl::util::narrow(entry->get<FJsonValueString>(L"value")->str.to_wstr_view())
+                + "\n";
+            CHECK(std::string_view(rendered).substr(index[i], index[i + 1] - index[i])
+                  == expected);
+        }
+    }
+
+    SUBCASE("queue_dump") {
+        const auto path = std::filesystem::temp_directory_path() / "ohl_hotfixes_test.dump";
+        std::filesystem::remove(path);
+
+        queue_dump(params, existing_count, data, path, false);
+        get_dump_writer().wait();
+
+        std::string written{};
+        {
+            std::ifstream in{path, std::ios::binary};
+            written.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        job.path = path;
+        CHECK(written == render_dump(job));
+
+        std::filesystem::remove(path);
+    }
+}
 
-            static_assert(sizeof(wchar_t) % sizeof(char) == 0);
-            const auto chars_per_wchar = sizeof(wchar_t) / sizeof(char);
+TEST_CASE("processing::queue_dump - game thread benchmark" * doctest::skip()) {
+    static const auto HOTFIX_COUNT = 200000;
+    static const auto EXISTING_COUNT = 100;
 
-            dump.write(reinterpret_cast<char*>(key.data), (key.count - 1) * chars_per_wchar);
+    std::vector<std::pair<std::string, std::string>> existing{};
+    for (auto i = 0; i < EXISTING_COUNT; i++) {
+        existing.emplace_back("SparkServerEntry" + std::to_string(i), "(1,1,0,),/Some/Object");
+    }
+
+    std::pmr::deque<ohl::loader::hotfix> hotfixes{};
+    for (auto i = 0; i < HOTFIX_COUNT; i++) {
+        hotfixes.emplace_back("SparkPatchEntry",
+                              "(1,1,0,),/Game/Gear/Weapons/_Shared/_Design/Balance/Balance_"
+                                  + std::to_string(i)
+                                  + ".Balance,RarityData.BaseValueConstant,0,,1.0");
+    }
+    auto data = std::make_shared<const ohl::loader::loaded_data>(std::move(hotfixes));
+    const auto path = std::filesystem::temp_directory_path() / "ohl_hotfixes_bench.dump";
+
+    using clock = std::chrono::steady_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    std::pmr::monotonic_buffer_resource resource{};
+    mock_allocator allocator{&resource};
+
+    auto time_injecting = [&](auto&& dump) {
+        auto params = create_test_params(existing);
+        auto start = clock::now();
+        inject_hotfixes(params, data->rendered_hotfixes);
+        dump(params);
+        return duration_cast<milliseconds>(clock::now() - start);
+    };
+
+    auto no_dump_time = time_injecting([](FJsonValueArray*) {});
 
+    // What the hook used to do, walking the game objects and writing them a few bytes at a time
+    auto old_dump_time = time_injecting([&](FJsonValueArray* params) {
+        std::fstream dump(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        dump.put(0xFF);
+        dump.put(0xFE);
+        for (uint32_t i = 0; i < params->count(); i++) {
+            auto entry = params->get<FJsonValueObject>(i)->to_obj();
+            auto key = entry->get<FJsonValueString>(L"key")->str;
+            auto value = entry->get<FJsonValueString>(L"value")->str;
+            dump.write(reinterpret_cast<char*>(key.data), (key.count - 1) * sizeof(wchar_t));
             dump.put(':');
             dump.put(0x00);
             dump.put(' ');
             dump.put(0x00);
-
-            dump.write(reinterpret_cast<char*>(value.data), (value.count - 1) * chars_per_wchar);
-
+            dump.write(reinterpret_cast<char*>(value.data), (value.count - 1) * sizeof(wchar_t));
             dump.put('\n');
             dump.put(0x00);
         }
-        dump.close();
-        LOGI << "[OHL] Dumped hotfixes to file";
+    });
+
+    for (auto indexed : {false, true}) {
+        auto queued_time = time_injecting([&](FJsonValueArray* params) {
+            queue_dump(params, EXISTING_COUNT, data, path, indexed);
+        });
+
+        auto write_start = clock::now();
+        get_dump_writer().wait();
+        auto write_time = duration_cast<milliseconds>(clock::now() - write_start);
+
+        MESSAGE((indexed ? "Indexed" : "Default")
+                << " format, game thread time: no dump: " << no_dump_time.count()
+                << "ms, old dump: " << old_dump_time.count() << "ms, queued dump: "
+                << queued_time.count() << "ms (" << write_time.count()
+                << "ms more on dump thread)");
+    }
+
+    std::filesystem::remove(path);
+}
+
+void handle_get_verification(void) {
+    LOGI << "[OHL] Starting to reload mods";
+    ohl::loader::reload();
+}
+
+void handle_discovery_from_json(FJsonObject** json) {
+    gather_vf_tables(*json);
+
+    auto services = (*json)->get<FJsonValueArray>(L"services");
+
+    FJsonObject* micropatch = nullptr;
+    for (auto i = 0; i < services->count(); i++) {
+        auto service = services->get<FJsonValueObject>(i)->to_obj();
+        if (service->get<FJsonValueString>(L"service_name")->str.to_wstr_view() == L"Micropatch") {
+            micropatch = service;
+            break;
+        }
+    }
+
+    // This happens during the first verify call so don't throw
+    if (micropatch == nullptr) {
+        return;
+    }
+
+    if (!vf_table.found) {
+        throw std::runtime_error("Didn't find vf tables in time!");
+    }
+
+    auto data = ohl::loader::get_loaded_data();
+    auto params = micropatch->get<FJsonValueArray>(L"parameters");
+
+    LOGD << "[OHL] Injecting hotfixes";
+
+    auto existing_count = params->count();
+    inject_hotfixes(params, data->rendered_hotfixes);
+
+    LOGI << "[OHL] Injected hotfixes";
+
+    if (ohl::args::dump_hotfixes()) {
+        LOGD << "[OHL] Queueing hotfix dump";
+
+        auto indexed = ohl::args::dump_indexed();
+        queue_dump(params, existing_count, std::move(data),
+                   indexed ? INDEXED_HOTFIX_DUMP_FILE : HOTFIX_DUMP_FILE, indexed);
     }
 }
 
@@ -322,7 +963,8 @@ void handle_news_from_json(ohl::unreal::FJsonObject** json) {
         throw std::runtime_error("Didn't find vf tables in time!");
     }
 
-    auto news_items = ohl::loader::get_news_items();
+    auto data = ohl::loader::get_loaded_data();
+    const auto& news_items = data->news_items;
 
     LOGD << "[OHL] Allocating space for news items";
 
@@ -343,32 +985,32 @@ void handle_news_from_json(ohl::unreal::FJsonObject** json) {
     auto i = 0;
     for (const auto& news_item : news_items) {
         auto contents_obj =
-            create_json_object<2>({{{"header", create_json_string(news_item.header)},
-                                    {"body", create_json_string(news_item.body)}}});
+            create_json_object<2>({{{L"header", create_json_string(news_item.header)},
+                                    {L"body", create_json_string(news_item.body)}}});
         auto contents_arr = create_json_array({create_json_value_object(contents_obj)});
 
         auto image_meta_tag_obj =
-            create_json_object<1>({{{"tag", create_json_string("img_game_sm_noloc")}}});
+            create_json_object<1>({{{L"tag", create_json_string("img_game_sm_noloc")}}});
         auto image_tags_obj =
-            create_json_object<2>({{{"meta_tag", create_json_value_object(image_meta_tag_obj)},
-                                    {"value", create_json_string(news_item.image_url)}}});
+            create_json_object<2>({{{L"meta_tag", create_json_value_object(image_meta_tag_obj)},
+                                    {L"value", create_json_string(news_item.image_url)}}});
 
         auto article_meta_tag_obj =
-            create_json_object<1>({{{"tag", create_json_string("url_learn_more_noloc")}}});
+            create_json_object<1>({{{L"tag", create_json_string("url_learn_more_noloc")}}});
         auto article_tags_obj =
-            create_json_object<2>({{{"meta_tag", create_json_value_object(article_meta_tag_obj)},
-                                    {"value", create_json_string(news_item.article_url)}}});
+            create_json_object<2>({{{L"meta_tag", create_json_value_object(article_meta_tag_obj)},
+                                    {L"value", create_json_string(news_item.article_url)}}});
 
         auto tags_arr = create_json_array(
             {create_json_value_object(image_tags_obj), create_json_value_object(article_tags_obj)});
 
         auto availablities_obj =
-            create_json_object<1>({{{"startTime", create_json_string(get_current_time_str())}}});
+            create_json_object<1>({{{L"startTime", create_json_string(get_current_time_str())}}});
         auto availabilities_arr = create_json_array({create_json_value_object(availablities_obj)});
 
-        auto news_obj = create_json_object<3>({{{"contents", contents_arr},
-                                                {"article_tags", tags_arr},
-                                                {"availabilities", availabilities_arr}}});
+        auto news_obj = create_json_object<3>({{{L"contents", contents_arr},
+                                                {L"article_tags", tags_arr},
+                                                {L"availabilities", availabilities_arr}}});
 
         news_data->entries.data[i].obj = create_json_value_object(news_obj);
         add_ref_controller(&news_data->entries.data[i], vf_table.shared_ptr_json_value);
@@ -381,18 +1023,16 @@ void handle_news_from_json(ohl::unreal::FJsonObject** json) {
 }
 
 bool handle_add_image_to_cache(TSharedPtr<FSparkRequest>* req) {
-    auto url = ohl::util::narrow(req->obj->get_url());
-
-    auto news_items = ohl::loader::get_news_items();
-    auto may_continue = std::find_if(news_items.begin(), news_items.end(),
-                                     [&](auto item) { return item.image_url == url; })
-                        == news_items.end();
-
-    if (!may_continue) {
-        LOGI << "[OHL] Prevented news icon from being cached: " << url;
+    // Don't stall the game waiting on a reload, the previous news items are good enough
+    auto data = ohl::loader::get_loaded_data(false);
+    if (!data->image_urls.contains(req->obj->get_url_view())) {
+        return true;
     }
 
-    return may_continue;
+    LOGI << "[OHL] Prevented news icon from being cached: "
+         << ohl::util::narrow(req->obj->get_url());
+    return false;
 }
 
+TEST_SUITE_END();
 }  // namespace ohl::processing
@@ -0,0 +1,929 @@
+#include <pch.h>
+
+#include <doctest/doctest.h>
+
+#include "cache.h"
+#include "sigscan.h"
+#include "util.h"
+
+namespace ohl::sigscan {
+TEST_SUITE_BEGIN("sigscan");
+
+// How many bytes each thread scans for all patterns before moving on, should fit in cache
+static const size_t CHUNK_SIZE = 64 * 1024;
+
+// How much of the region to sample when working out which bytes are rare
+static const size_t SAMPLE_COUNT = 64;
+static const size_t SAMPLE_SIZE = 4 * 1024;
+
+/**
+ * @brief A pattern, prepared for scanning.
+ */
+struct prepared_pattern {
+    const struct pattern* pattern;
+    // Offsets of the two rarest fully masked bytes, which every candidate must match before the
+    //  full pattern is checked. The same if there's only one, std::nullopt if there are none.
+    std::optional<size_t> anchor;
+    size_t second_anchor;
+};
+
+/**
+ * @brief Counts how often each byte appears in a region, sampling it if it's large.
+ *
+ * @param start The start of the region.
+ * @param size The size of the region.
+ * @return The amount of times each byte was seen.
+ */
+static std::array<size_t, 256> sample_byte_frequencies(const uint8_t* start, size_t size) {
+    std::array<size_t, 256> frequencies{};
+
+    auto count = [&](size_t offset, size_t length) {
+        for (size_t i = offset; i < offset + length; i++) {
+            frequencies[start[i]]++;
+        }
+    };
+
+    if (size <= SAMPLE_COUNT * SAMPLE_SIZE) {
+        count(0, size);
+    } else {
+        auto stride = (size - SAMPLE_SIZE) / (SAMPLE_COUNT - 1);
+        for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+            count(i * stride, SAMPLE_SIZE);
+        }
+    }
+
+    return frequencies;
+}
+
+/**
+ * @brief Picks the anchors of a pattern.
+ *
+ * @param pattern The pattern to prepare.
+ * @param frequencies How often each byte appears in the region being scanned.
+ * @return The prepared pattern.
+ */
+static prepared_pattern prepare(const pattern& pattern,
+                                const std::array<size_t, 256>& frequencies) {
+    prepared_pattern prepared{&pattern, std::nullopt, 0};
+
+    std::vector<size_t> masked_offsets{};
+    for (size_t i = 0; i < pattern.size; i++) {
+        if (pattern.mask[i] == 0xFF) {
+            masked_offsets.push_back(i);
+        }
+    }
+    if (masked_offsets.empty()) {
+        return prepared;
+    }
+
+    // Stable, so ties go to the earliest byte
+    std::stable_sort(masked_offsets.begin(), masked_offsets.end(), [&](size_t a, size_t b) {
+        return frequencies[pattern.bytes[a]] < frequencies[pattern.bytes[b]];
+    });
+
+    prepared.anchor = masked_offsets[0];
+    prepared.second_anchor = masked_offsets.size() > 1 ? masked_offsets[1] : masked_offsets[0];
+    return prepared;
+}
+
+/**
+ * @brief Checks if a pattern matches at a given address.
+ *
+ * @param address The address to check.
+ * @param pattern The pattern to check.
+ * @return True if the pattern matches.
+ */
+static bool matches(const uint8_t* address, const pattern& pattern) {
+    for (size_t i = 0; i < pattern.size; i++) {
+        if ((address[i] & pattern.mask[i]) != pattern.bytes[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Scans part of a region for a single pattern.
+ *
+ * @param start The start of the full region.
+ * @param begin The first offset to check.
+ * @param end The offset to stop checking at. The pattern must fit in the region when starting at
+ *            any offset before it.
+ * @param prepared The pattern to scan for.
+ * @param found The list to append matched addresses to.
+ */
+static void scan_range(const uint8_t* start,
+                       size_t begin,
+                       size_t end,
+                       const prepared_pattern& prepared,
+                       std::vector<const uint8_t*>& found) {
+    const auto& pattern = *prepared.pattern;
+
+    size_t pos = begin;
+    if (!prepared.anchor) {
+        for (; pos < end; pos++) {
+            if (matches(start + pos, pattern)) {
+                found.push_back(start + pos);
+            }
+        }
+        return;
+    }
+
+    auto anchor = *prepared.anchor;
+    auto second_anchor = prepared.second_anchor;
+
+#ifdef OHL_SSE2
+    // Check 16 candidates at once, by comparing both anchors against the bytes 16 candidates would
+    //  have there. Since the pattern fits when starting at every candidate, these loads can't go
+    //  past the end of the region.
+    const auto anchor_byte = _mm_set1_epi8(static_cast<char>(pattern.bytes[anchor]));
+    const auto second_anchor_byte = _mm_set1_epi8(static_cast<char>(pattern.bytes[second_anchor]));
+    for (; pos + sizeof(__m128i) <= end; pos += sizeof(__m128i)) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(start + pos + anchor));
+        auto second_block =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(start + pos + second_anchor));
+        uint32_t mask = _mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(block, anchor_byte), _mm_cmpeq_epi8(second_block, second_anchor_byte)));
+
+        while (mask != 0) {
+#ifdef _MSC_VER
+            unsigned long idx;
+            _BitScanForward(&idx, mask);
+#else
+            auto idx = __builtin_ctz(mask);
+#endif
+            if (matches(start + pos + idx, pattern)) {
+                found.push_back(start + pos + idx);
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; pos < end; pos++) {
+        if (start[pos + anchor] == pattern.bytes[anchor]
+            && start[pos + second_anchor] == pattern.bytes[second_anchor]
+            && matches(start + pos, pattern)) {
+            found.push_back(start + pos);
+        }
+    }
+}
+
+std::vector<std::vector<const uint8_t*>> scan_all(const uint8_t* start,
+                                                  size_t size,
+                                                  const std::vector<pattern>& patterns,
+                                                  size_t thread_count) {
+    auto frequencies = sample_byte_frequencies(start, size);
+    std::vector<prepared_pattern> prepared{};
+    for (const auto& pattern : patterns) {
+        prepared.push_back(prepare(pattern, frequencies));
+    }
+
+    // Split into whole chunks, a pattern starting near the end of a thread's range may still read
+    //  into the next one
+    auto chunk_count = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    thread_count = std::clamp<size_t>(thread_count, 1, std::max<size_t>(chunk_count, 1));
+    auto chunks_per_thread = (chunk_count + thread_count - 1) / thread_count;
+
+    auto scan_thread = [&](size_t thread_idx) {
+        std::vector<std::vector<const uint8_t*>> found(patterns.size());
+
+        auto thread_begin = std::min(thread_idx * chunks_per_thread * CHUNK_SIZE, size);
+        auto thread_end = std::min(thread_begin + chunks_per_thread * CHUNK_SIZE, size);
+        for (auto chunk_begin = thread_begin; chunk_begin < thread_end;
+             chunk_begin += CHUNK_SIZE) {
+            auto chunk_end = std::min(chunk_begin + CHUNK_SIZE, thread_end);
+
+            for (size_t i = 0; i < prepared.size(); i++) {
+                const auto& pattern = *prepared[i].pattern;
+                if (pattern.size > size) {
+                    continue;
+                }
+                auto end = std::min(chunk_end, size - pattern.size + 1);
+                if (chunk_begin < end) {
+                    scan_range(start, chunk_begin, end, prepared[i], found[i]);
+                }
+            }
+        }
+
+        return found;
+    };
+
+    std::vector<std::future<std::vector<std::vector<const uint8_t*>>>> futures{};
+    for (size_t i = 1; i < thread_count; i++) {
+        futures.push_back(std::async(std::launch::async, scan_thread, i));
+    }
+    auto all_found = scan_thread(0);
+
+    // Threads cover ascending ranges, so appending in order keeps everything sorted
+    for (auto& future : futures) {
+        auto thread_found = future.get();
+        for (size_t i = 0; i < patterns.size(); i++) {
+            all_found[i].insert(all_found[i].end(), thread_found[i].begin(),
+                                thread_found[i].end());
+        }
+    }
+
+    return all_found;
+}
+
+std::vector<const uint8_t*> scan_unique(const uint8_t* start,
+                                        size_t size,
+                                        const std::vector<pattern>& patterns,
+                                        size_t thread_count) {
+    auto all_found = scan_all(start, size, patterns, thread_count);
+
+    std::vector<const uint8_t*> addresses{};
+    std::unordered_map<const uint8_t*, const char*> matched_names{};
+    std::string errors{};
+    for (size_t i = 0; i < patterns.size(); i++) {
+        const auto& found = all_found[i];
+        if (found.empty()) {
+            errors += std::string(" ") + patterns[i].name + " not found;";
+            addresses.push_back(nullptr);
+            continue;
+        }
+
+        // Matches are in ascending order, use the first, same as a linear scan would have
+        if (found.size() > 1) {
+            LOGW << "[OHL] Sigscan for " << patterns[i].name << " matched " << found.size()
+                 << " times, using the first match";
+        }
+        auto [existing, inserted] = matched_names.emplace(found[0], patterns[i].name);
+        if (!inserted) {
+            LOGW << "[OHL] Sigscan for " << patterns[i].name << " matched the same address as "
+                 << existing->second;
+        }
+
+        addresses.push_back(found[0]);
+    }
+
+    if (!errors.empty()) {
+        errors.pop_back();
+        throw std::runtime_error("Sigscan failed:" + errors);
+    }
+
+    return addresses;
+}
+
+#pragma region Cache
+
+static constexpr std::string_view CACHE_MAGIC = "OHLSIGSC";
+static const uint32_t CACHE_FORMAT_VERSION = 1;
+
+// Offsets into the PE headers, spelled out so that they can be read without windows.h
+static const uint16_t DOS_SIGNATURE = 0x5A4D;
+static const size_t DOS_LFANEW_OFFSET = 0x3C;
+static const uint32_t PE_SIGNATURE = 0x00004550;
+static const size_t PE_TIMESTAMP_OFFSET = 8;
+static const size_t PE_OPTIONAL_HEADER_OFFSET = 24;
+static const uint16_t OPTIONAL_MAGIC_32 = 0x10B;
+static const uint16_t OPTIONAL_MAGIC_64 = 0x20B;
+static const size_t OPTIONAL_IMAGE_BASE_OFFSET_32 = 28;
+static const size_t OPTIONAL_IMAGE_BASE_OFFSET_64 = 24;
+static const size_t OPTIONAL_SIZE_OF_IMAGE_OFFSET = 56;
+static const size_t OPTIONAL_SIZE_OF_HEADERS_OFFSET = 60;
+
+/**
+ * @brief Reads a value out of an image's headers.
+ * @note Throws a runtime error if it's out of bounds.
+ *
+ * @tparam T The type to read.
+ * @param image The start of the image.
+ * @param size The amount of the image which is safe to read.
+ * @param offset The offset to read at.
+ * @return The value.
+ */
+template <typename T>
+static T read_header(const uint8_t* image, size_t size, size_t offset) {
+    if (offset > size || size - offset < sizeof(T)) {
+        throw std::runtime_error("Image headers are truncated");
+    }
+    T value;
+    memcpy(&value, image + offset, sizeof(T));
+    return value;
+}
+
+image_key get_image_key(const uint8_t* image, size_t size) {
+    if (read_header<uint16_t>(image, size, 0) != DOS_SIGNATURE) {
+        throw std::runtime_error("Image has no DOS header");
+    }
+    size_t pe = read_header<uint32_t>(image, size, DOS_LFANEW_OFFSET);
+    if (read_header<uint32_t>(image, size, pe) != PE_SIGNATURE) {
+        throw std::runtime_error("Image has no PE header");
+    }
+
+    auto optional = pe + PE_OPTIONAL_HEADER_OFFSET;
+    size_t image_base_offset;
+    size_t image_base_size;
+    switch (read_header<uint16_t>(image, size, optional)) {
+        case OPTIONAL_MAGIC_32:
+            image_base_offset = optional + OPTIONAL_IMAGE_BASE_OFFSET_32;
+            image_base_size = sizeof(uint32_t);
+            break;
+        case OPTIONAL_MAGIC_64:
+            image_base_offset = optional + OPTIONAL_IMAGE_BASE_OFFSET_64;
+            image_base_size = sizeof(uint64_t);
+            break;
+        default:
+            throw std::runtime_error("Image has an unknown optional header format");
+    }
+
+    image_key key{};
+    key.timestamp = read_header<uint32_t>(image, size, pe + PE_TIMESTAMP_OFFSET);
+    key.size = read_header<uint32_t>(image, size, optional + OPTIONAL_SIZE_OF_IMAGE_OFFSET);
+
+    size_t headers_size =
+        read_header<uint32_t>(image, size, optional + OPTIONAL_SIZE_OF_HEADERS_OFFSET);
+    if (headers_size > size
+        || headers_size < optional + OPTIONAL_SIZE_OF_HEADERS_OFFSET + sizeof(uint32_t)) {
+        throw std::runtime_error("Image headers are truncated");
+    }
+
+    // The loader overwrites the image base with wherever it actually loaded the image, which moves
+    //  every launch thanks to ASLR
+    std::string headers{reinterpret_cast<const char*>(image), headers_size};
+    memset(headers.data() + image_base_offset, 0, image_base_size);
+    key.header_hash = ohl::util::hash_bytes(headers);
+
+    return key;
+}
+
+/**
+ * @brief Hashes a list of patterns, so that the cache gets discarded when they change.
+ *
+ * @param patterns The patterns to hash.
+ * @return The hash.
+ */
+static uint64_t hash_patterns(const std::vector<pattern>& patterns) {
+    std::string data{};
+    for (const auto& pattern : patterns) {
+        auto size = static_cast<uint64_t>(pattern.size);
+        data.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        data.append(pattern.name);
+        data.push_back('\0');
+        data.append(reinterpret_cast<const char*>(pattern.bytes), pattern.size);
+        data.append(reinterpret_cast<const char*>(pattern.mask), pattern.size);
+    }
+    return ohl::util::hash_bytes(data);
+}
+
+/**
+ * @brief Struct holding the contents of a sigscan cache file.
+ */
+struct cache_contents {
+    image_key key;
+    uint64_t patterns_hash;
+    // Offsets of each pattern from the start of the image
+    std::vector<uint64_t> offsets;
+};
+
+/**
+ * @brief Encodes the contents of a sigscan cache file.
+ *
+ * @param contents The contents to encode.
+ * @return The encoded bytes.
+ */
+static std::string encode_cache(const cache_contents& contents) {
+    std::string encoded{CACHE_MAGIC};
+
+    auto put = [&](auto value) {
+        encoded.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    put(CACHE_FORMAT_VERSION);
+    put(contents.key.timestamp);
+    put(contents.key.size);
+    put(contents.key.header_hash);
+    put(contents.patterns_hash);
+    put(static_cast<uint32_t>(contents.offsets.size()));
+    for (auto offset : contents.offsets) {
+        put(offset);
+    }
+    put(ohl::util::hash_bytes(encoded));
+
+    return encoded;
+}
+
+/**
+ * @brief Decodes the contents of a sigscan cache file.
+ * @note Throws a runtime error if the data is corrupt.
+ *
+ * @param encoded The encoded bytes.
+ * @return The decoded contents.
+ */
+static cache_contents decode_cache(std::string_view encoded) {
+    if (encoded.substr(0, CACHE_MAGIC.size()) != CACHE_MAGIC) {
+        throw std::runtime_error("Not a sigscan cache file");
+    }
+    if (encoded.size() < CACHE_MAGIC.size() + sizeof(uint64_t)) {
+        throw std::runtime_error("Sigscan cache file is truncated");
+    }
+
+    auto body = encoded.substr(0, encoded.size() - sizeof(uint64_t));
+    uint64_t hash;
+    memcpy(&hash, encoded.data() + body.size(), sizeof(hash));
+    if (ohl::util::hash_bytes(body) != hash) {
+        throw std::runtime_error("Sigscan cache file is corrupt");
+    }
+    body.remove_prefix(CACHE_MAGIC.size());
+
+    auto get = [&](auto& value) {
+        if (body.size() < sizeof(value)) {
+            throw std::runtime_error("Sigscan cache file is truncated");
+        }
+        memcpy(&value, body.data(), sizeof(value));
+        body.remove_prefix(sizeof(value));
+    };
+
+    uint32_t version;
+    get(version);
+    if (version != CACHE_FORMAT_VERSION) {
+        throw std::runtime_error("Sigscan cache file is from a different version");
+    }
+
+    cache_contents contents{};
+    get(contents.key.timestamp);
+    get(contents.key.size);
+    get(contents.key.header_hash);
+    get(contents.patterns_hash);
+
+    uint32_t count;
+    get(count);
+    if (body.size() != count * sizeof(uint64_t)) {
+        throw std::runtime_error("Sigscan cache file is truncated");
+    }
+    contents.offsets.resize(count);
+    for (auto& offset : contents.offsets) {
+        get(offset);
+    }
+
+    return contents;
+}
+
+/**
+ * @brief Tries to load the addresses of each pattern from a cache file.
+ *
+ * @param cache_path The path to the cache file.
+ * @param key The key of the image being scanned.
+ * @param image The start of the image.
+ * @param size The size of the image.
+ * @param patterns The patterns being scanned for.
+ * @return The addresses, or std::nullopt if there's no valid cache, or it doesn't match the image.
+ */
+static std::optional<std::vector<const uint8_t*>> load_cache(
+    const std::filesystem::path& cache_path,
+    const image_key& key,
+    const uint8_t* image,
+    size_t size,
+    const std::vector<pattern>& patterns) {
+    ohl::util::mapped_file mapping{cache_path};
+    if (!mapping.is_open()) {
+        LOGD << "[OHL] No sigscan cache found";
+        return std::nullopt;
+    }
+
+    cache_contents contents{};
+    try {
+        contents = decode_cache(mapping.view());
+    } catch (const std::runtime_error& ex) {
+        LOGI << "[OHL] Ignoring invalid sigscan cache: " << ex.what();
+        return std::nullopt;
+    }
+
+    if (contents.key != key) {
+        LOGD << "[OHL] Sigscan cache is from a different build of the game";
+        return std::nullopt;
+    }
+    if (contents.patterns_hash != hash_patterns(patterns)
+        || contents.offsets.size() != patterns.size()) {
+        LOGD << "[OHL] Sigscan cache is from a different set of patterns";
+        return std::nullopt;
+    }
+
+    // Don't trust the key alone, make sure everything's still where we left it
+    std::vector<const uint8_t*> addresses{};
+    for (size_t i = 0; i < patterns.size(); i++) {
+        auto offset = contents.offsets[i];
+        if (offset > size || size - offset < patterns[i].size
+            || !matches(image + offset, patterns[i])) {
+            LOGD << "[OHL] Sigscan cache is out of date: " << patterns[i].name
+                 << " no longer matches";
+            return std::nullopt;
+        }
+        addresses.push_back(image + offset);
+    }
+
+    return addresses;
+}
+
+cached_scan scan_cached(const std::filesystem::path& cache_path,
+                        const uint8_t* image,
+                        size_t size,
+                        const std::vector<pattern>& patterns,
+                        size_t thread_count) {
+    auto key = get_image_key(image, size);
+
+    auto cached = load_cache(cache_path, key, image, size, patterns);
+    if (cached) {
+        return {*cached, true};
+    }
+
+    auto addresses = scan_unique(image, size, patterns, thread_count);
+
+    cache_contents contents{key, hash_patterns(patterns), {}};
+    for (auto address : addresses) {
+        contents.offsets.push_back(static_cast<uint64_t>(address - image));
+    }
+    try {
+        ohl::cache::write(cache_path, encode_cache(contents));
+    } catch (const std::runtime_error& ex) {
+        LOGW << "[OHL] Couldn't write sigscan cache: " << ex.what();
+    }
+
+    return {addresses, false};
+}
+
+#pragma endregion
+
+#pragma region Tests
+
+/**
+ * @brief Scans for a pattern the naive way, as a reference.
+ *
+ * @param start The start of the region.
+ * @param size The size of the region.
+ * @param pattern The pattern to search for.
+ * @return Every address the pattern matched at.
+ */
+static std::vector<const uint8_t*> naive_scan(const uint8_t* start,
+                                              size_t size,
+                                              const pattern& pattern) {
+    std::vector<const uint8_t*> found{};
+    for (size_t i = 0; i + pattern.size <= size; i++) {
+        if (matches(start + i, pattern)) {
+            found.push_back(start + i);
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Fills a buffer with bytes roughly distributed like x64 code.
+ *
+ * @param size The size of the buffer.
+ * @param seed The random seed.
+ * @return The buffer.
+ */
+static std::vector<uint8_t> make_code_like_buffer(size_t size, uint32_t seed) {
+    // A few bytes, mostly rex prefixes, common opcodes and padding, make up a lot of real code
+    static const std::array<uint8_t, 12> COMMON_BYTES = {0x00, 0x48, 0x89, 0x8B, 0xFF, 0xCC,
+                                                         0x24, 0x0F, 0x4C, 0x83, 0xE8, 0xC3};
+
+    std::mt19937 rng{seed};
+    std::vector<uint8_t> buffer(size);
+    for (auto& byte : buffer) {
+        auto rand = rng();
+        byte = (rand & 0x100) ? COMMON_BYTES[(rand >> 16) % COMMON_BYTES.size()]
+                              : static_cast<uint8_t>(rand);
+    }
+    return buffer;
+}
+
+/**
+ * @brief Plants a pattern into a buffer, filling the wildcard bytes with junk.
+ *
+ * @param buffer The buffer to plant into.
+ * @param offset The offset to plant at.
+ * @param pattern The pattern to plant.
+ */
+static void plant(std::vector<uint8_t>& buffer, size_t offset, const pattern& pattern) {
+    for (size_t i = 0; i < pattern.size; i++) {
+        buffer[offset + i] = pattern.mask[i] == 0xFF ? pattern.bytes[i] : 0xA5;
+    }
+}
+
+static const pattern test_malloc_pattern = make_pattern(
+    "malloc",
+    "\x48\x89\x5C\x24\x00\x57\x48\x83\xEC\x20\x48\x8B\xF9\x8B\xDA\x48\x8B\x0D\x00\x00\x00\x00\x48"
+    "\x85\xC9",
+    "\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF"
+    "\xFF\xFF");
+
+static const pattern test_free_pattern = make_pattern(
+    "free",
+    "\x48\x85\xC9\x74\x00\x53\x48\x83\xEC\x20\x48\x8B\xD9\x48\x8B\x0D\x00\x00\x00\x00",
+    "\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00");
+
+static const pattern test_image_cache_pattern = make_pattern(
+    "image_cache",
+    "\x40\x55\x41\x54\x41\x55\x41\x56\x48\x8D\x6C\x24\x00\x48\x81\xEC\xA8\x00\x00\x00",
+    "\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF");
+
+static const pattern test_short_pattern = make_pattern("short", "\xC3\x00\xCC", "\xFF\x00\xFF");
+
+TEST_CASE("sigscan::scan_all") {
+    auto buffer = make_code_like_buffer(4 * CHUNK_SIZE + 123, 1);
+    const auto size = buffer.size();
+
+    // At the very start and end, and straddling chunk boundaries
+    const std::vector<std::pair<const pattern*, size_t>> planted{
+        {&test_malloc_pattern, 0},
+        {&test_free_pattern, CHUNK_SIZE - 5},
+        {&test_image_cache_pattern, 2 * CHUNK_SIZE - 1},
+        {&test_malloc_pattern, 3 * CHUNK_SIZE + 17},
+        {&test_image_cache_pattern, size - test_image_cache_pattern.size},
+    };
+    for (const auto& [pattern, offset] : planted) {
+        plant(buffer, offset, *pattern);
+    }
+
+    const std::vector<pattern> patterns{test_malloc_pattern, test_free_pattern,
+                                        test_image_cache_pattern, test_short_pattern};
+
+    for (size_t threads : {1, 2, 3, 8, 64}) {
+        CAPTURE(threads);
+        auto found = scan_all(buffer.data(), size, patterns, threads);
+        REQUIRE(found.size() == patterns.size());
+
+        CHECK(found[0] == std::vector<const uint8_t*>{buffer.data(),
+                                                      buffer.data() + 3 * CHUNK_SIZE + 17});
+        CHECK(found[1] == std::vector<const uint8_t*>{buffer.data() + CHUNK_SIZE - 5});
+        CHECK(found[2]
+              == std::vector<const uint8_t*>{buffer.data() + 2 * CHUNK_SIZE - 1,
+                                             buffer.data() + size - test_image_cache_pattern.size});
+
+        // Short patterns match all over the place, make sure we found the same ones
+        for (size_t i = 0; i < patterns.size(); i++) {
+            CHECK(found[i] == naive_scan(buffer.data(), size, patterns[i]));
+        }
+    }
+
+    // Patterns which don't fit, or which have no fully masked bytes
+    const auto long_pattern = make_pattern("long", "\x00\x00\x00\x00", "\x00\x00\x00\x00");
+    const auto wildcard_pattern = make_pattern("wildcard", "\x00\x08", "\x00\x08");
+    auto small_found = scan_all(buffer.data(), 3, {long_pattern, wildcard_pattern});
+    CHECK(small_found[0].empty());
+    CHECK(small_found[1] == naive_scan(buffer.data(), 3, wildcard_pattern));
+
+    CHECK(scan_all(buffer.data(), 0, patterns)[0].empty());
+}
+
+TEST_CASE("sigscan::scan_all - random") {
+    // Use a tiny alphabet so that there's lots of partial matches
+    std::mt19937 rng{2};
+    for (auto iteration = 0; iteration < 50; iteration++) {
+        std::vector<uint8_t> buffer(rng() % (3 * CHUNK_SIZE));
+        for (auto& byte : buffer) {
+            byte = rng() % 3;
+        }
+
+        std::array<std::array<char, 6>, 3> bytes{};
+        std::array<std::array<char, 6>, 3> masks{};
+        std::vector<pattern> patterns{};
+        for (size_t i = 0; i < bytes.size(); i++) {
+            auto size = 1 + rng() % 5;
+            for (size_t j = 0; j < size; j++) {
+                masks[i][j] = (rng() % 4 == 0) ? 0 : static_cast<char>(0xFF);
+                bytes[i][j] = static_cast<char>(rng() % 3) & masks[i][j];
+            }
+            patterns.push_back({"random", reinterpret_cast<const uint8_t*>(bytes[i].data()),
+                                reinterpret_cast<const uint8_t*>(masks[i].data()), size});
+        }
+
+        auto found = scan_all(buffer.data(), buffer.size(), patterns, 1 + iteration % 4);
+        for (size_t i = 0; i < patterns.size(); i++) {
+            CHECK(found[i] == naive_scan(buffer.data(), buffer.size(), patterns[i]));
+        }
+    }
+}
+
+TEST_CASE("sigscan::scan_unique") {
+    auto buffer = make_code_like_buffer(2 * CHUNK_SIZE, 3);
+    plant(buffer, 100, test_malloc_pattern);
+    plant(buffer, CHUNK_SIZE + 100, test_free_pattern);
+
+    auto found =
+        scan_unique(buffer.data(), buffer.size(), {test_malloc_pattern, test_free_pattern});
+    CHECK(found == std::vector<const uint8_t*>{buffer.data() + 100,
+                                               buffer.data() + CHUNK_SIZE + 100});
+
+    auto error_message = [&](const std::vector<pattern>& patterns) -> std::string {
+        try {
+            scan_unique(buffer.data(), buffer.size(), patterns, 2);
+        } catch (const std::runtime_error& ex) {
+            return ex.what();
+        }
+        return "";
+    };
+
+    CHECK(error_message({test_malloc_pattern, test_image_cache_pattern})
+          == "Sigscan failed: image_cache not found");
+
+    CHECK(error_message({test_image_cache_pattern, test_malloc_pattern, test_image_cache_pattern})
+          == "Sigscan failed: image_cache not found; image_cache not found");
+
+    // Matching the same address as another pattern only warns
+    CHECK(error_message({test_free_pattern, test_free_pattern}).empty());
+
+    // Matching multiple times only warns, and uses the first match
+    plant(buffer, CHUNK_SIZE + 500, test_malloc_pattern);
+    plant(buffer, 50, test_malloc_pattern);
+    CHECK(scan_unique(buffer.data(), buffer.size(), {test_malloc_pattern, test_free_pattern}, 2)
+          == std::vector<const uint8_t*>{buffer.data() + 50, buffer.data() + CHUNK_SIZE + 100});
+}
+
+/**
+ * @brief Creates a fake 64-bit PE image, with just enough headers to get it's key.
+ *
+ * @param size The size of the image.
+ * @param timestamp The link timestamp to use.
+ * @param image_base The image base to use.
+ * @return The image.
+ */
+static std::vector<uint8_t> make_fake_image(size_t size, uint32_t timestamp, uint64_t image_base) {
+    static const uint32_t PE_OFFSET = 0x80;
+    static const uint32_t HEADERS_SIZE = 0x400;
+
+    auto image = make_code_like_buffer(size, timestamp);
+    std::fill_n(image.begin(), HEADERS_SIZE, 0);
+
+    auto put = [&](size_t offset, auto value) { memcpy(&image[offset], &value, sizeof(value)); };
+    const auto optional = PE_OFFSET + PE_OPTIONAL_HEADER_OFFSET;
+
+    put(0, DOS_SIGNATURE);
+    put(DOS_LFANEW_OFFSET, PE_OFFSET);
+    put(PE_OFFSET, PE_SIGNATURE);
+    put(PE_OFFSET + PE_TIMESTAMP_OFFSET, timestamp);
+    put(optional, OPTIONAL_MAGIC_64);
+    put(optional + OPTIONAL_IMAGE_BASE_OFFSET_64, image_base);
+    put(optional + OPTIONAL_SIZE_OF_IMAGE_OFFSET, static_cast<uint32_t>(size));
+    put(optional + OPTIONAL_SIZE_OF_HEADERS_OFFSET, HEADERS_SIZE);
+
+    return image;
+}
+
+TEST_CASE("sigscan::get_image_key") {
+    const auto image = make_fake_image(0x10000, 0x5F000000, 0x140000000);
+    const auto key = get_image_key(image.data(), image.size());
+    CHECK(key.timestamp == 0x5F000000);
+    CHECK(key.size == 0x10000);
+
+    // Relocating the image shouldn't change the key
+    auto relocated = make_fake_image(0x10000, 0x5F000000, 0x7FF600000000);
+    CHECK(get_image_key(relocated.data(), relocated.size()) == key);
+
+    auto rebuilt = make_fake_image(0x10000, 0x5F000001, 0x140000000);
+    CHECK(get_image_key(rebuilt.data(), rebuilt.size()) != key);
+
+    auto modified = image;
+    modified[0x300] ^= 1;
+    CHECK(get_image_key(modified.data(), modified.size()) != key);
+
+    // Only the headers get hashed
+    modified = image;
+    modified[0x8000] ^= 1;
+    CHECK(get_image_key(modified.data(), modified.size()) == key);
+
+    CHECK_THROWS_AS(get_image_key(image.data(), 0x100), std::runtime_error);
+    CHECK_THROWS_AS(get_image_key(image.data() + 1, image.size() - 1), std::runtime_error);
+
+    auto bad_lfanew = image;
+    bad_lfanew[DOS_LFANEW_OFFSET + 3] = 0x7F;
+    CHECK_THROWS_AS(get_image_key(bad_lfanew.data(), bad_lfanew.size()), std::runtime_error);
+}
+
+TEST_CASE("sigscan::scan_cached") {
+    const auto cache_path = std::filesystem::temp_directory_path() / "ohl_sigscan_cache_test.bin";
+    std::filesystem::remove(cache_path);
+
+    const std::vector<pattern> patterns{test_malloc_pattern, test_free_pattern,
+                                        test_image_cache_pattern};
+
+    auto image = make_fake_image(4 * CHUNK_SIZE, 0x5F000000, 0x140000000);
+    plant(image, 0x1000, test_malloc_pattern);
+    plant(image, CHUNK_SIZE + 0x1000, test_free_pattern);
+    plant(image, 3 * CHUNK_SIZE + 0x1000, test_image_cache_pattern);
+    const std::vector<const uint8_t*> expected{image.data() + 0x1000,
+                                               image.data() + CHUNK_SIZE + 0x1000,
+                                               image.data() + 3 * CHUNK_SIZE + 0x1000};
+
+    auto first = scan_cached(cache_path, image.data(), image.size(), patterns);
+    CHECK(!first.cache_hit);
+    CHECK(first.addresses == expected);
+    CHECK(std::filesystem::exists(cache_path));
+
+    // Loaded at a different address, but the offsets are the same
+    auto copy = image;
+    auto second = scan_cached(cache_path, copy.data(), copy.size(), patterns);
+    CHECK(second.cache_hit);
+    CHECK(second.addresses == std::vector<const uint8_t*>{copy.data() + 0x1000,
+                                                          copy.data() + CHUNK_SIZE + 0x1000,
+                                                          copy.data() + 3 * CHUNK_SIZE + 0x1000});
+
+    SUBCASE("different build") {
+        auto rebuilt = make_fake_image(4 * CHUNK_SIZE, 0x5F000001, 0x140000000);
+        plant(rebuilt, 0x2000, test_malloc_pattern);
+        plant(rebuilt, 0x3000, test_free_pattern);
+        plant(rebuilt, 0x4000, test_image_cache_pattern);
+
+        auto result = scan_cached(cache_path, rebuilt.data(), rebuilt.size(), patterns);
+        CHECK(!result.cache_hit);
+        CHECK(result.addresses == std::vector<const uint8_t*>{
+                                      rebuilt.data() + 0x2000, rebuilt.data() + 0x3000,
+                                      rebuilt.data() + 0x4000});
+
+        // Which should replace the old cache
+        CHECK(scan_cached(cache_path, rebuilt.data(), rebuilt.size(), patterns).cache_hit);
+        CHECK(!scan_cached(cache_path, image.data(), image.size(), patterns).cache_hit);
+    }
+
+    SUBCASE("same key, moved function") {
+        // Shouldn't be possible, but if the key collides the in place check should still catch it
+        auto moved = image;
+        std::fill_n(moved.begin() + CHUNK_SIZE + 0x1000, test_free_pattern.size, 0);
+        plant(moved, 2 * CHUNK_SIZE, test_free_pattern);
+
+        auto result = scan_cached(cache_path, moved.data(), moved.size(), patterns);
+        CHECK(!result.cache_hit);
+        CHECK(result.addresses[1] == moved.data() + 2 * CHUNK_SIZE);
+    }
+
+    SUBCASE("different patterns") {
+        const std::vector<pattern> fewer_patterns{test_malloc_pattern, test_free_pattern};
+        auto result = scan_cached(cache_path, image.data(), image.size(), fewer_patterns);
+        CHECK(!result.cache_hit);
+        CHECK(result.addresses.size() == 2);
+    }
+
+    SUBCASE("corrupt cache") {
+        std::string contents{};
+        {
+            std::ifstream in{cache_path, std::ios::binary};
+            contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        REQUIRE(!contents.empty());
+        CHECK_NOTHROW(decode_cache(contents));
+
+        for (auto size : {(size_t)0, (size_t)4, CACHE_MAGIC.size() + 4, contents.size() - 1}) {
+            CHECK_THROWS_AS(decode_cache(std::string_view(contents).substr(0, size)),
+                            std::runtime_error);
+        }
+
+        contents[contents.size() / 2] ^= 0x20;
+        CHECK_THROWS_AS(decode_cache(contents), std::runtime_error);
+        ohl::cache::write(cache_path, contents);
+
+        auto result = scan_cached(cache_path, image.data(), image.size(), patterns);
+        CHECK(!result.cache_hit);
+        CHECK(result.addresses == expected);
+    }
+
+    SUBCASE("failed scan") {
+        std::filesystem::remove(cache_path);
+        auto missing = image;
+        std::fill_n(missing.begin() + 0x1000, test_malloc_pattern.size, 0);
+
+        CHECK_THROWS_AS(scan_cached(cache_path, missing.data(), missing.size(), patterns),
+                        std::runtime_error);
+        CHECK(!std::filesystem::exists(cache_path));
+    }
+
+    std::filesystem::remove(cache_path);
+}
+
+TEST_CASE("sigscan::scan_all - benchmark" * doctest::skip()) {
+    static const size_t SIZE = 200 * 1024 * 1024;
+
+    auto buffer = make_code_like_buffer(SIZE, 4);
+    const std::vector<pattern> patterns{test_malloc_pattern, test_free_pattern,
+                                        test_image_cache_pattern};
+    for (size_t i = 0; i < patterns.size(); i++) {
+        plant(buffer, (i + 1) * SIZE / (patterns.size() + 1), patterns[i]);
+    }
+
+    using clock = std::chrono::steady_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    auto naive_start = clock::now();
+    for (const auto& pattern : patterns) {
+        CHECK(naive_scan(buffer.data(), SIZE, pattern).size() == 1);
+    }
+    auto naive_time = duration_cast<milliseconds>(clock::now() - naive_start);
+    MESSAGE("Naive, one pass per pattern: " << naive_time.count() << "ms");
+
+    auto max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        auto start = clock::now();
+        auto found = scan_unique(buffer.data(), SIZE, patterns, threads);
+        auto time = duration_cast<milliseconds>(clock::now() - start);
+
+        CHECK(found.size() == patterns.size());
+        MESSAGE("Single pass, " << threads << " threads: " << time.count() << "ms");
+    }
+}
+
+#pragma endregion
+
+TEST_SUITE_END();
+}  // namespace ohl::sigscan
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <pch.h>
+
+namespace ohl::sigscan {
+
+/**
+ * @brief Struct holding information about a sigscan.
+ */
+struct pattern {
+    const char* name;
+    const uint8_t* bytes;
+    const uint8_t* mask;
+    const size_t size;
+};
+
+/**
+ * @brief Helper to convert strings into a sigscan pattern.
+ *
+ * @tparam n The length of the strings (should be picked up automatically).
+ * @param name The name of the pattern, used in errors.
+ * @return A sigscan pattern.
+ */
+template <size_t n>
+constexpr pattern make_pattern(const char* name, const char (&bytes)[n], const char (&mask)[n]) {
+    return pattern{name, reinterpret_cast<const uint8_t*>(bytes),
+                   reinterpret_cast<const uint8_t*>(mask), n - 1};
+}
+
+/**
+ * @brief Scans a block of memory for several patterns at once.
+ * @note Reads through the memory once, checking every pattern against each chunk while it's still
+ *       in cache.
+ * @note Only fully checks the places where a pattern's two rarest fully masked bytes match, which
+ *       are found using SIMD where available.
+ *
+ * @param start The address to start the search at.
+ * @param size The length of the region to search.
+ * @param patterns The patterns to search for.
+ * @param thread_count How many threads to split the region across.
+ * @return For each pattern, every address it matched at, in ascending order.
+ */
+std::vector<std::vector<const uint8_t*>> scan_all(const uint8_t* start,
+                                                  size_t size,
+                                                  const std::vector<pattern>& patterns,
+                                                  size_t thread_count = 1);
+
+/**
+ * @brief Scans a block of memory for several patterns at once, requiring each to match.
+ * @note Throws a runtime error naming every pattern which didn't match.
+ * @note Patterns which match more than once use their first match. This, and patterns matching the
+ *       same address as another, only log a warning.
+ *
+ * @param start The address to start the search at.
+ * @param size The length of the region to search.
+ * @param patterns The patterns to search for.
+ * @param thread_count How many threads to split the region across.
+ * @return The address each pattern matched at.
+ */
+std::vector<const uint8_t*> scan_unique(const uint8_t* start,
+                                        size_t size,
+                                        const std::vector<pattern>& patterns,
+                                        size_t thread_count = 1);
+
+/**
+ * @brief Struct identifying a specific build of an executable.
+ */
+struct image_key {
+    // The link timestamp from the PE file header
+    uint32_t timestamp;
+    // The size of the image once loaded
+    uint32_t size;
+    // A hash of the PE headers, excluding the fields the loader rewrites
+    uint64_t header_hash;
+
+    bool operator==(const image_key& rhs) const {
+        return this->timestamp == rhs.timestamp && this->size == rhs.size
+               && this->header_hash == rhs.header_hash;
+    }
+    bool operator!=(const image_key& rhs) const { return !operator==(rhs); }
+};
+
+/**
+ * @brief Reads the key identifying a PE image which has been loaded into memory.
+ * @note Throws a runtime error if the headers are invalid.
+ *
+ * @param image The start of the image.
+ * @param size The amount of the image which is safe to read.
+ * @return The image's key.
+ */
+image_key get_image_key(const uint8_t* image, size_t size);
+
+/**
+ * @brief Struct holding the result of a cached scan.
+ */
+struct cached_scan {
+    // The address each pattern matched at
+    std::vector<const uint8_t*> addresses;
+    // True if the addresses came from the cache, false if a full scan was needed
+    bool cache_hit;
+};
+
+/**
+ * @brief Scans an image for several patterns, requiring each to match, reusing the offsets found
+ *        last time if the image is the same build.
+ * @note Cached offsets are only trusted if every pattern still matches at them, otherwise falls
+ *       back to a full scan, and rewrites the cache.
+ * @note Throws a runtime error if the full scan fails, see `scan_unique`. Failing to write the
+ *       cache only logs a warning.
+ *
+ * @param cache_path The path to the cache file.
+ * @param image The start of the image.
+ * @param size The size of the image.
+ * @param patterns The patterns to search for.
+ * @param thread_count How many threads to split a full scan across.
+ * @return The address each pattern matched at, and if they came from the cache.
+ */
+cached_scan scan_cached(const std::filesystem::path& cache_path,
+                        const uint8_t* image,
+                        size_t size,
+                        const std::vector<pattern>& patterns,
+                        size_t thread_count = 1);
+
+}  // namespace ohl::sigscan
@@ -0,0 +1,312 @@
+#include <pch.h>
+
+#include <doctest/doctest.h>
+
+#include "tasks.h"
+
+namespace ohl::tasks {
+TEST_SUITE_BEGIN("tasks");
+
+// The scheduler and worker index the current thread is running, if it's a worker
+static thread_local const scheduler* current_scheduler = nullptr;
+static thread_local size_t current_index = 0;
+
+// How long a waiting thread sleeps for before checking for new tasks to help with
+static const std::chrono::milliseconds HELP_CHECK_INTERVAL{1};
+
+scheduler::scheduler(size_t worker_count) : queued(0), stopping(false) {
+    worker_count = std::max<size_t>(worker_count, 1);
+
+    // Create all the workers before starting any, since they look at each other's queues
+    for (size_t i = 0; i < worker_count; i++) {
+        this->workers.push_back(std::make_unique<worker>());
+    }
+    for (size_t i = 0; i < worker_count; i++) {
+        this->workers[i]->thread = std::thread(&scheduler::run, this, i);
+    }
+}
+
+scheduler::~scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->cv.notify_all();
+
+    for (auto& worker : this->workers) {
+        worker->thread.join();
+    }
+}
+
+std::optional<size_t> scheduler::current_worker(void) const {
+    if (current_scheduler != this) {
+        return std::nullopt;
+    }
+    return current_index;
+}
+
+std::future<void> scheduler::submit(std::function<void(void)> task) {
+    scheduler::task packaged{std::move(task)};
+    auto future = packaged.get_future();
+
+    auto index = this->current_worker();
+    if (index) {
+        auto& worker = *this->workers[*index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queue.push_back(std::move(packaged));
+        this->queued++;
+    } else {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->injected.push_back(std::move(packaged));
+        this->queued++;
+    }
+
+    // Take the lock so we can't slip in between a worker checking for tasks and going to sleep
+    { std::lock_guard<std::mutex> lock(this->mutex); }
+    this->cv.notify_one();
+
+    return future;
+}
+
+std::optional<scheduler::task> scheduler::take(std::optional<size_t> index, bool& stolen) {
+    std::optional<task> taken = std::nullopt;
+    stolen = false;
+
+    if (index) {
+        auto& worker = *this->workers[*index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.queue.empty()) {
+            taken = std::move(worker.queue.back());
+            worker.queue.pop_back();
+        }
+    }
+
+    if (!taken) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (!this->injected.empty()) {
+            taken = std::move(this->injected.front());
+            this->injected.pop_front();
+        }
+    }
+
+    if (!taken) {
+        // Start from different places, so that thieves don't all pile onto the same worker
+        auto start = index ? *index + 1 : 0;
+        for (size_t i = 0; i < this->workers.size() && !taken; i++) {
+            auto victim_index = (start + i) % this->workers.size();
+            if (index && victim_index == *index) {
+                continue;
+            }
+
+            auto& victim = *this->workers[victim_index];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.queue.empty()) {
+                taken = std::move(victim.queue.front());
+                victim.queue.pop_front();
+                stolen = true;
+            }
+        }
+    }
+
+    if (taken) {
+        this->queued--;
+    }
+    return taken;
+}
+
+bool scheduler::try_run_one(std::optional<size_t> index) {
+    bool stolen = false;
+    auto task = this->take(index, stolen);
+    if (!task) {
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    (*task)();
+
+    if (index) {
+        auto& worker = *this->workers[*index];
+        worker.busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+        worker.tasks_run++;
+        if (stolen) {
+            worker.tasks_stolen++;
+        }
+    }
+
+    return true;
+}
+
+void scheduler::run(size_t index) {
+    SetThreadDescription(GetCurrentThread(), L"OpenHotfixLoader Worker");
+
+    current_scheduler = this;
+    current_index = index;
+
+    while (true) {
+        if (this->try_run_one(index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if (this->queued > 0) {
+            continue;
+        }
+        if (this->stopping) {
+            return;
+        }
+        this->cv.wait(lock);
+    }
+}
+
+void scheduler::wait(const std::future<void>& future) {
+    auto index = this->current_worker();
+    while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        if (!this->try_run_one(index)) {
+            future.wait_for(HELP_CHECK_INTERVAL);
+        }
+    }
+}
+
+std::vector<scheduler::worker_stats> scheduler::get_stats(void) const {
+    std::vector<worker_stats> stats{};
+    for (const auto& worker : this->workers) {
+        stats.push_back({std::chrono::nanoseconds(worker->busy_ns.load()),
+                         worker->tasks_run.load(), worker->tasks_stolen.load()});
+    }
+    return stats;
+}
+
+void scheduler::reset_stats(void) {
+    for (auto& worker : this->workers) {
+        worker->busy_ns = 0;
+        worker->tasks_run = 0;
+        worker->tasks_stolen = 0;
+    }
+}
+
+TEST_CASE("tasks::scheduler") {
+    static const size_t WORKER_COUNT = 3;
+    static const size_t TASK_COUNT = 30;
+
+    std::mutex mutex;
+    size_t active = 0;
+    size_t max_active = 0;
+    std::atomic<size_t> finished{0};
+
+    std::vector<std::future<void>> futures{};
+    std::future<void> nested_future{};
+    {
+        scheduler scheduler{WORKER_COUNT};
+        for (size_t i = 0; i < TASK_COUNT; i++) {
+            futures.push_back(scheduler.submit([&]() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    max_active = std::max(max_active, ++active);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    active--;
+                }
+                finished++;
+            }));
+        }
+
+        // Tasks may submit more tasks, even while the scheduler's being destroyed
+        futures.push_back(scheduler.submit([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            nested_future = scheduler.submit([&]() { finished++; });
+        }));
+
+        futures.push_back(scheduler.submit([]() { throw std::runtime_error("task failed"); }));
+    }
+
+    // Destroying the scheduler should've finished everything
+    CHECK(finished == TASK_COUNT + 1);
+    CHECK(max_active <= WORKER_COUNT);
+    CHECK(max_active > 1);
+
+    for (size_t i = 0; i < futures.size() - 1; i++) {
+        CHECK_NOTHROW(futures[i].get());
+    }
+    CHECK_THROWS_AS(futures.back().get(), std::runtime_error);
+    REQUIRE(nested_future.valid());
+    CHECK_NOTHROW(nested_future.get());
+}
+
+TEST_CASE("tasks::scheduler - work stealing") {
+    static const size_t WORKER_COUNT = 4;
+    static const size_t CHILD_COUNT = 40;
+    static const auto CHILD_TIME = std::chrono::milliseconds(2);
+
+    scheduler scheduler{WORKER_COUNT};
+
+    // Every child gets queued on the parent's worker, the rest should steal them
+    std::mutex mutex;
+    std::unordered_set<std::thread::id> child_threads{};
+    std::vector<std::future<void>> children{};
+    auto parent = scheduler.submit([&]() {
+        for (size_t i = 0; i < CHILD_COUNT; i++) {
+            children.push_back(scheduler.submit([&]() {
+                std::this_thread::sleep_for(CHILD_TIME);
+                std::lock_guard<std::mutex> lock(mutex);
+                child_threads.insert(std::this_thread::get_id());
+            }));
+        }
+    });
+    // Don't help out, so that only the workers run anything
+    parent.get();
+    for (auto& child : children) {
+        child.get();
+    }
+
+    CHECK(child_threads.size() > 1);
+
+    auto stats = scheduler.get_stats();
+    REQUIRE(stats.size() == WORKER_COUNT);
+    size_t tasks_stolen = 0;
+    for (const auto& worker : stats) {
+        // Stats are only updated after a task's future is completed, so might lag behind slightly
+        CHECK(worker.tasks_run <= CHILD_COUNT + 1);
+        CHECK(worker.tasks_stolen <= worker.tasks_run);
+        tasks_stolen += worker.tasks_stolen;
+    }
+    CHECK(tasks_stolen > 0);
+
+    scheduler.reset_stats();
+    for (const auto& worker : scheduler.get_stats()) {
+        CHECK(worker.busy.count() == 0);
+        CHECK(worker.tasks_run == 0);
+        CHECK(worker.tasks_stolen == 0);
+    }
+}
+
+TEST_CASE("tasks::scheduler::wait - helps while waiting") {
+    scheduler scheduler{1};
+
+    // Tie up the only worker
+    std::promise<void> started{};
+    std::promise<void> release{};
+    auto blocker = scheduler.submit([&]() {
+        started.set_value();
+        release.get_future().wait();
+    });
+    started.get_future().wait();
+
+    std::atomic<bool> ran{false};
+    auto queued = scheduler.submit([&]() { ran = true; });
+
+    // Can only finish if we run it ourselves
+    scheduler.wait(queued);
+    CHECK(ran);
+    CHECK_NOTHROW(queued.get());
+
+    release.set_value();
+    scheduler.wait(blocker);
+    CHECK_NOTHROW(blocker.get());
+}
+
+TEST_SUITE_END();
+}  // namespace ohl::tasks
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <pch.h>
+
+namespace ohl::tasks {
+
+/**
+ * @brief Runs tasks on a fixed set of worker threads, which steal work from each other when idle.
+ * @note Tasks submitted from a worker go on that worker's own queue, and it runs the newest first,
+ *       so a task's children run while their data is still hot. Idle workers steal the oldest
+ *       tasks, which tend to be the ones that spawn the most further work.
+ * @note Threads waiting on a task run other queued tasks in the meantime, so waiting never leaves a
+ *       thread idle while there's work to do.
+ */
+class scheduler {
+   public:
+    struct worker_stats {
+        // How long the worker spent running tasks
+        std::chrono::nanoseconds busy;
+        size_t tasks_run;
+        // How many of those tasks it took from another worker's queue
+        size_t tasks_stolen;
+    };
+
+   private:
+    using task = std::packaged_task<void(void)>;
+
+    struct worker {
+        std::mutex mutex;
+        std::deque<task> queue;
+
+        std::atomic<std::chrono::nanoseconds::rep> busy_ns{0};
+        std::atomic<size_t> tasks_run{0};
+        std::atomic<size_t> tasks_stolen{0};
+
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<worker>> workers;
+
+    // Tasks submitted from outside the workers
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<task> injected;
+    // Total tasks queued across all queues, which haven't been started yet
+    std::atomic<size_t> queued;
+    bool stopping;
+
+    /**
+     * @brief Gets the index of the worker running on the current thread.
+     *
+     * @return The worker index, or std::nullopt if the current thread isn't one of our workers.
+     */
+    std::optional<size_t> current_worker(void) const;
+
+    /**
+     * @brief Takes the next task the given worker should run, stealing one if needed.
+     *
+     * @param index The index of the worker to take a task for, or std::nullopt if not a worker.
+     * @param stolen Set to true if the task was stolen from another worker.
+     * @return The task, or std::nullopt if there's nothing queued.
+     */
+    std::optional<task> take(std::optional<size_t> index, bool& stolen);
+
+    /**
+     * @brief Runs a single queued task on the current thread, if there are any.
+     *
+     * @param index The index of the current worker, or std::nullopt if not a worker.
+     * @return True if a task was run.
+     */
+    bool try_run_one(std::optional<size_t> index);
+
+    /**
+     * @brief Main loop of the worker threads.
+     *
+     * @param index The index of this worker.
+     */
+    void run(size_t index);
+
+   public:
+    scheduler(size_t worker_count);
+
+    /**
+     * @brief Finishes all queued tasks, then stops the workers.
+     */
+    ~scheduler();
+
+    scheduler(const scheduler&) = delete;
+    scheduler& operator=(const scheduler&) = delete;
+
+    /**
+     * @brief Queues a task.
+     *
+     * @param task The task to run.
+     * @return A future which completes when the task does, holding any exception it threw.
+     */
+    std::future<void> submit(std::function<void(void)> task);
+
+    /**
+     * @brief Waits for a task to complete, running other queued tasks while waiting.
+     * @note Doesn't retrieve the result, call `get` on the future afterwards.
+     *
+     * @param future The future to wait on.
+     */
+    void wait(const std::future<void>& future);
+
+    /**
+     * @brief Gets the stats of each worker, since they were last reset.
+     *
+     * @return The stats, one entry per worker.
+     */
+    std::vector<worker_stats> get_stats(void) const;
+
+    /**
+     * @brief Resets the stats of each worker.
+     */
+    void reset_stats(void);
+};
+
+}  // namespace ohl::tasks
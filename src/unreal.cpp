@@ -1,8 +1,11 @@
 #include <pch.h>
 
+#include <doctest/doctest.h>
+
 #include "unreal.h"
 
 namespace ohl::unreal {
+TEST_SUITE_BEGIN("unreal");
 
 #pragma region Casting
 
@@ -47,6 +50,14 @@ std::wstring FString::to_wstr(void) const {
     return std::wstring(this->data);
 }
 
+std::wstring_view FString::to_wstr_view(void) const {
+    if (this->data == nullptr || this->count == 0) {
+        return {};
+    }
+    // Count includes the null terminator
+    return std::wstring_view(this->data, this->count - 1);
+}
+
 std::wstring FJsonValueString::to_wstr(void) const {
     return this->str.to_wstr();
 }
@@ -55,6 +66,10 @@ std::wstring FSparkRequest::get_url(void) const {
     return this->url.to_wstr();
 }
 
+std::wstring_view FSparkRequest::get_url_view(void) const {
+    return this->url.to_wstr_view();
+}
+
 uint32_t FJsonValueArray::count() const {
     return this->entries.count;
 }
@@ -67,15 +82,76 @@ T* FJsonValueArray::get(uint32_t idx) const {
     return this->entries.data[idx].obj->cast<T>();
 }
 
-template <typename T>
-T* FJsonObject::get(std::wstring key) const {
-    for (auto i = 0; i < this->entries.count; i++) {
-        auto entry = this->entries.data[i];
-        if (entry.key.to_wstr() == key) {
-            return entry.value.obj->cast<T>();
+// Unreal sizes the hash to about half the entry count, with a minimum of 8 buckets once there are 4
+//  or more entries - so it never has more than 4 buckets per entry
+static const int64_t MAX_HASH_BUCKETS_PER_ENTRY = 4;
+
+const JSONObjectEntry* FJsonObject::find_hashed(const json_key& key) const {
+    if (!key.hash) {
+        return nullptr;
+    }
+
+    // The bucket pointer gets dereferenced, so only trust it if the rest of the hash looks sane
+    int32_t hash_size;
+    memcpy(&hash_size, &this->pattern[PATTERN_HASH_SIZE], sizeof(hash_size));
+    if (hash_size <= 0 || (hash_size & (hash_size - 1)) != 0) {
+        return nullptr;
+    }
+    if (hash_size > 1
+        && hash_size > MAX_HASH_BUCKETS_PER_ENTRY * static_cast<int64_t>(this->entries.count)) {
+        return nullptr;
+    }
+
+    // Only a single bucket is stored inline, any more must be on the heap
+    const int32_t* buckets;
+    memcpy(&buckets, &this->pattern[PATTERN_HASH_SECONDARY], sizeof(buckets));
+    if ((buckets == nullptr) != (hash_size == 1)) {
+        return nullptr;
+    }
+    if (buckets == nullptr) {
+        buckets = reinterpret_cast<const int32_t*>(&this->pattern[PATTERN_HASH_INLINE]);
+    }
+
+    // Make sure a corrupt chain can't send us out of bounds, or loop forever
+    auto idx = buckets[*key.hash & (hash_size - 1)];
+    for (uint32_t steps = 0; 0 <= idx && idx < (int64_t)this->entries.count; steps++) {
+        if (steps >= this->entries.count) {
+            return nullptr;
+        }
+
+        const auto& entry = this->entries.data[idx];
+        if (entry.key.to_wstr_view() == key.str) {
+            return &entry;
         }
+        idx = entry.hash_next_id;
     }
-    throw std::runtime_error("Couldn't find key!");
+
+    return nullptr;
+}
+
+const JSONObjectEntry* FJsonObject::find(const json_key& key) const {
+    // Since we can't be sure our hash matches unreal's, fall back to a linear search on a miss too
+    auto entry = this->find_hashed(key);
+    if (entry != nullptr) {
+        return entry;
+    }
+
+    for (uint32_t i = 0; i < this->entries.count; i++) {
+        const auto& linear_entry = this->entries.data[i];
+        if (linear_entry.key.to_wstr_view() == key.str) {
+            return &linear_entry;
+        }
+    }
+    return nullptr;
+}
+
+template <typename T>
+T* FJsonObject::get(const json_key& key) const {
+    auto entry = this->find(key);
+    if (entry == nullptr) {
+        throw std::runtime_error("Couldn't find key!");
+    }
+    return entry->value.obj->cast<T>();
 }
 
 FJsonObject* FJsonValueObject::to_obj(void) const {
@@ -94,10 +170,205 @@ template FJsonValueString* FJsonValueArray::get(uint32_t) const;
 template FJsonValueArray* FJsonValueArray::get(uint32_t) const;
 template FJsonValueObject* FJsonValueArray::get(uint32_t) const;
 
-template FJsonValueString* FJsonObject::get(std::wstring key) const;
-template FJsonValueArray* FJsonObject::get(std::wstring key) const;
-template FJsonValueObject* FJsonObject::get(std::wstring key) const;
+template FJsonValueString* FJsonObject::get(const json_key& key) const;
+template FJsonValueArray* FJsonObject::get(const json_key& key) const;
+template FJsonValueObject* FJsonObject::get(const json_key& key) const;
+
+#pragma endregion
+
+#pragma region Tests
+
+/**
+ * @brief Builds a synthetic json object of strings, laid out the same way as unreal's.
+ */
+class test_object {
+   private:
+    std::vector<std::wstring> keys;
+    std::vector<std::wstring> value_strs;
+    std::vector<FJsonValueString> values;
+    std::vector<JSONObjectEntry> entries;
+
+   public:
+    std::vector<int32_t> buckets;
+    FJsonObject obj;
+
+    /**
+     * @brief Creates a new test object.
+     * @note Hashes each key into it's bucket, the same as unreal would.
+     *
+     * @param pairs The key-value pairs to add.
+     * @param hash_size The amount of hash buckets to use, or 0 to not set up a hash.
+     */
+    test_object(const std::vector<std::pair<std::wstring, std::wstring>>& pairs, int32_t hash_size)
+        : keys(pairs.size()),
+          value_strs(pairs.size()),
+          values(pairs.size()),
+          entries(pairs.size()),
+          obj() {
+        for (size_t i = 0; i < pairs.size(); i++) {
+            this->keys[i] = pairs[i].first + L'\0';
+            this->entries[i].key.data = this->keys[i].data();
+            this->entries[i].key.count = this->keys[i].size();
+            this->entries[i].key.max = this->keys[i].size();
+
+            this->values[i].type = EJson::String;
+            this->value_strs[i] = pairs[i].second + L'\0';
+            this->values[i].str.data = this->value_strs[i].data();
+            this->values[i].str.count = this->value_strs[i].size();
+            this->entries[i].value.obj = &this->values[i];
+        }
+        this->obj.entries.data = this->entries.data();
+        this->obj.entries.count = this->entries.size();
+        this->obj.entries.max = this->entries.size();
+
+        if (hash_size == 0) {
+            return;
+        }
+
+        this->buckets.resize(hash_size, -1);
+        for (size_t i = 0; i < pairs.size(); i++) {
+            auto bucket = *json_key{pairs[i].first}.hash & (hash_size - 1);
+            this->entries[i].hash_idx = bucket;
+            this->entries[i].hash_next_id = this->buckets[bucket];
+            this->buckets[bucket] = i;
+        }
+        this->set_hash(this->buckets.data(), hash_size);
+    }
+
+    /**
+     * @brief Overwrites the hash stored in the object's pattern.
+     *
+     * @param buckets The hash buckets.
+     * @param hash_size The amount of hash buckets.
+     */
+    void set_hash(const int32_t* buckets, int32_t hash_size) {
+        memcpy(&this->obj.pattern[FJsonObject::PATTERN_HASH_SECONDARY], &buckets, sizeof(buckets));
+        memcpy(&this->obj.pattern[FJsonObject::PATTERN_HASH_SIZE], &hash_size, sizeof(hash_size));
+    }
+
+    /**
+     * @brief Looks up a key, returning it's value.
+     *
+     * @param key The key to look up.
+     * @return The value.
+     */
+    std::wstring_view get(const json_key& key) const {
+        return this->obj.get<FJsonValueString>(key)->str.to_wstr_view();
+    }
+};
+
+TEST_CASE("unreal::json_key") {
+    static constexpr json_key compile_time{L"services"};
+    static_assert(compile_time.hash.has_value());
+    CHECK(compile_time.hash == json_key{std::wstring(L"services")}.hash);
+
+    // Unreal's key hash is case insensitive
+    CHECK(json_key{L"services"}.hash == json_key{L"SERVICES"}.hash);
+    CHECK(json_key{L"services"}.hash != json_key{L"parameters"}.hash);
+    CHECK(json_key{L""}.hash == 0u);
+
+    // Can't be sure how unreal upper cases non-ascii, so shouldn't try
+    CHECK(!json_key{L"υπόθεση"}.hash.has_value());
+}
+
+TEST_CASE("unreal::FJsonObject::get") {
+    const std::vector<std::pair<std::wstring, std::wstring>> pairs{
+        {L"service_name", L"Micropatch"},
+        {L"configuration_group", L"group"},
+        {L"parameters", L"params"},
+        {L"υπόθεση", L"unicode"},
+        {L"key", L"k"},
+        {L"value", L"v"},
+    };
+
+    auto check_all = [&](const test_object& object) {
+        for (const auto& [key, value] : pairs) {
+            CHECK(object.get(key) == value);
+        }
+        CHECK(object.obj.find(L"missing") == nullptr);
+        CHECK(object.obj.find(L"Key") == nullptr);
+        CHECK_THROWS_AS(object.get(L"missing"), std::runtime_error);
+    };
+
+    SUBCASE("no hash") {
+        check_all(test_object{pairs, 0});
+    }
+
+    SUBCASE("hashed") {
+        for (auto hash_size : {2, 8, 16}) {
+            CAPTURE(hash_size);
+            check_all(test_object{pairs, hash_size});
+        }
+    }
+
+    SUBCASE("inline hash") {
+        // Like the objects we create, one bucket stored inline, with each entry chained to the last
+        test_object object{pairs, 1};
+        object.set_hash(nullptr, 1);
+        memcpy(&object.obj.pattern[FJsonObject::PATTERN_HASH_INLINE], &object.buckets[0],
+               sizeof(int32_t));
+        check_all(object);
+    }
+
+    SUBCASE("uses the hash") {
+        // With duplicate keys, the linear search would find the first, the hash finds the last
+        test_object object{{{L"key", L"first"}, {L"key", L"second"}}, 8};
+        CHECK(object.get(L"key") == L"second");
+
+        test_object unhashed{{{L"key", L"first"}, {L"key", L"second"}}, 0};
+        CHECK(unhashed.get(L"key") == L"first");
+    }
+
+    SUBCASE("untrustworthy hash") {
+        test_object object{pairs, 8};
+
+        // Not a power of two
+        object.set_hash(object.buckets.data(), 6);
+        check_all(object);
+
+        // Every chain loops back on itself
+        test_object looping{pairs, 8};
+        for (size_t i = 0; i < pairs.size(); i++) {
+            looping.obj.entries.data[i].hash_next_id = i;
+        }
+        check_all(looping);
+
+        // Every chain points out of bounds
+        std::vector<int32_t> out_of_bounds(8, 1000);
+        object.set_hash(out_of_bounds.data(), out_of_bounds.size());
+        check_all(object);
+
+        // Empty buckets, as if our hash didn't match unreal's
+        std::vector<int32_t> empty(8, -1);
+        object.set_hash(empty.data(), empty.size());
+        check_all(object);
+    }
+
+    SUBCASE("implausible hash") {
+        // Duplicate keys again, if the hash gets used every bucket leads to the second
+        test_object object{{{L"key", L"first"}, {L"key", L"second"}}, 8};
+        REQUIRE(object.get(L"key") == L"second");
+
+        // Far more buckets than entries
+        std::vector<int32_t> huge(1024, 1);
+        object.set_hash(huge.data(), huge.size());
+        CHECK(object.get(L"key") == L"first");
+
+        // A single bucket, but not stored inline
+        std::vector<int32_t> single{1};
+        object.set_hash(single.data(), 1);
+        CHECK(object.get(L"key") == L"first");
+
+        // Several buckets, but no pointer to them
+        int32_t inline_bucket = 1;
+        memcpy(&object.obj.pattern[FJsonObject::PATTERN_HASH_INLINE], &inline_bucket,
+               sizeof(inline_bucket));
+        object.set_hash(nullptr, 2);
+        CHECK(object.get(L"key") == L"first");
+    }
+}
 
 #pragma endregion
 
+TEST_SUITE_END();
 }  // namespace ohl::unreal
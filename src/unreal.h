@@ -18,6 +18,13 @@ struct FString : TArray<wchar_t> {
      * @return An stl string.
      */
     std::wstring to_wstr(void) const;
+
+    /**
+     * @brief Gets a view of this string's data, without copying it.
+     *
+     * @return A view of the string, excluding the null terminator.
+     */
+    std::wstring_view to_wstr_view(void) const;
 };
 
 struct FReferenceControllerBase {
@@ -60,12 +67,97 @@ struct KeyValuePair {
 
 using JSONObjectEntry = KeyValuePair<FString, TSharedPtr<FJsonValue>>;
 
+/**
+ * @brief Creates the crc table used by unreal's (deprecated) case insensitive string hash.
+ *
+ * @return The crc table.
+ */
+constexpr std::array<uint32_t, 256> make_string_hash_crc_table(void) {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < table.size(); i++) {
+        uint32_t crc = i << 24;
+        for (auto bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+inline constexpr std::array<uint32_t, 256> STRING_HASH_CRC_TABLE = make_string_hash_crc_table();
+
+/**
+ * @brief A key to look up in a json object, with it's hash pre-calculated.
+ * @note Can be created at compile time.
+ */
+struct json_key {
+   private:
+    /**
+     * @brief Hashes a key the same way unreal hashes `FString` map keys.
+     *
+     * @param str The key to hash.
+     * @return The hash, or std::nullopt if the key isn't ascii, since then unreal's upper casing
+     *         might not match ours.
+     */
+    static constexpr std::optional<uint32_t> hash_key(std::wstring_view str) {
+        uint32_t hash = 0;
+        for (auto chr : str) {
+            if (chr >= 0x80) {
+                return std::nullopt;
+            }
+            if (L'a' <= chr && chr <= L'z') {
+                chr -= L'a' - L'A';
+            }
+
+            // Hashes both bytes of the char, the upper is always 0 for ascii
+            hash = ((hash >> 8) & 0x00FFFFFF) ^ STRING_HASH_CRC_TABLE[(hash ^ chr) & 0xFF];
+            hash = ((hash >> 8) & 0x00FFFFFF) ^ STRING_HASH_CRC_TABLE[hash & 0xFF];
+        }
+        return hash;
+    }
+
+   public:
+    std::wstring_view str;
+    std::optional<uint32_t> hash;
+
+    constexpr json_key(std::wstring_view str) : str(str), hash(hash_key(str)) {}
+    constexpr json_key(const wchar_t* str) : json_key(std::wstring_view(str)) {}
+    json_key(const std::wstring& str) : json_key(std::wstring_view(str)) {}
+};
+
 struct FJsonObject {
     TArray<JSONObjectEntry> entries;
 
-    // Unknown what this data represents.
+    // The rest of the map's internals. Not fully reverse engineered, but it's always constant for
+    //  objects with the same amount of entries, except for the hash, which we can use for lookups.
     uint32_t pattern[16];
 
+    // Offsets of the parts of the hash within the pattern. The buckets are stored inline when
+    //  there's only one of them, or in a separate allocation if there are more.
+    static constexpr size_t PATTERN_HASH_INLINE = 10;
+    static constexpr size_t PATTERN_HASH_SECONDARY = 12;
+    static constexpr size_t PATTERN_HASH_SIZE = 14;
+
+   private:
+    /**
+     * @brief Looks up a key using the map's hash.
+     * @note Does not allocate.
+     *
+     * @param key The key to look up.
+     * @return The matching entry, or nullptr if it wasn't found, or if the hash can't be trusted.
+     */
+    const JSONObjectEntry* find_hashed(const json_key& key) const;
+
+   public:
+    /**
+     * @brief Finds the entry with the given key.
+     * @note Does not allocate.
+     * @note Uses the map's hash if it looks sane, falling back to a linear search otherwise.
+     *
+     * @param key The key to look up.
+     * @return The matching entry, or nullptr if the key isn't in this object.
+     */
+    const JSONObjectEntry* find(const json_key& key) const;
+
     /**
      * @brief Gets a value on this object given it's key.
      * @note Throws a runtime error if the key is not found.
@@ -75,7 +167,7 @@ struct FJsonObject {
      * @return A pointer to the value object.
      */
     template <typename T>
-    T* get(std::wstring key) const;
+    T* get(const json_key& key) const;
 };
 
 struct FJsonValueString : FJsonValue {
@@ -132,6 +224,13 @@ struct FSparkRequest {
      * @return the url string
      */
     std::wstring get_url(void) const;
+
+    /**
+     * @brief Get a view of the url of this request, without copying it.
+     *
+     * @return A view of the url string.
+     */
+    std::wstring_view get_url_view(void) const;
 };
 
 }  // namespace ohl::unreal
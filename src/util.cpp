@@ -2,97 +2,459 @@
 
 #include <doctest/doctest.h>
 
+#include "util.h"
+
 namespace ohl::util {
 TEST_SUITE_BEGIN("utils");
 
-std::string narrow(const std::wstring& wstr) {
-    if (wstr.empty()) {
-        return std::string();
+#pragma region Transcoding
+
+// Code units are utf-16 when they're 2 bytes wide (i.e. wchar_t on Windows), and utf-32 when
+//  they're 4 bytes wide (i.e. wchar_t everywhere else)
+
+static const char32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+/**
+ * @brief Decodes the next code point out of a utf-8 string.
+ * @note Invalid sequences decode to a single replacement character, consuming the longest prefix
+ *       of the sequence which was still valid (at least one byte).
+ *
+ * @param str The string to decode.
+ * @param pos The position to decode at. Advanced past the decoded sequence.
+ * @return The decoded code point.
+ */
+static char32_t decode_utf8(std::string_view str, size_t& pos) {
+    auto lead = static_cast<uint8_t>(str[pos++]);
+    if (lead < 0x80) {
+        return lead;
     }
 
-    auto num_chars =
-        WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), wstr.size(), NULL, 0, NULL, NULL);
-    char* str = reinterpret_cast<char*>(malloc((num_chars + 1) * sizeof(char)));
-    if (!str) {
-        throw std::runtime_error("Failed to convert utf16 string!");
+    // The valid range of the second byte depends on the lead, to reject overlong encodings,
+    //  surrogates, and anything above U+10FFFF
+    size_t continuation_count;
+    char32_t code_point;
+    uint8_t second_min = 0x80;
+    uint8_t second_max = 0xBF;
+    if (0xC2 <= lead && lead <= 0xDF) {
+        continuation_count = 1;
+        code_point = lead & 0x1F;
+    } else if (0xE0 <= lead && lead <= 0xEF) {
+        continuation_count = 2;
+        code_point = lead & 0x0F;
+        if (lead == 0xE0) {
+            second_min = 0xA0;
+        } else if (lead == 0xED) {
+            second_max = 0x9F;
+        }
+    } else if (0xF0 <= lead && lead <= 0xF4) {
+        continuation_count = 3;
+        code_point = lead & 0x07;
+        if (lead == 0xF0) {
+            second_min = 0x90;
+        } else if (lead == 0xF4) {
+            second_max = 0x8F;
+        }
+    } else {
+        return REPLACEMENT_CHARACTER;
     }
 
-    WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), wstr.size(), str, num_chars, NULL, NULL);
-    str[num_chars] = L'\0';
+    for (size_t i = 0; i < continuation_count; i++) {
+        if (pos >= str.size()) {
+            return REPLACEMENT_CHARACTER;
+        }
+        auto byte = static_cast<uint8_t>(str[pos]);
+        auto min = i == 0 ? second_min : 0x80;
+        auto max = i == 0 ? second_max : 0xBF;
+        if (byte < min || max < byte) {
+            return REPLACEMENT_CHARACTER;
+        }
 
-    std::string ret{str};
-    free(str);
+        code_point = (code_point << 6) | (byte & 0x3F);
+        pos++;
+    }
 
-    return ret;
+    return code_point;
 }
 
-std::wstring widen(const std::string& str) {
-    if (str.empty()) {
-        return std::wstring();
+/**
+ * @brief Converts a utf-8 string into wide code units.
+ *
+ * @tparam unit The code unit type to convert to.
+ * @tparam write If to write the output, or only count how long it would be.
+ * @param str The string to convert.
+ * @param out The buffer to write to. Must have space for `str.size()` units. Unused if not writing.
+ * @return The amount of code units in the output.
+ */
+template <typename unit, bool write>
+static size_t utf8_to_wide(std::string_view str, unit* out) {
+    static_assert(sizeof(unit) == sizeof(char16_t) || sizeof(unit) == sizeof(char32_t));
+
+    size_t pos = 0;
+    size_t written = 0;
+    while (pos < str.size()) {
+        size_t scalar_end = str.size();
+
+#ifdef OHL_SSE2
+        // Copy across blocks of pure ascii, widening each byte by zero extending it
+        const auto zero = _mm_setzero_si128();
+        for (; pos + sizeof(__m128i) <= str.size(); pos += sizeof(__m128i)) {
+            auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str.data() + pos));
+            if (_mm_movemask_epi8(block) != 0) {
+                break;
+            }
+
+            if constexpr (write && sizeof(unit) == sizeof(char16_t)) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + written),
+                                 _mm_unpacklo_epi8(block, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + written + 8),
+                                 _mm_unpackhi_epi8(block, zero));
+            } else if constexpr (write) {
+                for (size_t i = 0; i < sizeof(__m128i); i++) {
+                    out[written + i] = static_cast<unit>(str[pos + i]);
+                }
+            }
+            written += sizeof(__m128i);
+        }
+
+        // Only go back to checking blocks after getting past the one which wasn't all ascii, so
+        //  that mostly non-ascii strings don't keep paying for checks which will fail
+        scalar_end = std::min(pos + sizeof(__m128i), str.size());
+#endif
+
+        while (pos < scalar_end) {
+            auto code_point = decode_utf8(str, pos);
+
+            if (sizeof(unit) == sizeof(char16_t) && code_point > 0xFFFF) {
+                if constexpr (write) {
+                    code_point -= 0x10000;
+                    out[written] = static_cast<unit>(0xD800 | (code_point >> 10));
+                    out[written + 1] = static_cast<unit>(0xDC00 | (code_point & 0x3FF));
+                }
+                written += 2;
+            } else {
+                if constexpr (write) {
+                    out[written] = static_cast<unit>(code_point);
+                }
+                written++;
+            }
+        }
     }
 
-    auto num_chars = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), str.size(), NULL, 0);
-    wchar_t* wstr = reinterpret_cast<wchar_t*>(malloc((num_chars + 1) * sizeof(wchar_t)));
-    if (!wstr) {
-        throw std::runtime_error("Failed to convert utf8 string!");
+    return written;
+}
+
+/**
+ * @brief Decodes the next code point out of a string of wide code units.
+ * @note Unpaired surrogates, and anything out of range, decode to a replacement character.
+ *
+ * @tparam unit The code unit type to decode.
+ * @param str The string to decode.
+ * @param pos The position to decode at. Advanced past the decoded code units.
+ * @return The decoded code point.
+ */
+template <typename unit>
+static char32_t decode_wide(std::basic_string_view<unit> str, size_t& pos) {
+    auto code_point = static_cast<char32_t>(str[pos++]);
+    if (code_point < 0xD800 || (0xDFFF < code_point && code_point <= 0x10FFFF)) {
+        return code_point;
     }
 
-    MultiByteToWideChar(CP_UTF8, 0, str.c_str(), str.size(), wstr, num_chars);
-    wstr[num_chars] = L'\0';
+    if constexpr (sizeof(unit) == sizeof(char16_t)) {
+        if (code_point <= 0xDBFF && pos < str.size()) {
+            auto low = static_cast<char32_t>(str[pos]);
+            if (0xDC00 <= low && low <= 0xDFFF) {
+                pos++;
+                return 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+            }
+        }
+    }
 
-    std::wstring ret{wstr};
-    free(wstr);
+    return REPLACEMENT_CHARACTER;
+}
 
-    return ret;
+/**
+ * @brief Converts a string of wide code units into utf-8.
+ *
+ * @tparam unit The code unit type to convert from.
+ * @tparam write If to write the output, or only count how long it would be.
+ * @param str The string to convert.
+ * @param out The buffer to write to. Unused if not writing.
+ * @return The amount of chars in the output.
+ */
+template <typename unit, bool write>
+static size_t wide_to_utf8(std::basic_string_view<unit> str, char* out) {
+    static_assert(sizeof(unit) == sizeof(char16_t) || sizeof(unit) == sizeof(char32_t));
+
+    size_t pos = 0;
+    size_t written = 0;
+    while (pos < str.size()) {
+        size_t scalar_end = str.size();
+
+#ifdef OHL_SSE2
+        if constexpr (sizeof(unit) == sizeof(char16_t)) {
+            // Copy across blocks of pure ascii, narrowing pairs of registers into one
+            static constexpr auto units_per_register = sizeof(__m128i) / sizeof(unit);
+            const auto non_ascii = _mm_set1_epi16(static_cast<int16_t>(0xFF80));
+            const auto zero = _mm_setzero_si128();
+            for (; pos + 2 * units_per_register <= str.size(); pos += 2 * units_per_register) {
+                auto data = str.data() + pos;
+                auto low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+                auto high =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + units_per_register));
+                auto high_bits = _mm_and_si128(_mm_or_si128(low, high), non_ascii);
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, zero)) != 0xFFFF) {
+                    break;
+                }
+
+                if constexpr (write) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + written),
+                                     _mm_packus_epi16(low, high));
+                }
+                written += sizeof(__m128i);
+            }
+
+            scalar_end = std::min(pos + 2 * units_per_register, str.size());
+        }
+#endif
+
+        while (pos < scalar_end) {
+            auto code_point = decode_wide(str, pos);
+
+            if (code_point < 0x80) {
+                if constexpr (write) {
+                    out[written] = static_cast<char>(code_point);
+                }
+                written += 1;
+            } else if (code_point < 0x800) {
+                if constexpr (write) {
+                    out[written] = static_cast<char>(0xC0 | (code_point >> 6));
+                    out[written + 1] = static_cast<char>(0x80 | (code_point & 0x3F));
+                }
+                written += 2;
+            } else if (code_point < 0x10000) {
+                if constexpr (write) {
+                    out[written] = static_cast<char>(0xE0 | (code_point >> 12));
+                    out[written + 1] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                    out[written + 2] = static_cast<char>(0x80 | (code_point & 0x3F));
+                }
+                written += 3;
+            } else {
+                if constexpr (write) {
+                    out[written] = static_cast<char>(0xF0 | (code_point >> 18));
+                    out[written + 1] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+                    out[written + 2] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                    out[written + 3] = static_cast<char>(0x80 | (code_point & 0x3F));
+                }
+                written += 4;
+            }
+        }
+    }
+
+    return written;
 }
 
-TEST_CASE("utils::narrow") {
-    // Test using unicode literals directly to be safe of any encoding issues
-    // UTF16 literals are `char16_t[]`s, which won't implicitly cast to wstring
-    static_assert(sizeof(wchar_t) == sizeof(char16_t));
+size_t narrowed_size(std::wstring_view wstr) {
+    return wide_to_utf8<wchar_t, false>(wstr, nullptr);
+}
 
-    CHECK(narrow((wchar_t*)u"test case") == u8"test case");
-    CHECK(narrow((wchar_t*)u"υπόθεση δοκιμής") == u8"υπόθεση δοκιμής");
-    CHECK(narrow((wchar_t*)u"прецедент") == u8"прецедент");
-    CHECK(narrow((wchar_t*)u"テストケース") == u8"テストケース");
-    CHECK(narrow((wchar_t*)u"\u0000\u007F\u0080\u1234") == u8"\u0000\u007F\u0080\u1234");
+size_t narrow_into(std::wstring_view wstr, char* out) {
+    return wide_to_utf8<wchar_t, true>(wstr, out);
+}
 
-    CHECK(narrow((wchar_t*)u"test case") != u8"other string");
+size_t widened_size(std::string_view str) {
+    return utf8_to_wide<wchar_t, false>(str, nullptr);
 }
 
-TEST_CASE("utils::widen") {
-    static_assert(sizeof(wchar_t) == sizeof(char16_t));
+size_t widen_into(std::string_view str, wchar_t* out) {
+    return utf8_to_wide<wchar_t, true>(str, out);
+}
 
-    CHECK(widen(u8"test case") == (wchar_t*)u"test case");
-    CHECK(widen(u8"υπόθεση δοκιμής") == (wchar_t*)u"υπόθεση δοκιμής");
-    CHECK(widen(u8"прецедент") == (wchar_t*)u"прецедент");
-    CHECK(widen(u8"テストケース") == (wchar_t*)u"テストケース");
-    CHECK(widen(u8"\u0000\u007F\u0080\u1234") == (wchar_t*)u"\u0000\u007F\u0080\u1234");
+bool is_valid_utf8(std::string_view str) {
+    size_t pos = 0;
+    while (pos < str.size()) {
+        auto start = pos;
+        if (decode_utf8(str, pos) == REPLACEMENT_CHARACTER) {
+            // Make sure it wasn't actually an encoded replacement character
+            if (str.substr(start, pos - start) != "\xEF\xBF\xBD") {
+                return false;
+            }
+        }
+    }
+    return true;
+}
 
-    CHECK(widen(u8"test case") != (wchar_t*)u"other string");
+std::string narrow(std::wstring_view wstr) {
+    // Sizing it first is cheap, and saves over-allocating by up to 3x for ascii strings
+    std::string str(narrowed_size(wstr), '\0');
+    narrow_into(wstr, str.data());
+    return str;
 }
 
-TEST_CASE("utils::narrow - utils::widen round trip") {
-    static_assert(sizeof(wchar_t) == sizeof(char16_t));
+std::wstring widen(std::string_view str) {
+    // Never need more wchars than chars, so can widen in one pass and then shrink
+    std::wstring wstr(str.size(), L'\0');
+    wstr.resize(widen_into(str, wstr.data()));
+    return wstr;
+}
 
-    CHECK(widen(narrow((wchar_t*)u"test case")) == (wchar_t*)u"test case");
-    CHECK(widen(narrow((wchar_t*)u"υπόθεση δοκιμής")) == (wchar_t*)u"υπόθεση δοκιμής");
-    CHECK(widen(narrow((wchar_t*)u"прецедент")) == (wchar_t*)u"прецедент");
-    CHECK(widen(narrow((wchar_t*)u"テストケース")) == (wchar_t*)u"テストケース");
-    CHECK(widen(narrow((wchar_t*)u"\u0000\u007F\u0080\u1234"))
-          == (wchar_t*)u"\u0000\u007F\u0080\u1234");
+TEST_CASE("utils::narrow") {
+    CHECK(narrow(L"test case") == u8"test case");
+    CHECK(narrow(L"υπόθεση δοκιμής") == u8"υπόθεση δοκιμής");
+    CHECK(narrow(L"прецедент") == u8"прецедент");
+    CHECK(narrow(L"テストケース") == u8"テストケース");
+    CHECK(narrow(std::wstring_view(L"\u0000\u007F\u0080ሴ", 4))
+          == std::string_view(u8"\u0000\u007F\u0080ሴ", 7));
+    CHECK(narrow(L"\U0001F600") == u8"\U0001F600");
+
+    CHECK(narrow(L"test case") != u8"other string");
+    CHECK(narrow(L"").empty());
+
+    // Unpaired surrogates get replaced
+    CHECK(narrow(std::wstring{0xD800, L'a'}) == u8"�a");
+    CHECK(narrow(std::wstring{L'a', 0xDC00}) == u8"a�");
+}
+
+TEST_CASE("utils::widen") {
+    CHECK(widen(u8"test case") == L"test case");
+    CHECK(widen(u8"υπόθεση δοκιμής") == L"υπόθεση δοκιμής");
+    CHECK(widen(u8"прецедент") == L"прецедент");
+    CHECK(widen(u8"テストケース") == L"テストケース");
+    CHECK(widen(std::string_view(u8"\u0000\u007F\u0080ሴ", 7))
+          == std::wstring_view(L"\u0000\u007F\u0080ሴ", 4));
+    CHECK(widen(u8"\U0001F600") == L"\U0001F600");
+
+    CHECK(widen(u8"test case") != L"other string");
+    CHECK(widen("").empty());
+}
 
-    CHECK(widen(narrow((wchar_t*)u"test case")) != (wchar_t*)u"other string");
+TEST_CASE("utils::narrow - utils::widen round trip") {
+    CHECK(widen(narrow(L"test case")) == L"test case");
+    CHECK(widen(narrow(L"υπόθεση δοκιμής")) == L"υπόθεση δοκιμής");
+    CHECK(widen(narrow(L"прецедент")) == L"прецедент");
+    CHECK(widen(narrow(L"テストケース")) == L"テストケース");
+    CHECK(widen(narrow(std::wstring_view(L"\u0000\u007F\u0080ሴ", 4)))
+          == std::wstring_view(L"\u0000\u007F\u0080ሴ", 4));
+    CHECK(widen(narrow(L"\U0001F600")) == L"\U0001F600");
+
+    CHECK(widen(narrow(L"test case")) != L"other string");
 
     CHECK(narrow(widen(u8"test case")) == u8"test case");
     CHECK(narrow(widen(u8"υπόθεση δοκιμής")) == u8"υπόθεση δοκιμής");
     CHECK(narrow(widen(u8"прецедент")) == u8"прецедент");
     CHECK(narrow(widen(u8"テストケース")) == u8"テストケース");
-    CHECK(narrow(widen(u8"\u0000\u007F\u0080\u1234")) == u8"\u0000\u007F\u0080\u1234");
+    CHECK(narrow(widen(std::string_view(u8"\u0000\u007F\u0080ሴ", 7)))
+          == std::string_view(u8"\u0000\u007F\u0080ሴ", 7));
+    CHECK(narrow(widen(u8"\U0001F600")) == u8"\U0001F600");
 
     CHECK(narrow(widen(u8"test case")) != u8"other string");
 }
 
+TEST_CASE("utils::widen - invalid utf8") {
+    // Each maximal invalid subsequence becomes a single replacement character
+    CHECK(widen("a\x80z") == L"a�z");
+    CHECK(widen("a\xC0\x80z") == L"a��z");
+    CHECK(widen("a\xED\xA0\x80z") == L"a���z");
+    CHECK(widen("a\xE2\x82z") == L"a�z");
+    CHECK(widen("a\xF4\x90\x80\x80z") == L"a����z");
+    CHECK(widen("a\xF5z") == L"a�z");
+    CHECK(widen("a\xF0\x9F\x98") == L"a�");
+
+    CHECK(is_valid_utf8(""));
+    CHECK(is_valid_utf8(u8"テストケース \U0001F600 �"));
+    CHECK(!is_valid_utf8("a\x80z"));
+    CHECK(!is_valid_utf8("a\xC0\x80z"));
+    CHECK(!is_valid_utf8("a\xED\xA0\x80z"));
+    CHECK(!is_valid_utf8("a\xF0\x9F\x98"));
+
+    // Never needs more wchars than chars, even with replacements
+    for (const auto& str : {"\x80\x80\x80", "\xE2\x82\xE2\x82", "\xF0\x9F\x98\xF0\x9F"}) {
+        CHECK(widened_size(str) <= strlen(str));
+    }
+}
+
+TEST_CASE("utils::widen_into - utils::narrow_into") {
+    // Cross the vectorized block boundaries at various offsets
+    for (size_t prefix = 0; prefix < 40; prefix++) {
+        const std::string ascii(prefix, 'a');
+        const std::wstring wide_ascii(prefix, L'a');
+
+        const std::string str = ascii + u8"é" + ascii + u8"テ\U0001F600" + ascii;
+        const std::wstring wstr = wide_ascii + L"é" + wide_ascii + L"テ\U0001F600" + wide_ascii;
+
+        // Write into a larger buffer, to make sure nothing's written past the end
+        std::wstring wide_buf(str.size() + 8, L'#');
+        REQUIRE(widened_size(str) == wstr.size());
+        REQUIRE(widen_into(str, wide_buf.data()) == wstr.size());
+        CHECK(std::wstring_view(wide_buf).substr(0, wstr.size()) == wstr);
+        CHECK(wide_buf[wstr.size()] == L'#');
+
+        std::string buf(str.size() + 8, '#');
+        REQUIRE(narrowed_size(wstr) == str.size());
+        REQUIRE(narrow_into(wstr, buf.data()) == str.size());
+        CHECK(std::string_view(buf).substr(0, str.size()) == str);
+        CHECK(buf[str.size()] == '#');
+
+        // wchar_t isn't utf-16 on every platform, make sure to test it directly too
+        const std::u16string u16_ascii(prefix, u'a');
+        const std::u16string u16str = u16_ascii + u"é" + u16_ascii + u"テ\U0001F600" + u16_ascii;
+        std::u16string u16_buf(str.size(), u'#');
+        REQUIRE((utf8_to_wide<char16_t, true>(str, u16_buf.data())) == u16str.size());
+        CHECK(std::u16string_view(u16_buf).substr(0, u16str.size()) == u16str);
+        REQUIRE((wide_to_utf8<char16_t, true>(u16str, buf.data())) == str.size());
+        CHECK(std::string_view(buf).substr(0, str.size()) == str);
+    }
+}
+
+TEST_CASE("utils::widen - throughput benchmark" * doctest::skip()) {
+    static const size_t SIZE = 64 * 1024 * 1024;
+
+    std::string ascii{};
+    std::string mixed{};
+    while (ascii.size() < SIZE) {
+        ascii += "SparkPatchEntry,(1,1,0,),/Game/Gear/Weapons/_Shared/_Design/Balance/Balance\n";
+        mixed += u8"SparkPatchEntry,(1,1,0,),/Game/Gear/テストケース/υπόθεση/Balance\n";
+    }
+
+    using clock = std::chrono::steady_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    auto report = [](const char* name, size_t bytes, clock::duration time) {
+        auto us = std::max<microseconds::rep>(duration_cast<microseconds>(time).count(), 1);
+        MESSAGE(name << ": " << (bytes / us) << "MB/s");
+    };
+
+    for (const auto& [name, str] : {std::pair{"ascii", &ascii}, std::pair{"mixed", &mixed}}) {
+        std::wstring wide(str->size(), L'\0');
+        auto widen_start = clock::now();
+        wide.resize(widen_into(*str, wide.data()));
+        report((std::string("widen ") + name).c_str(), str->size(), clock::now() - widen_start);
+
+        std::string narrowed(str->size(), '\0');
+        auto narrow_start = clock::now();
+        narrowed.resize(narrow_into(wide, narrowed.data()));
+        report((std::string("narrow ") + name).c_str(), str->size(), clock::now() - narrow_start);
+
+        CHECK(narrowed == *str);
+
+        // wchar_t isn't utf-16 on every platform, make sure to measure it directly too
+        std::u16string u16(str->size(), u'\0');
+        auto u16_widen_start = clock::now();
+        u16.resize(utf8_to_wide<char16_t, true>(*str, u16.data()));
+        report((std::string("widen utf-16 ") + name).c_str(), str->size(),
+               clock::now() - u16_widen_start);
+
+        auto u16_narrow_start = clock::now();
+        narrowed.resize(wide_to_utf8<char16_t, true>(u16, narrowed.data()));
+        report((std::string("narrow utf-16 ") + name).c_str(), str->size(),
+               clock::now() - u16_narrow_start);
+
+        CHECK(narrowed == *str);
+    }
+}
+
+#pragma endregion
+
 std::vector<std::filesystem::path> get_sorted_files_in_dir(const std::filesystem::path& path) {
     std::vector<std::filesystem::path> files{};
     for (const auto& dir_entry : std::filesystem::directory_iterator{path}) {
@@ -145,5 +507,218 @@ TEST_CASE("utils::unescape_url") {
     CHECK(unescape_url("https://exa%6Dple%2ecom%23t%65st", true) == "https://example.com#test");
 }
 
+uint64_t hash_bytes(std::string_view data) {
+    // Multiply-xorshift over 8 byte words, so we only pay one multiply per word
+    static const uint64_t MULTIPLIER = 0x9E3779B97F4A7C15;
+
+    uint64_t hash = 0xCBF29CE484222325 ^ (data.size() * MULTIPLIER);
+
+    size_t pos = 0;
+    for (; pos + sizeof(uint64_t) <= data.size(); pos += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data.data() + pos, sizeof(word));
+        hash = (hash ^ word) * MULTIPLIER;
+        hash ^= hash >> 29;
+    }
+
+    uint64_t tail = 0;
+    memcpy(&tail, data.data() + pos, data.size() - pos);
+    hash = (hash ^ tail) * MULTIPLIER;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+TEST_CASE("utils::hash_bytes") {
+    CHECK(hash_bytes("") == hash_bytes(""));
+    CHECK(hash_bytes("some test data") == hash_bytes(std::string("some test data")));
+
+    CHECK(hash_bytes("") != hash_bytes(std::string_view("\0", 1)));
+    CHECK(hash_bytes("some test data") != hash_bytes("some test dat"));
+    CHECK(hash_bytes("some test data") != hash_bytes("some test datb"));
+    CHECK(hash_bytes("12345678abcdefgh") != hash_bytes("abcdefgh12345678"));
+
+    // Views into the middle of a string shouldn't read past their end
+    const std::string longer = "some test data, plus some more";
+    CHECK(hash_bytes(std::string_view(longer).substr(0, 14)) == hash_bytes("some test data"));
+}
+
+mapped_file::mapped_file(const std::filesystem::path& path) {
+    // Allow other processes to keep editing the file while we've got it open
+    this->file = CreateFileW(path.c_str(), GENERIC_READ,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (this->file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(this->file, &file_size)) {
+        this->close();
+        return;
+    }
+
+    // Empty files can't be mapped, but we can still give out an empty view
+    this->size = static_cast<size_t>(file_size.QuadPart);
+    if (this->size == 0) {
+        return;
+    }
+
+    this->mapping = CreateFileMappingW(this->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (this->mapping == NULL) {
+        this->close();
+        return;
+    }
+
+    this->data =
+        reinterpret_cast<const char*>(MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+    if (this->data == nullptr) {
+        this->close();
+        return;
+    }
+}
+
+mapped_file::~mapped_file() {
+    this->close();
+}
+
+void mapped_file::close(void) {
+    if (this->data != nullptr) {
+        UnmapViewOfFile(this->data);
+        this->data = nullptr;
+    }
+    if (this->mapping != NULL) {
+        CloseHandle(this->mapping);
+        this->mapping = NULL;
+    }
+    if (this->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(this->file);
+        this->file = INVALID_HANDLE_VALUE;
+    }
+    this->size = 0;
+}
+
+bool mapped_file::is_open(void) const {
+    return this->file != INVALID_HANDLE_VALUE && (this->size == 0 || this->data != nullptr);
+}
+
+std::string_view mapped_file::view(void) const {
+    if (this->data == nullptr) {
+        return {};
+    }
+    return {this->data, this->size};
+}
+
+TEST_CASE("utils::mapped_file") {
+    const auto path = std::filesystem::path("tests") / "unicode_statement.bl3hotfix";
+
+    std::ifstream stream{path, std::ios::binary};
+    REQUIRE(stream.is_open());
+    const std::string expected{std::istreambuf_iterator<char>(stream),
+                               std::istreambuf_iterator<char>()};
+
+    mapped_file mapping{path};
+    REQUIRE(mapping.is_open());
+    CHECK(mapping.view() == expected);
+
+    mapped_file missing{std::filesystem::path("tests") / "missing_file.bl3hotfix"};
+    CHECK(!missing.is_open());
+    CHECK(missing.view().empty());
+}
+
+static const size_t ARENA_INITIAL_BLOCK_SIZE = 64 * 1024;
+static std::atomic<uint64_t> next_arena_id{1};
+
+arena::arena(std::pmr::memory_resource* upstream) : id(next_arena_id++), upstream(upstream) {}
+
+std::pmr::memory_resource* arena::get_thread_resource(void) {
+    // Ids are never reused, so a stale cache entry from a destroyed arena can never match
+    thread_local uint64_t cached_id = 0;
+    thread_local std::pmr::memory_resource* cached_resource = nullptr;
+    if (cached_id == this->id) {
+        return cached_resource;
+    }
+
+    std::lock_guard<std::mutex> lock(this->thread_resources_mutex);
+
+    auto this_thread = std::this_thread::get_id();
+    auto existing = std::find_if(
+        this->thread_resources.begin(), this->thread_resources.end(),
+        [&](const auto& thread_resource) { return thread_resource.first == this_thread; });
+    if (existing != this->thread_resources.end()) {
+        cached_resource = existing->second.get();
+    } else {
+        cached_resource = this->thread_resources
+                              .emplace_back(this_thread,
+                                            std::make_unique<std::pmr::monotonic_buffer_resource>(
+                                                ARENA_INITIAL_BLOCK_SIZE, this->upstream))
+                              .second.get();
+    }
+    cached_id = this->id;
+
+    return cached_resource;
+}
+
+void* arena::do_allocate(size_t bytes, size_t alignment) {
+    this->allocated += bytes;
+    return this->get_thread_resource()->allocate(bytes, alignment);
+}
+
+void arena::do_deallocate(void*, size_t, size_t) {}
+
+bool arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+size_t arena::bytes_allocated(void) const {
+    return this->allocated;
+}
+
+TEST_CASE("utils::arena") {
+    arena test_arena{};
+
+    std::pmr::vector<std::pmr::string> strings{&test_arena};
+    for (auto i = 0; i < 1000; i++) {
+        strings.emplace_back("a string which is too long for small string optimization " +
+                             std::to_string(i));
+    }
+    CHECK(strings.back().get_allocator().resource() == &test_arena);
+    CHECK(strings.back() == "a string which is too long for small string optimization 999");
+    CHECK(test_arena.bytes_allocated() > 0);
+
+    auto aligned = test_arena.allocate(64, 64);
+    CHECK(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+
+    // Allocate from a bunch of threads at once, and make sure none of them overlap
+    static const auto THREAD_COUNT = 8;
+    static const auto ALLOCATIONS_PER_THREAD = 1000;
+    std::vector<std::vector<uint32_t*>> allocations(THREAD_COUNT);
+    {
+        std::vector<std::thread> threads{};
+        for (uint32_t i = 0; i < THREAD_COUNT; i++) {
+            threads.emplace_back([&, i]() {
+                for (auto j = 0; j < ALLOCATIONS_PER_THREAD; j++) {
+                    auto ptr = reinterpret_cast<uint32_t*>(
+                        test_arena.allocate(sizeof(uint32_t), alignof(uint32_t)));
+                    *ptr = i;
+                    allocations[i].push_back(ptr);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    for (uint32_t i = 0; i < THREAD_COUNT; i++) {
+        for (auto ptr : allocations[i]) {
+            REQUIRE(*ptr == i);
+        }
+    }
+
+    arena other_arena{};
+    CHECK(test_arena.is_equal(test_arena));
+    CHECK(!test_arena.is_equal(other_arena));
+}
+
 TEST_SUITE_END();
 }  // namespace ohl::util
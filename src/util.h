@@ -1,22 +1,72 @@
+#pragma once
+
 #include <pch.h>
 
 namespace ohl::util {
 
 /**
  * @brief Narrows a utf-16 wstring to a utf-8 string.
+ * @note Unpaired surrogates are replaced with U+FFFD.
  *
  * @param str The input wstring.
  * @return The output string.
  */
-std::string narrow(const std::wstring& wstr);
+std::string narrow(std::wstring_view wstr);
 
 /**
  * @brief Widens a utf-8 string to a utf-16 wstring.
+ * @note Invalid sequences are replaced with U+FFFD.
  *
  * @param str The input string.
  * @return The output wstring.
  */
-std::wstring widen(const std::string& str);
+std::wstring widen(std::string_view str);
+
+/**
+ * @brief Gets how many chars a wstring takes up once narrowed to utf-8.
+ *
+ * @param wstr The input wstring.
+ * @return The amount of chars `narrow_into` will write.
+ */
+size_t narrowed_size(std::wstring_view wstr);
+
+/**
+ * @brief Narrows a utf-16 wstring to utf-8, writing straight into a buffer.
+ * @note Does not add a null terminator.
+ *
+ * @param wstr The input wstring.
+ * @param out The buffer to write to. Must have space for at least `narrowed_size(wstr)` chars.
+ * @return The amount of chars written.
+ */
+size_t narrow_into(std::wstring_view wstr, char* out);
+
+/**
+ * @brief Gets how many wchars a string takes up once widened to utf-16.
+ * @note Never more than the size of the input string.
+ *
+ * @param str The input string.
+ * @return The amount of wchars `widen_into` will write.
+ */
+size_t widened_size(std::string_view str);
+
+/**
+ * @brief Widens a utf-8 string to utf-16, writing straight into a buffer.
+ * @note Does not add a null terminator.
+ *
+ * @param str The input string.
+ * @param out The buffer to write to. Must have space for at least `widened_size(str)` wchars - or
+ *            just `str.size()`, to avoid needing to scan the string twice.
+ * @return The amount of wchars written.
+ */
+size_t widen_into(std::string_view str, wchar_t* out);
+
+/**
+ * @brief Checks if a string is entirely valid utf-8.
+ *
+ * @param str The string to check.
+ * @return True if the string is valid.
+ */
+bool is_valid_utf8(std::string_view str);
 
 /**
  * @brief Get all files in a directory, sorted numerically.
@@ -36,4 +86,128 @@ std::vector<std::filesystem::path> get_sorted_files_in_dir(const std::filesystem
  */
 std::string unescape_url(const std::string& url, bool extra_info);
 
+/**
+ * @brief Hashes a block of bytes.
+ * @note Not cryptographic, only intended to detect changes.
+ *
+ * @param data The bytes to hash.
+ * @return The hash.
+ */
+uint64_t hash_bytes(std::string_view data);
+
+/**
+ * @brief Gets an object which is created on first use, and then never destroyed.
+ * @note Statics are destroyed while the dll's being unloaded, when joining a thread could
+ *       deadlock, so anything which owns threads should be created through this instead.
+ * @note Since it's only created on first use, it may depend on the args.
+ *
+ * @tparam Factory The type of the function creating the object. Every lambda has a unique type,
+ *                 so each call site gets it's own object.
+ * @param factory The function creating the object, only called the first time.
+ * @return The object.
+ */
+template <typename Factory>
+std::invoke_result_t<Factory>& leaked(Factory factory) {
+    static auto object = new std::invoke_result_t<Factory>(factory());
+    return *object;
+}
+
+/**
+ * @brief Class which runs a function once it goes out of scope, including when unwinding.
+ *
+ * @tparam Func The type of the function to run.
+ */
+template <typename Func>
+class scope_exit {
+   private:
+    Func func;
+
+   public:
+    scope_exit(Func func) : func(std::move(func)) {}
+    ~scope_exit() { this->func(); }
+
+    scope_exit(const scope_exit&) = delete;
+    scope_exit& operator=(const scope_exit&) = delete;
+};
+
+/**
+ * @brief Class holding a read only memory mapping of a file.
+ * @note The view is only valid for as long as this object is alive.
+ */
+class mapped_file {
+   private:
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+    const char* data = nullptr;
+    size_t size = 0;
+
+    /**
+     * @brief Closes all handles held by this object.
+     */
+    void close(void);
+
+   public:
+    mapped_file(const std::filesystem::path& path);
+    ~mapped_file();
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    /**
+     * @brief Checks if the file was successfully mapped.
+     *
+     * @return True if the file is mapped, false otherwise.
+     */
+    bool is_open(void) const;
+
+    /**
+     * @brief Gets a view of the file's contents.
+     *
+     * @return A view of the full file.
+     */
+    std::string_view view(void) const;
+};
+
+/**
+ * @brief Monotonic memory resource which may be allocated from by multiple threads at once.
+ * @note Each thread allocates out of it's own set of blocks, so allocations never contend.
+ * @note Deallocation is a no-op, all memory is released in one go when the arena is destroyed.
+ */
+class arena : public std::pmr::memory_resource {
+   private:
+    const uint64_t id;
+    std::pmr::memory_resource* upstream;
+
+    std::mutex thread_resources_mutex;
+    std::vector<std::pair<std::thread::id, std::unique_ptr<std::pmr::monotonic_buffer_resource>>>
+        thread_resources;
+
+    std::atomic<size_t> allocated{0};
+
+    /**
+     * @brief Gets the resource the current thread should allocate from, creating it if needed.
+     *
+     * @return The current thread's resource.
+     */
+    std::pmr::memory_resource* get_thread_resource(void);
+
+   protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+   public:
+    arena(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    /**
+     * @brief Gets the total amount of bytes allocated out of this arena.
+     *
+     * @return The amount of bytes.
+     */
+    size_t bytes_allocated(void) const;
+};
+
 }  // namespace ohl::util
@@ -0,0 +1,266 @@
+#include <pch.h>
+
+#include <doctest/doctest.h>
+
+#include "watcher.h"
+
+namespace ohl::watcher {
+TEST_SUITE_BEGIN("watcher");
+
+// The longest the watcher thread will go without checking if it should stop
+static const std::chrono::milliseconds STOP_CHECK_INTERVAL{100};
+
+#pragma region Backends
+
+native_backend::native_backend(const std::filesystem::path& dir)
+    : handle(FindFirstChangeNotificationW(dir.wstring().c_str(), TRUE,
+                                          FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME
+                                              | FILE_NOTIFY_CHANGE_SIZE
+                                              | FILE_NOTIFY_CHANGE_LAST_WRITE)) {
+    if (this->handle == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to create change notification for " + dir.string() + ": "
+                                 + std::to_string(GetLastError()));
+    }
+}
+
+native_backend::~native_backend() {
+    FindCloseChangeNotification(this->handle);
+}
+
+bool native_backend::wait(std::chrono::milliseconds timeout) {
+    if (WaitForSingleObject(this->handle, static_cast<DWORD>(timeout.count())) != WAIT_OBJECT_0) {
+        return false;
+    }
+
+    // Re-arm the notification, anything changing from here on signals it again
+    FindNextChangeNotification(this->handle);
+    return true;
+}
+
+/**
+ * @brief Lists all files in a folder, recursively, along with their sizes and modification times.
+ * @note Silently skips anything which can't be read, a missing folder is just empty.
+ *
+ * @param dir The folder to list.
+ * @return The listing.
+ */
+static polling_backend::listing get_listing(const std::filesystem::path& dir) {
+    polling_backend::listing listing{};
+
+    std::error_code ec;
+    std::filesystem::recursive_directory_iterator it{
+        dir, std::filesystem::directory_options::skip_permission_denied, ec};
+    for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        std::error_code entry_ec;
+        auto size = it->is_regular_file(entry_ec) ? it->file_size(entry_ec) : 0;
+        auto mtime = it->last_write_time(entry_ec);
+        if (entry_ec) {
+            continue;
+        }
+        listing.emplace(it->path(), std::make_pair(size, mtime));
+    }
+
+    return listing;
+}
+
+polling_backend::polling_backend(const std::filesystem::path& dir,
+                                 std::chrono::milliseconds interval)
+    : dir(dir),
+      interval(interval),
+      next_poll(std::chrono::steady_clock::now() + interval),
+      last_listing(get_listing(dir)) {}
+
+bool polling_backend::wait(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= this->next_poll) {
+            this->next_poll = now + this->interval;
+
+            auto listing = get_listing(this->dir);
+            if (listing != this->last_listing) {
+                this->last_listing = std::move(listing);
+                return true;
+            }
+        }
+
+        if (this->next_poll > deadline) {
+            std::this_thread::sleep_until(deadline);
+            return false;
+        }
+        std::this_thread::sleep_until(this->next_poll);
+    }
+}
+
+std::unique_ptr<backend> create_backend(const std::filesystem::path& dir) {
+    try {
+        return std::make_unique<native_backend>(dir);
+    } catch (const std::runtime_error& ex) {
+        LOGW << "[OHL] " << ex.what() << ", falling back to polling";
+        return std::make_unique<polling_backend>(dir);
+    }
+}
+
+TEST_CASE("watcher::polling_backend") {
+    static const std::chrono::milliseconds INTERVAL{5};
+    static const std::chrono::milliseconds NO_CHANGE_TIMEOUT{50};
+    static const std::chrono::milliseconds CHANGE_TIMEOUT{5000};
+
+    const auto dir = std::filesystem::temp_directory_path() / "ohl_polling_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "nested");
+
+    auto write_file = [&](const std::filesystem::path& path, const std::string& contents) {
+        std::ofstream out{dir / path, std::ios::binary | std::ios::trunc};
+        out << contents;
+    };
+    write_file("a.txt", "a");
+
+    polling_backend backend{dir, INTERVAL};
+    CHECK_FALSE(backend.wait(NO_CHANGE_TIMEOUT));
+
+    write_file("b.txt", "b");
+    CHECK(backend.wait(CHANGE_TIMEOUT));
+    CHECK_FALSE(backend.wait(NO_CHANGE_TIMEOUT));
+
+    // Changes made while not waiting should still be seen
+    write_file("a.txt", "aaa");
+    std::this_thread::sleep_for(NO_CHANGE_TIMEOUT);
+    CHECK(backend.wait(CHANGE_TIMEOUT));
+    CHECK_FALSE(backend.wait(NO_CHANGE_TIMEOUT));
+
+    write_file(std::filesystem::path("nested") / "c.txt", "c");
+    CHECK(backend.wait(CHANGE_TIMEOUT));
+
+    std::filesystem::remove(dir / "b.txt");
+    CHECK(backend.wait(CHANGE_TIMEOUT));
+    CHECK_FALSE(backend.wait(NO_CHANGE_TIMEOUT));
+
+    // A zero timeout should still poll
+    write_file("d.txt", "d");
+    std::this_thread::sleep_for(INTERVAL * 2);
+    CHECK(backend.wait(std::chrono::milliseconds(0)));
+
+    std::filesystem::remove_all(dir);
+}
+
+#pragma endregion
+
+#pragma region Watcher
+
+watcher::watcher(std::unique_ptr<ohl::watcher::backend> backend,
+                 std::function<void(void)> callback,
+                 std::chrono::milliseconds debounce)
+    : backend(std::move(backend)),
+      callback(std::move(callback)),
+      debounce(debounce),
+      stopping(false),
+      thread(&watcher::run, this) {}
+
+watcher::~watcher() {
+    this->stopping = true;
+    this->thread.join();
+}
+
+void watcher::run(void) {
+    SetThreadDescription(GetCurrentThread(), L"OpenHotfixLoader Watcher");
+
+    using clock = std::chrono::steady_clock;
+
+    while (!this->stopping) {
+        if (!this->backend->wait(STOP_CHECK_INTERVAL)) {
+            continue;
+        }
+
+        // Editors often save in bursts (write a temp file, rename it, touch it again), wait until
+        //  nothing's changed for a while before running the callback
+        auto settled = clock::now() + this->debounce;
+        while (!this->stopping) {
+            auto now = clock::now();
+            if (now >= settled) {
+                break;
+            }
+
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(settled - now);
+            if (this->backend->wait(std::min(remaining, STOP_CHECK_INTERVAL))) {
+                settled = clock::now() + this->debounce;
+            }
+        }
+        if (this->stopping) {
+            break;
+        }
+
+        try {
+            this->callback();
+        } catch (const std::exception& ex) {
+            LOGE << "[OHL] Exception occured while handling mod folder changes: " << ex.what();
+        }
+    }
+}
+
+TEST_CASE("watcher::watcher - debouncing") {
+    static const std::chrono::milliseconds INTERVAL{5};
+    static const std::chrono::milliseconds DEBOUNCE{250};
+    static const std::chrono::milliseconds BURST_GAP{10};
+    static const std::chrono::milliseconds CHANGE_TIMEOUT{5000};
+
+    const auto dir = std::filesystem::temp_directory_path() / "ohl_watcher_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    auto write_file = [&](const std::string& contents) {
+        std::ofstream out{dir / "mod.txt", std::ios::binary | std::ios::trunc};
+        out << contents;
+    };
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<size_t> call_count{0};
+    auto wait_for_calls = [&](size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, CHANGE_TIMEOUT, [&]() { return call_count >= count; });
+    };
+
+    {
+        watcher watcher{std::make_unique<polling_backend>(dir, INTERVAL),
+                        [&]() {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            call_count++;
+                            cv.notify_all();
+                        },
+                        DEBOUNCE};
+
+        // Nothing's changed yet
+        std::this_thread::sleep_for(DEBOUNCE * 2);
+        CHECK(call_count == 0);
+
+        // A whole burst of saves should only run the callback once
+        std::string contents{};
+        for (auto i = 0; i < 10; i++) {
+            contents += "x";
+            write_file(contents);
+            std::this_thread::sleep_for(BURST_GAP);
+        }
+        CHECK(wait_for_calls(1));
+        std::this_thread::sleep_for(DEBOUNCE * 2);
+        CHECK(call_count == 1);
+
+        write_file("single save");
+        CHECK(wait_for_calls(2));
+        std::this_thread::sleep_for(DEBOUNCE * 2);
+        CHECK(call_count == 2);
+    }
+
+    // After the watcher's been destroyed, changes should be ignored
+    write_file("after destroying");
+    std::this_thread::sleep_for(DEBOUNCE * 2);
+    CHECK(call_count == 2);
+
+    std::filesystem::remove_all(dir);
+}
+
+#pragma endregion
+
+TEST_SUITE_END();
+}  // namespace ohl::watcher
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <pch.h>
+
+namespace ohl::watcher {
+
+/**
+ * @brief Interface for the platform specific way of noticing changes in a folder.
+ */
+class backend {
+   public:
+    virtual ~backend() = default;
+
+    /**
+     * @brief Waits for something in the watched folder to change.
+     * @note Changes which happen while not waiting are still picked up by the next call.
+     *
+     * @param timeout The maximum time to wait.
+     * @return True if something changed, false if the timeout expired first.
+     */
+    virtual bool wait(std::chrono::milliseconds timeout) = 0;
+};
+
+/**
+ * @brief Backend using native change notifications.
+ * @note Throws a runtime error if notifications can't be created for the folder.
+ */
+class native_backend : public backend {
+   private:
+    HANDLE handle;
+
+   public:
+    native_backend(const std::filesystem::path& dir);
+    ~native_backend();
+
+    native_backend(const native_backend&) = delete;
+    native_backend& operator=(const native_backend&) = delete;
+
+    bool wait(std::chrono::milliseconds timeout) override;
+};
+
+/**
+ * @brief Backend which periodically lists the folder, and compares file sizes and times.
+ * @note Works anywhere, including on network drives which don't support notifications.
+ */
+class polling_backend : public backend {
+   public:
+    using listing = std::map<std::filesystem::path,
+                             std::pair<uintmax_t, std::filesystem::file_time_type>>;
+
+   private:
+    std::filesystem::path dir;
+    std::chrono::milliseconds interval;
+    std::chrono::steady_clock::time_point next_poll;
+    listing last_listing;
+
+   public:
+    static constexpr std::chrono::milliseconds DEFAULT_INTERVAL{1000};
+
+    polling_backend(const std::filesystem::path& dir,
+                    std::chrono::milliseconds interval = DEFAULT_INTERVAL);
+
+    bool wait(std::chrono::milliseconds timeout) override;
+};
+
+/**
+ * @brief Creates the best backend available for a folder.
+ * @note Prefers native notifications, falling back to polling if they're not supported.
+ *
+ * @param dir The folder to watch.
+ * @return The new backend.
+ */
+std::unique_ptr<backend> create_backend(const std::filesystem::path& dir);
+
+/**
+ * @brief Watches a folder on a background thread, running a callback after it changes.
+ * @note The callback is only run once changes have stopped for the debounce time, so a burst of
+ *       saves only runs it once. It's always run on the watcher thread, so never overlaps itself.
+ */
+class watcher {
+   private:
+    std::unique_ptr<ohl::watcher::backend> backend;
+    std::function<void(void)> callback;
+    std::chrono::milliseconds debounce;
+    std::atomic<bool> stopping;
+    std::thread thread;
+
+    /**
+     * @brief Main loop of the watcher thread.
+     */
+    void run(void);
+
+   public:
+    static constexpr std::chrono::milliseconds DEFAULT_DEBOUNCE{500};
+
+    watcher(std::unique_ptr<ohl::watcher::backend> backend,
+            std::function<void(void)> callback,
+            std::chrono::milliseconds debounce = DEFAULT_DEBOUNCE);
+
+    /**
+     * @brief Stops watching, waiting for any running callback to finish.
+     */
+    ~watcher();
+
+    watcher(const watcher&) = delete;
+    watcher& operator=(const watcher&) = delete;
+};
+
+}  // namespace ohl::watcher